@@ -0,0 +1,6 @@
+// Runs the portable benchmark cases: timewallpaper_bench [file]
+#include "timewallpaper_bench.h"
+
+int main(int argc, char* argv[]) {
+    return BenchmarkSuite::runAll(argc > 1 ? argv[1] : "benchmark.json");
+}
@@ -3,7 +3,7 @@ echo Compiling TimeWallpaper v3.0 - SFML Edition...
 
 del TimeWallpaper.exe 2>nul
 
-"C:\msys64\mingw64\bin\g++.exe" -std=c++17 main.cpp -o TimeWallpaper.exe -mwindows -lsfml-graphics -lsfml-window -lsfml-system -lwininet -luser32
+"C:\msys64\mingw64\bin\g++.exe" -std=c++17 -O2 main.cpp -o TimeWallpaper.exe -mwindows -lsfml-graphics -lsfml-window -lsfml-system -lwininet -luser32
 
 if %ERRORLEVEL% EQU 0 (
     if exist TimeWallpaper.exe (
@@ -23,6 +23,7 @@ if %ERRORLEVEL% EQU 0 (
         echo Usage:
         echo   TimeWallpaper.exe       - Run fullscreen overlay
         echo   Press ESC to exit
+        echo   TimeWallpaper.exe --help for --export, --batch, --stats, --time-warp, --replay and --benchmark
         echo.
         echo Location auto-detected! Edit config.ini to customize or set backup coordinates.
         echo.
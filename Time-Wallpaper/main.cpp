@@ -1,18 +1,9 @@
 #include <Windows.h>
 #include <SFML/Graphics.hpp>
-#include <iostream>
-#include <ctime>
-#include <cmath>
-#include <string>
-#include <fstream>
-#include <vector>
-#include <algorithm>
-#include <chrono>
-#include <thread>
-#include <iomanip>
-#include <sstream>
-#include <memory>
 #include <wininet.h>
+#include "timewallpaper_core.h"
+#include "timewallpaper_bench.h"
+#include "timewallpaper_feed.h"
 
 #pragma comment(lib, "wininet.lib")
 
@@ -20,25 +11,158 @@
 HWND g_hWnd = NULL;
 bool g_justWokeUp = false;
 
-struct Color {
-    int r, g, b;
-    Color(int red = 0, int green = 0, int blue = 0) : r(red), g(green), b(blue) {}
-};
+// Posted to the power window when background network work has finished
+const UINT WM_BOOTSTRAP_READY = WM_APP + 1;
+
+// WinINet client with one long-lived session and one connection handle per
+// host. WinINet keeps the sockets behind a connection handle alive, so
+// repeated requests to a host reuse the TCP/TLS connection.
+class WinInetHttpClient : public HttpClient {
+public:
+    explicit WinInetHttpClient(int defaultTimeoutMs = 5000) : defaultTimeout(defaultTimeoutMs) {}
+
+    ~WinInetHttpClient() override {
+        for (auto& entry : connections) InternetCloseHandle(entry.second);
+        if (session) InternetCloseHandle(session);
+    }
+
+    WinInetHttpClient(const WinInetHttpClient&) = delete;
+    WinInetHttpClient& operator=(const WinInetHttpClient&) = delete;
+
+    std::string get(const std::string& url, int timeoutMs) override {
+        std::string host, path;
+        unsigned short port;
+        bool secure;
+        if (!splitHttpUrl(url, secure, host, port, path)) return "";
+
+        HINTERNET connection = connectionFor(secure, host, port);
+        if (!connection) return "";
+
+        DWORD flags = INTERNET_FLAG_RELOAD | INTERNET_FLAG_NO_CACHE_WRITE | INTERNET_FLAG_KEEP_CONNECTION;
+        if (secure) flags |= INTERNET_FLAG_SECURE;
+        HINTERNET request = HttpOpenRequestA(connection, "GET", path.c_str(), nullptr, nullptr, nullptr, flags, 0);
+        if (!request) return "";
+
+        DWORD timeout = timeoutMs > 0 ? timeoutMs : defaultTimeout;
+        setTimeouts(request, timeout);
+        requestCount++;
+
+        std::string response;
+        DWORD status = 0;
+        DWORD statusSize = sizeof(status);
+        if (HttpSendRequestA(request, nullptr, 0, nullptr, 0)
+            && HttpQueryInfoA(request, HTTP_QUERY_STATUS_CODE | HTTP_QUERY_FLAG_NUMBER, &status, &statusSize, nullptr)) {
+            // Drain the body even on errors so the connection can be reused
+            char buffer[4096];
+            DWORD bytesRead;
+            while (InternetReadFile(request, buffer, sizeof(buffer), &bytesRead) && bytesRead > 0) {
+                response.append(buffer, bytesRead);
+            }
+            if (status != 200) response.clear();
+        }
+
+        InternetCloseHandle(request);
+        return response;
+    }
 
-struct SolarTimes {
-    double sunrise_hour;
-    double sunset_hour;
-    double solar_noon_hour;
-    double civil_twilight_begin;
-    double civil_twilight_end;
-    bool valid = false;
-    std::string fetch_date;
-    std::string source; // "api", "cache", or "fallback"
+    Stats getStats() const override {
+        Stats stats;
+        stats.requests = requestCount.load();
+        stats.connectionsOpened = connectionCount.load();
+        return stats;
+    }
+
+private:
+    int defaultTimeout;
+    std::mutex mutex;
+    HINTERNET session = nullptr;
+    std::map<std::string, HINTERNET> connections; // "scheme://host:port"
+    std::atomic<long> requestCount{0};
+    std::atomic<long> connectionCount{0};
+
+    static void setTimeouts(HINTERNET handle, DWORD timeout) {
+        InternetSetOptionA(handle, INTERNET_OPTION_CONNECT_TIMEOUT, &timeout, sizeof(timeout));
+        InternetSetOptionA(handle, INTERNET_OPTION_SEND_TIMEOUT, &timeout, sizeof(timeout));
+        InternetSetOptionA(handle, INTERNET_OPTION_RECEIVE_TIMEOUT, &timeout, sizeof(timeout));
+    }
+
+    HINTERNET connectionFor(bool secure, const std::string& host, unsigned short port) {
+        std::string key = (secure ? "https://" : "http://") + host + ":" + std::to_string(port);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = connections.find(key);
+        if (it != connections.end()) return it->second;
+
+        if (!session) {
+            session = InternetOpenA("TimeWallpaper/2.0", INTERNET_OPEN_TYPE_DIRECT, nullptr, nullptr, 0);
+            if (!session) return nullptr;
+            setTimeouts(session, defaultTimeout);
+        }
+
+        HINTERNET connection = InternetConnectA(session, host.c_str(), port, nullptr, nullptr, INTERNET_SERVICE_HTTP, 0, 0);
+        if (!connection) return nullptr;
+        connectionCount++;
+        connections[key] = connection;
+        return connection;
+    }
 };
 
-struct SolarCache {
-    std::vector<SolarTimes> days; // 8 days: today + next 7 days
-    std::string last_updated;
+// The system zone, or a zone named by its Windows registry key
+// ("Pacific Standard Time"), with that zone's per-year daylight rules
+class WindowsTimeZoneProvider : public TimeZoneProvider {
+public:
+    WindowsTimeZoneProvider() {}
+    explicit WindowsTimeZoneProvider(const std::string& zoneKeyName) : keyName(zoneKeyName) {}
+
+    ZoneRules rulesForYear(int year) override {
+        TIME_ZONE_INFORMATION tzi = {};
+        if (!keyName.empty()) {
+            DYNAMIC_TIME_ZONE_INFORMATION zone;
+            if (!describeZone(keyName, zone) || !GetTimeZoneInformationForYear(static_cast<WORD>(year), &zone, &tzi)) {
+                tzi = TIME_ZONE_INFORMATION(); // unknown zone: UTC
+            }
+        } else if (!GetTimeZoneInformationForYear(static_cast<WORD>(year), NULL, &tzi)) {
+            GetTimeZoneInformation(&tzi);
+        }
+
+        ZoneRules rules;
+        rules.standardOffsetMinutes = -(tzi.Bias + tzi.StandardBias);
+        rules.daylightOffsetMinutes = -(tzi.Bias + tzi.DaylightBias);
+        rules.standardDate = toZoneDate(tzi.StandardDate);
+        rules.daylightDate = toZoneDate(tzi.DaylightDate);
+        return rules;
+    }
+
+    static bool isKnownZone(const std::string& zoneKeyName) {
+        DYNAMIC_TIME_ZONE_INFORMATION zone;
+        TIME_ZONE_INFORMATION tzi;
+        SYSTEMTIME now;
+        GetSystemTime(&now);
+        return describeZone(zoneKeyName, zone) && GetTimeZoneInformationForYear(now.wYear, &zone, &tzi);
+    }
+
+    // SiteBatch zone factory: a provider for a known key name, else null
+    static std::unique_ptr<TimeZoneProvider> forZone(const std::string& zoneKeyName) {
+        if (!isKnownZone(zoneKeyName)) return nullptr;
+        return std::make_unique<WindowsTimeZoneProvider>(zoneKeyName);
+    }
+
+private:
+    std::string keyName;
+
+    static ZoneDate toZoneDate(const SYSTEMTIME& time) {
+        return { time.wYear, time.wMonth, time.wDayOfWeek, time.wDay,
+                 time.wHour, time.wMinute, time.wSecond, time.wMilliseconds };
+    }
+
+    // Key names are plain ASCII
+    static bool describeZone(const std::string& zoneKeyName, DYNAMIC_TIME_ZONE_INFORMATION& zone) {
+        zone = DYNAMIC_TIME_ZONE_INFORMATION();
+        const size_t capacity = sizeof(zone.TimeZoneKeyName) / sizeof(zone.TimeZoneKeyName[0]);
+        if (zoneKeyName.empty() || zoneKeyName.size() >= capacity) return false;
+        for (size_t i = 0; i < zoneKeyName.size(); i++) zone.TimeZoneKeyName[i] = static_cast<WCHAR>(zoneKeyName[i]);
+        return true;
+    }
 };
 
 struct Config {
@@ -48,14 +172,312 @@ struct Config {
     int update_interval_minutes = 1;
     bool debug_mode = false;
     bool auto_detect_location = true;
+    int render_threads = 0;      // 0 = one per hardware thread
+    bool tiled_gradient = true;  // one-dither-tile-wide repeated texture instead of a full-size image
+    bool verify_with_api = false; // cross-check computed solar times against api.sunrise-sunset.org
+    std::string solar_source = "computed"; // "computed" or "api"
+    int api_deadline_ms = 10000; // overall budget for one batch of API requests
+    std::string theme_file = "";  // color theme, relative to config.ini; empty = built-in
+    std::string dither_mode = "bayer"; // "bayer" (8x8 ordered) or "blue_noise" (64x64 void-and-cluster)
+    int solar_cache_days = 30;    // days from today kept in the solar cache window (1-366)
+    int solar_max_age_days = 30;  // refetch a cached day after this many days; 0 = never
+    std::string log_level = "info"; // debug, info, warn, error or off
+    int log_max_kb = 1024;        // log.txt size that triggers rotation; 0 = never rotate
+    int log_keep = 5;             // compressed rotated logs to keep
+};
+
+// Publishes the live color to other processes through a named shared-memory
+// section laid out as in timewallpaper_feed.h. Readers map it once, after
+// which every read is a seqlock copy with no locks or system calls.
+class ColorFeed {
+public:
+    ColorFeed() {}
+    ~ColorFeed() { close(); }
+
+    ColorFeed(const ColorFeed&) = delete;
+    ColorFeed& operator=(const ColorFeed&) = delete;
+
+    // Fails if the section cannot be created or another instance already owns it
+    bool open() {
+        mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, sizeof(twf_feed), TWF_MAPPING_NAME);
+        if (!mapping) return false;
+        if (GetLastError() == ERROR_ALREADY_EXISTS) {
+            // The feed allows a single writer
+            close();
+            return false;
+        }
+        view = static_cast<twf_feed*>(MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(twf_feed)));
+        if (!view) {
+            close();
+            return false;
+        }
+        twf_init(view);
+        return true;
+    }
+
+    bool isOpen() const { return view != nullptr; }
+
+    void publish(const twf_snapshot& snapshot) {
+        if (view) twf_publish(view, &snapshot);
+    }
+
+    void close() {
+        if (view) UnmapViewOfFile(view);
+        if (mapping) CloseHandle(mapping);
+        view = nullptr;
+        mapping = NULL;
+    }
+
+    static void copyName(char (&target)[TWF_NAME_SIZE], const char* name) {
+        strncpy(target, name, TWF_NAME_SIZE - 1);
+        target[TWF_NAME_SIZE - 1] = '\0';
+    }
+
+private:
+    HANDLE mapping = NULL;
+    twf_feed* view = nullptr;
+};
+
+// Fixed-bucket latency histogram over nanoseconds: four sub-buckets per
+// power of two, so reported percentiles are within 25% of the true value
+// and recording is a couple of integer operations.
+class LatencyHistogram {
+public:
+    static constexpr int kBuckets = 248; // covers every int64 nanosecond value
+
+    void record(int64_t nanoseconds) {
+        uint64_t value = nanoseconds > 0 ? static_cast<uint64_t>(nanoseconds) : 0;
+        counts[bucketFor(value)]++;
+        total++;
+        maxValue = std::max(maxValue, value);
+    }
+
+    uint64_t count() const { return total; }
+    uint64_t max() const { return maxValue; }
+
+    // Upper bound of the bucket holding the given quantile (0..1)
+    uint64_t percentile(double quantile) const {
+        if (total == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(std::ceil(quantile * total));
+        if (rank == 0) rank = 1;
+        uint64_t seen = 0;
+        for (int bucket = 0; bucket < kBuckets; bucket++) {
+            seen += counts[bucket];
+            if (seen >= rank) return std::min(upperBound(bucket), maxValue);
+        }
+        return maxValue;
+    }
+
+private:
+    uint64_t counts[kBuckets] = {};
+    uint64_t total = 0;
+    uint64_t maxValue = 0;
+
+    static int bucketFor(uint64_t value) {
+        if (value < 4) return static_cast<int>(value);
+        int highBit = 63 - __builtin_clzll(value);
+        int subBucket = static_cast<int>((value >> (highBit - 2)) & 3);
+        return (highBit - 1) * 4 + subBucket;
+    }
+
+    static uint64_t upperBound(int bucket) {
+        if (bucket < 4) return static_cast<uint64_t>(bucket);
+        int highBit = bucket / 4 + 1;
+        uint64_t width = 1ULL << (highBit - 2);
+        return ((4 + static_cast<uint64_t>(bucket % 4)) << (highBit - 2)) + width - 1;
+    }
+};
+
+// Per-stage timings for the main loop. Disabled unless --stats is given;
+// when disabled, start() returns without reading the clock and stop() is a
+// single branch. Only the main thread records.
+class FrameStats {
+public:
+    enum Stage {
+        STAGE_LOOP,     // one loop iteration, excluding the wait
+        STAGE_EVENTS,   // SFML and Windows message pumping
+        STAGE_COLOR,    // schedule lookups for the frame
+        STAGE_RASTER,   // gradient rasterization, only when a monitor is stale
+        STAGE_UPLOAD,   // texture uploads, only when a monitor is stale
+        STAGE_DISPLAY,  // clear/draw/display for all windows
+        STAGE_ACCENT,   // Windows accent color update
+        STAGE_CACHE_IO, // solar cache load/save
+        STAGE_COUNT
+    };
+
+    // Times a scope into one stage
+    class Scope {
+    public:
+        Scope(FrameStats& frameStats, Stage timedStage) : stats(frameStats), stage(timedStage), begin(frameStats.start()) {}
+        ~Scope() { stats.stop(stage, begin); }
+
+    private:
+        FrameStats& stats;
+        Stage stage;
+        int64_t begin;
+    };
+
+    void enable(const std::string& path) {
+        enabled = true;
+        dumpPath = path;
+    }
+
+    bool isEnabled() const { return enabled; }
+
+    int64_t start() const { return enabled ? nowNanoseconds() : 0; }
+
+    void stop(Stage stage, int64_t begin) {
+        if (enabled) histograms[stage].record(nowNanoseconds() - begin);
+    }
+
+    std::string summary() const {
+        static const char* const stageNames[STAGE_COUNT] = {
+            "loop", "events", "color", "raster", "upload", "display", "accent", "cache_io"
+        };
+
+        std::stringstream out;
+        out << std::left << std::setw(10) << "stage" << std::right << std::setw(10) << "count"
+            << std::setw(12) << "p50 us" << std::setw(12) << "p95 us" << std::setw(12) << "p99 us"
+            << std::setw(12) << "max us" << "\n";
+        out << std::fixed << std::setprecision(1);
+        for (int stage = 0; stage < STAGE_COUNT; stage++) {
+            const LatencyHistogram& h = histograms[stage];
+            out << std::left << std::setw(10) << stageNames[stage] << std::right << std::setw(10) << h.count()
+                << std::setw(12) << h.percentile(0.50) / 1000.0 << std::setw(12) << h.percentile(0.95) / 1000.0
+                << std::setw(12) << h.percentile(0.99) / 1000.0 << std::setw(12) << h.max() / 1000.0 << "\n";
+        }
+        return out.str();
+    }
+
+    // Rewrites the dump file with the totals so far
+    bool dump() const {
+        std::ofstream file(dumpPath);
+        if (!file.is_open()) return false;
+        file << summary();
+        return true;
+    }
+
+    const std::string& getDumpPath() const { return dumpPath; }
+
+private:
+    bool enabled = false;
+    std::string dumpPath;
+    LatencyHistogram histograms[STAGE_COUNT];
+
+    static int64_t nowNanoseconds() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
+
+// Solar cache file in the SolarCacheCodec layout. Loading maps the file
+// read-only and decodes the view; saving writes a temp file and renames it
+// over the old one so a crash never leaves a half-written cache.
+class SolarCacheFile : public SolarCacheCodec {
+public:
+    static bool load(const std::string& path, SolarCache& cache) {
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE) return false;
+
+        bool ok = false;
+        LARGE_INTEGER size;
+        if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+            HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+            if (mapping) {
+                const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+                if (view) {
+                    ok = decode(view, static_cast<size_t>(size.QuadPart), cache);
+                    UnmapViewOfFile(view);
+                }
+                CloseHandle(mapping);
+            }
+        }
+        CloseHandle(file);
+        return ok;
+    }
+
+    static bool save(const std::string& path, const SolarCache& cache) {
+        std::string tempPath = path + ".tmp";
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) return false;
+            std::string bytes = encode(cache);
+            out.write(bytes.data(), bytes.size());
+            out.flush();
+            if (!out) return false;
+        }
+        return MoveFileExA(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+    }
+};
+
+// Writes the DWM accent registry values and broadcasts the change. Each
+// broadcast can wait up to a second per hung top-level window.
+class RegistryAccentSink : public AccentSink {
+public:
+    void apply(const Color& accentColor) override {
+        // Format the color as ABGR DWORD (Windows format)
+        DWORD colorValue = 0xFF000000 | (accentColor.b << 16) | (accentColor.g << 8) | accentColor.r;
+
+        // Update registry directly without restarting explorer
+        HKEY hKey;
+
+        // Set DWM accent color
+        if (RegOpenKeyExA(HKEY_CURRENT_USER, "SOFTWARE\\Microsoft\\Windows\\DWM", 0, KEY_SET_VALUE, &hKey) == ERROR_SUCCESS) {
+            RegSetValueExA(hKey, "AccentColor", 0, REG_DWORD, (const BYTE*)&colorValue, sizeof(DWORD));
+            RegSetValueExA(hKey, "ColorizationColor", 0, REG_DWORD, (const BYTE*)&colorValue, sizeof(DWORD));
+            RegSetValueExA(hKey, "ColorizationAfterglow", 0, REG_DWORD, (const BYTE*)&colorValue, sizeof(DWORD));
+            RegSetValueExA(hKey, "AccentColorMenu", 0, REG_DWORD, (const BYTE*)&colorValue, sizeof(DWORD));
+
+            // Create accent palette (8 color variations)
+            BYTE palette[32];
+            for (int i = 0; i < 8; i++) {
+                int factor = 100 + (i - 4) * 10;
+                palette[i * 4 + 0] = std::min(255, std::max(0, (accentColor.r * factor) / 100));
+                palette[i * 4 + 1] = std::min(255, std::max(0, (accentColor.g * factor) / 100));
+                palette[i * 4 + 2] = std::min(255, std::max(0, (accentColor.b * factor) / 100));
+                palette[i * 4 + 3] = 255;
+            }
+            RegSetValueExA(hKey, "AccentPalette", 0, REG_BINARY, palette, 32);
+
+            RegCloseKey(hKey);
+        }
+
+        // Notify system of color change
+        SendMessageTimeout(HWND_BROADCAST, WM_DWMCOLORIZATIONCOLORCHANGED, colorValue, 0, SMTO_ABORTIFHUNG, 1000, nullptr);
+        SendMessageTimeout(HWND_BROADCAST, WM_SETTINGCHANGE, 0, (LPARAM)"ImmersiveColorSet", SMTO_ABORTIFHUNG, 1000, nullptr);
+    }
 };
 
 class TimeWallpaper {
 private:
+    // Declared first so it outlives every member that logs while shutting down
+    AsyncLogger logger;
+
+    // Inputs the rasterized gradient depends on; a matching key means the
+    // persistent texture already holds the right pixels
+    struct GradientKey {
+        Color bottom, top;
+        int width = 0, height = 0;
+
+        bool operator==(const GradientKey& other) const {
+            return bottom == other.bottom && top == other.top
+                && width == other.width && height == other.height;
+        }
+    };
+
     struct MonitorWindow {
         std::unique_ptr<sf::RenderWindow> window;
         sf::Sprite watermarkSprite;
         int x, y, width, height;
+
+        // Persistent gradient, re-rasterized only when its key changes.
+        // In tiled mode the buffer is one dither tile wide and the texture repeats.
+        std::vector<sf::Uint8> gradientPixels;
+        int gradientWidth = 0;
+        sf::Texture gradientTexture;
+        sf::Sprite gradientSprite;
+        GradientKey gradientKey;
+        bool hasGradient = false;
     };
 
     Config config;
@@ -63,17 +485,41 @@ private:
     sf::Texture watermarkTexture;
     bool hasWatermark;
     time_t lastAccentColorUpdate;
+    unsigned long renderCacheHits;
+    unsigned long renderCacheMisses;
+    std::unique_ptr<WorkStealingPool> rasterPool;
+    const DitherPattern* ditherPattern = nullptr;
+    SystemTimeSource systemClock;
+    std::unique_ptr<SimulatedTimeSource> simulatedClock; // set for --time-warp and --replay
+    const TimeSource* clock;
+    HANDLE wakeTimer;
+    unsigned long wakeupCount;
+
+    std::chrono::steady_clock::time_point startupTime;
+    std::thread bootstrapThread;
+    std::mutex bootstrapMutex;
+    bool bootstrapReady = false;
+    bool bootstrapBusy = false;            // main thread only: a job is running or not yet applied
+    std::vector<long long> pendingApiDays; // main thread only: API days for the next job
+    SolarTimes pendingCrossCheck;          // main thread only: computed day to check, if valid
+
+    // Rows per raster task; small enough to balance, large enough to amortize dispatch
+    static constexpr int kRasterBandRows = 64;
+
+    FrameStats frameStats;
+    static constexpr int kStatsDumpIntervalSeconds = 60;
 
-    struct ColorPoint {
-        double hour;
-        Color color;
-        std::string period;
-    };
-
-    std::vector<ColorPoint> todaysColors;
     SolarTimes todaysSolarTimes;
+    ColorSchedule colorSchedule;
+    std::string themePath;
+    uint64_t themeWriteTime = 0;
     SolarCache solarCache;
     std::string lastFetchDate;
+    TimeZoneTable timeZone{std::make_unique<WindowsTimeZoneProvider>()};
+    std::shared_ptr<HttpClient> http = std::make_shared<WinInetHttpClient>();
+    ConcurrentFetcher fetcher; // joins its workers before http is released
+    AccentWorker accentWorker; // discards colors during simulated runs
+    ColorFeed colorFeed;
     std::string currentPeriodCache;
 
     static BOOL CALLBACK MonitorEnumProc(HMONITOR hMonitor, HDC hdcMonitor, LPRECT lprcMonitor, LPARAM dwData) {
@@ -95,15 +541,40 @@ private:
     }
 
 public:
-    TimeWallpaper() : hasWatermark(false), lastAccentColorUpdate(0) {
+    explicit TimeWallpaper(std::unique_ptr<SimulatedTimeSource> simulated = nullptr)
+        : hasWatermark(false), lastAccentColorUpdate(0), renderCacheHits(0), renderCacheMisses(0),
+          simulatedClock(std::move(simulated)), clock(simulatedClock ? simulatedClock.get() : &systemClock),
+          wakeTimer(NULL), wakeupCount(0), startupTime(std::chrono::steady_clock::now()),
+          accentWorker(simulatedClock ? std::unique_ptr<AccentSink>(std::make_unique<NullAccentSink>())
+                                      : std::make_unique<RegistryAccentSink>()) {
         std::cout << "Initializing TimeWallpaper..." << std::endl;
 
-        loadConfig();
+        // Simulated runs start from a cold cache of their own so they are repeatable
+        // and never overwrite the real one with simulated dates
+        if (simulatedClock) std::remove(getSolarCachePath().c_str());
 
-        if (config.auto_detect_location) {
-            autoDetectLocation();
+        loadConfig();
+        startLogger();
+        loadTheme();
+
+        int renderThreads = config.render_threads > 0
+            ? config.render_threads
+            : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        rasterPool = std::make_unique<WorkStealingPool>(renderThreads);
+
+        // Build the blue-noise tile now rather than on the first frame
+        ditherPattern = config.dither_mode == "blue_noise" ? &DitherPattern::blueNoise() : &DitherPattern::bayer();
+
+        // Shared-memory feed of the live color for other local tools; a
+        // simulated run must not show other tools simulated colors
+        if (simulatedClock) {
+            logMessage("Color feed not published during a simulated run");
+        } else if (!colorFeed.open()) {
+            std::cout << "Color feed not published (another instance may be running)" << std::endl;
+            logMessage("Color feed not published");
         }
 
+        // Location detection runs in the background from run(); start from the last known location
         // Load existing solar cache
         loadSolarCache();
 
@@ -128,7 +599,10 @@ public:
                 "TimeWallpaper",
                 sf::Style::None
             );
-            m.window->setFramerateLimit(60);
+            // Simulated runs present frames as fast as the clock steps; a
+            // frame limit or vsync would pace them at real-time speed
+            m.window->setFramerateLimit(simulatedClock ? 0 : 60);
+            m.window->setVerticalSyncEnabled(false);
             m.window->setPosition(sf::Vector2i(m.x, m.y));
 
             // Hide from taskbar by setting as a tool window
@@ -157,17 +631,30 @@ public:
         std::cout << "Location: " << config.location_name << " (" << config.latitude << ", " << config.longitude << ")" << std::endl;
         std::cout << "Update interval: " << config.update_interval_minutes << " minute(s)" << std::endl;
         std::cout << "Monitors: " << monitors.size() << std::endl;
-        std::cout << "Solar cache: " << getSolarCachePath() << " (8-day storage)" << std::endl;
+        std::cout << "Render threads: " << rasterPool->getThreadCount() << std::endl;
+        std::cout << "Solar cache: " << getSolarCachePath() << " (" << solarWindowDays() << "-day window)" << std::endl;
+        if (simulatedClock) {
+            std::cout << "Simulated clock: starting " << formatTimePoint(simulatedClock->getStart()) << ", "
+                      << (simulatedClock->isStepped() ? std::string("stepping deadline to deadline")
+                                                      : std::to_string(simulatedClock->getFactor()) + "x real time")
+                      << std::endl;
+        }
 
-        logMessage("TimeWallpaper v3.0 - SFML Edition (8-Day Cache)");
+        logMessage("TimeWallpaper v3.0 - SFML Edition");
         logMessage("=================================================");
         logMessage("Location: " + config.location_name + " (" + std::to_string(config.latitude) + ", " + std::to_string(config.longitude) + ")");
         logMessage("Update interval: " + std::to_string(config.update_interval_minutes) + " minute(s)");
         logMessage("Monitors: " + std::to_string(monitors.size()));
-        logMessage("Solar cache: " + getSolarCachePath() + " (8-day storage)");
+        logMessage("Solar cache: " + getSolarCachePath() + " (" + std::to_string(solarWindowDays()) + "-day window)");
     }
 
     ~TimeWallpaper() {
+        if (bootstrapThread.joinable()) {
+            bootstrapThread.join();
+        }
+        if (wakeTimer) {
+            CloseHandle(wakeTimer);
+        }
         for (auto& m : monitors) {
             if (m.window && m.window->isOpen()) {
                 m.window->close();
@@ -175,60 +662,15 @@ public:
         }
     }
     
+    // Queues the accent color for this background; the registry writes and
+    // broadcasts happen on accentWorker, never on the render thread
     void setWindowsAccentColor(const Color& bgColor) {
-        // Determine brightness to decide whether to blend with black or white
-        int brightness = (bgColor.r + bgColor.g + bgColor.b) / 3;
-
-        Color accentColor;
-        float blendAmount = 0.15f; // 15% opacity overlay
-
-        if (brightness > 128) {
-            // Light background - overlay black at 15% opacity
-            accentColor.r = (unsigned char)(bgColor.r * (1.0f - blendAmount));
-            accentColor.g = (unsigned char)(bgColor.g * (1.0f - blendAmount));
-            accentColor.b = (unsigned char)(bgColor.b * (1.0f - blendAmount));
-        } else {
-            // Dark background - overlay white at 15% opacity
-            accentColor.r = (unsigned char)(bgColor.r * (1.0f - blendAmount) + 255 * blendAmount);
-            accentColor.g = (unsigned char)(bgColor.g * (1.0f - blendAmount) + 255 * blendAmount);
-            accentColor.b = (unsigned char)(bgColor.b * (1.0f - blendAmount) + 255 * blendAmount);
-        }
-
-        // Format the color as ABGR DWORD (Windows format)
-        DWORD colorValue = 0xFF000000 | (accentColor.b << 16) | (accentColor.g << 8) | accentColor.r;
-
-        // Update registry directly without restarting explorer
-        HKEY hKey;
-
-        // Set DWM accent color
-        if (RegOpenKeyExA(HKEY_CURRENT_USER, "SOFTWARE\\Microsoft\\Windows\\DWM", 0, KEY_SET_VALUE, &hKey) == ERROR_SUCCESS) {
-            RegSetValueExA(hKey, "AccentColor", 0, REG_DWORD, (const BYTE*)&colorValue, sizeof(DWORD));
-            RegSetValueExA(hKey, "ColorizationColor", 0, REG_DWORD, (const BYTE*)&colorValue, sizeof(DWORD));
-            RegSetValueExA(hKey, "ColorizationAfterglow", 0, REG_DWORD, (const BYTE*)&colorValue, sizeof(DWORD));
-            RegSetValueExA(hKey, "AccentColorMenu", 0, REG_DWORD, (const BYTE*)&colorValue, sizeof(DWORD));
-
-            // Create accent palette (8 color variations)
-            BYTE palette[32];
-            for (int i = 0; i < 8; i++) {
-                int factor = 100 + (i - 4) * 10;
-                palette[i * 4 + 0] = std::min(255, std::max(0, (accentColor.r * factor) / 100));
-                palette[i * 4 + 1] = std::min(255, std::max(0, (accentColor.g * factor) / 100));
-                palette[i * 4 + 2] = std::min(255, std::max(0, (accentColor.b * factor) / 100));
-                palette[i * 4 + 3] = 255;
-            }
-            RegSetValueExA(hKey, "AccentPalette", 0, REG_BINARY, palette, 32);
-
-            RegCloseKey(hKey);
-        }
-
-        // Notify system of color change
-        SendMessageTimeout(HWND_BROADCAST, WM_DWMCOLORIZATIONCOLORCHANGED, colorValue, 0, SMTO_ABORTIFHUNG, 1000, nullptr);
-        SendMessageTimeout(HWND_BROADCAST, WM_SETTINGCHANGE, 0, (LPARAM)"ImmersiveColorSet", SMTO_ABORTIFHUNG, 1000, nullptr);
-
-        logMessage("Accent color updated: RGB(" + std::to_string(accentColor.r) + ", " + std::to_string(accentColor.g) + ", " + std::to_string(accentColor.b) + ")");
+        Color accentColor = accentColorFor(bgColor);
+        accentWorker.submit(accentColor);
+        logger.log(AsyncLogger::LOG_INFO, "Accent color queued: RGB({}, {}, {})", accentColor.r, accentColor.g, accentColor.b);
     }
 
-    std::string getConfigPath() {
+    static std::string getConfigPath() {
         // Get the directory where the executable is located
         char exePath[MAX_PATH];
         GetModuleFileNameA(NULL, exePath, MAX_PATH);
@@ -253,7 +695,15 @@ public:
     }
     
     void loadConfig() {
-        std::string configPath = getConfigPath();
+        if (readConfigFile(getConfigPath(), config)) {
+            if (config.debug_mode) logMessage("Config loaded from config.ini");
+        } else {
+            createDefaultConfig();
+        }
+    }
+
+    // Reads key=value settings over the values already in target
+    static bool readConfigFile(const std::string& configPath, Config& target) {
         std::ifstream configFile(configPath);
         if (configFile.is_open()) {
             std::string line;
@@ -271,19 +721,30 @@ public:
                     value.erase(0, value.find_first_not_of(" \t"));
                     value.erase(value.find_last_not_of(" \t") + 1);
                     
-                    if (key == "latitude") config.latitude = std::stod(value);
-                    else if (key == "longitude") config.longitude = std::stod(value);
-                    else if (key == "location_name") config.location_name = value;
-                    else if (key == "update_interval_minutes") config.update_interval_minutes = std::stoi(value);
-                    else if (key == "debug_mode") config.debug_mode = (value == "true");
-                    else if (key == "auto_detect_location") config.auto_detect_location = (value == "true");
+                    if (key == "latitude") target.latitude = std::stod(value);
+                    else if (key == "longitude") target.longitude = std::stod(value);
+                    else if (key == "location_name") target.location_name = value;
+                    else if (key == "update_interval_minutes") target.update_interval_minutes = std::stoi(value);
+                    else if (key == "debug_mode") target.debug_mode = (value == "true");
+                    else if (key == "auto_detect_location") target.auto_detect_location = (value == "true");
+                    else if (key == "render_threads") target.render_threads = std::stoi(value);
+                    else if (key == "tiled_gradient") target.tiled_gradient = (value == "true");
+                    else if (key == "verify_with_api") target.verify_with_api = (value == "true");
+                    else if (key == "solar_source") target.solar_source = value;
+                    else if (key == "api_deadline_ms") target.api_deadline_ms = std::stoi(value);
+                    else if (key == "theme_file") target.theme_file = value;
+                    else if (key == "dither_mode") target.dither_mode = value;
+                    else if (key == "solar_cache_days") target.solar_cache_days = std::stoi(value);
+                    else if (key == "solar_max_age_days") target.solar_max_age_days = std::stoi(value);
+                    else if (key == "log_level") target.log_level = value;
+                    else if (key == "log_max_kb") target.log_max_kb = std::stoi(value);
+                    else if (key == "log_keep") target.log_keep = std::stoi(value);
                 }
             }
             configFile.close();
-            if (config.debug_mode) logMessage("Config loaded from config.ini");
-        } else {
-            createDefaultConfig();
+            return true;
         }
+        return false;
     }
     
     void createDefaultConfig() {
@@ -295,6 +756,15 @@ public:
             configFile << "# auto_detect_location=false: Use manual coordinates below as primary location" << std::endl;
             configFile << "# Manual coordinates also serve as backup if auto-detection fails" << std::endl;
             configFile << "# Get coordinates from: https://www.latlong.net/" << std::endl;
+            configFile << "# render_threads: threads used to rasterize the gradient (0 = all cores)" << std::endl;
+            configFile << "# tiled_gradient=false: rasterize a full-size image per monitor instead of a repeated strip one dither tile wide" << std::endl;
+            configFile << "# verify_with_api=true: compare computed solar times with api.sunrise-sunset.org (needs network)" << std::endl;
+            configFile << "# solar_source=api: fetch solar times from api.sunrise-sunset.org, computing any days that miss api_deadline_ms" << std::endl;
+            configFile << "# theme_file: color theme next to this file (stop=<anchor>[+/-hours], R, G, B, <period>[, not_before=<hour>]); reloaded when it changes" << std::endl;
+            configFile << "# dither_mode: bayer (8x8 ordered) or blue_noise (64x64 tile, less visible pattern on dark gradients)" << std::endl;
+            configFile << "# solar_cache_days: days of solar times kept ahead; each daily refresh only fetches new, missing or stale days" << std::endl;
+            configFile << "# solar_max_age_days: refetch a cached day once it is this many days old (0 = never)" << std::endl;
+            configFile << "# log_level: debug, info, warn, error or off; log.txt is gzipped to log.N.gz at log_max_kb, keeping log_keep files" << std::endl;
             configFile << std::endl;
             configFile << "latitude=" << config.latitude << std::endl;
             configFile << "longitude=" << config.longitude << std::endl;
@@ -302,137 +772,223 @@ public:
             configFile << "update_interval_minutes=" << config.update_interval_minutes << std::endl;
             configFile << "debug_mode=" << (config.debug_mode ? "true" : "false") << std::endl;
             configFile << "auto_detect_location=" << (config.auto_detect_location ? "true" : "false") << std::endl;
+            configFile << "render_threads=" << config.render_threads << std::endl;
+            configFile << "tiled_gradient=" << (config.tiled_gradient ? "true" : "false") << std::endl;
+            configFile << "verify_with_api=" << (config.verify_with_api ? "true" : "false") << std::endl;
+            configFile << "solar_source=" << config.solar_source << std::endl;
+            configFile << "api_deadline_ms=" << config.api_deadline_ms << std::endl;
+            configFile << "theme_file=" << config.theme_file << std::endl;
+            configFile << "dither_mode=" << config.dither_mode << std::endl;
+            configFile << "solar_cache_days=" << config.solar_cache_days << std::endl;
+            configFile << "solar_max_age_days=" << config.solar_max_age_days << std::endl;
+            configFile << "log_level=" << config.log_level << std::endl;
+            configFile << "log_max_kb=" << config.log_max_kb << std::endl;
+            configFile << "log_keep=" << config.log_keep << std::endl;
             configFile.close();
             logMessage("Created default config.ini - location will be auto-detected!");
         }
     }
     
-    std::string httpGetWithTimeout(const std::string& url, int timeoutMs = 5000) {
-        HINTERNET hInternet = InternetOpenA("TimeWallpaper/2.0", INTERNET_OPEN_TYPE_DIRECT, nullptr, nullptr, 0);
-        if (!hInternet) return "";
-        
-        // Set timeouts
-        DWORD timeout = timeoutMs;
-        InternetSetOptionA(hInternet, INTERNET_OPTION_CONNECT_TIMEOUT, &timeout, sizeof(timeout));
-        InternetSetOptionA(hInternet, INTERNET_OPTION_SEND_TIMEOUT, &timeout, sizeof(timeout));
-        InternetSetOptionA(hInternet, INTERNET_OPTION_RECEIVE_TIMEOUT, &timeout, sizeof(timeout));
-        
-        HINTERNET hUrl = InternetOpenUrlA(hInternet, url.c_str(), nullptr, 0, 
-                                         INTERNET_FLAG_RELOAD | INTERNET_FLAG_NO_CACHE_WRITE, 0);
-        if (!hUrl) {
-            InternetCloseHandle(hInternet);
-            return "";
-        }
-        
-        std::string response;
-        char buffer[4096];
-        DWORD bytesRead;
-        
-        while (InternetReadFile(hUrl, buffer, sizeof(buffer), &bytesRead) && bytesRead > 0) {
-            response.append(buffer, bytesRead);
-        }
-        
-        InternetCloseHandle(hUrl);
-        InternetCloseHandle(hInternet);
-        return response;
+    // Transport for the fetcher; holds its own reference to the client so a
+    // worker finishing after the deadline never depends on member order
+    ConcurrentFetcher::Transport httpTransport() {
+        std::shared_ptr<HttpClient> client = http;
+        return [client](const std::string& url, int timeoutMs) { return client->get(url, timeoutMs); };
     }
     
-    bool detectLocationFromIP() {
+    // Writes the detected location into target; safe to call off the main thread
+    bool detectLocationFromIP(Config& target) {
         if (config.debug_mode) logMessage("Trying IP geolocation...");
         
-        std::string response = httpGetWithTimeout("http://ip-api.com/json/?fields=status,lat,lon,city,regionName,country", 8000);
+        std::string response = http->get("http://ip-api.com/json/?fields=status,lat,lon,city,regionName,country", 8000);
         
         if (response.empty()) {
             if (config.debug_mode) logMessage("IP geolocation failed - no response");
             return false;
         }
         
-        if (response.find("\"status\":\"success\"") == std::string::npos) {
+        // Pull the fields we need out in one scan over the response
+        std::string_view status, lat, lon, city, region;
+        bool wellFormed = JsonScanner::scan(response, [&](const JsonScanner::Member& m) {
+            if (m.depth != 0) return;
+            if (m.key == "status") status = m.value;
+            else if (m.key == "lat" && m.type == JsonScanner::JSON_NUMBER) lat = m.value;
+            else if (m.key == "lon" && m.type == JsonScanner::JSON_NUMBER) lon = m.value;
+            else if (m.key == "city" && m.type == JsonScanner::JSON_STRING) city = m.value;
+            else if (m.key == "regionName" && m.type == JsonScanner::JSON_STRING) region = m.value;
+        });
+
+        if (!wellFormed || status != "success") {
             if (config.debug_mode) logMessage("IP geolocation failed - invalid response");
             return false;
         }
-        
-        try {
-            // Parse latitude
-            size_t latPos = response.find("\"lat\":");
-            if (latPos != std::string::npos) {
-                size_t startPos = latPos + 6;
-                size_t endPos = response.find_first_of(",}", startPos);
-                if (endPos != std::string::npos) {
-                    std::string latStr = response.substr(startPos, endPos - startPos);
-                    config.latitude = std::stod(latStr);
-                }
-            }
-            
-            // Parse longitude
-            size_t lonPos = response.find("\"lon\":");
-            if (lonPos != std::string::npos) {
-                size_t startPos = lonPos + 6;
-                size_t endPos = response.find_first_of(",}", startPos);
-                if (endPos != std::string::npos) {
-                    std::string lonStr = response.substr(startPos, endPos - startPos);
-                    config.longitude = std::stod(lonStr);
-                }
-            }
-            
-            // Parse city name
-            size_t cityPos = response.find("\"city\":\"");
-            if (cityPos != std::string::npos) {
-                size_t startPos = cityPos + 8;
-                size_t endPos = response.find("\"", startPos);
-                if (endPos != std::string::npos) {
-                    std::string city = response.substr(startPos, endPos - startPos);
-                    
-                    // Also get region for better location name
-                    size_t regionPos = response.find("\"regionName\":\"");
-                    if (regionPos != std::string::npos) {
-                        size_t regionStart = regionPos + 14;
-                        size_t regionEnd = response.find("\"", regionStart);
-                        if (regionEnd != std::string::npos) {
-                            std::string region = response.substr(regionStart, regionEnd - regionStart);
-                            config.location_name = city + ", " + region;
-                        } else {
-                            config.location_name = city;
-                        }
-                    } else {
-                        config.location_name = city;
-                    }
-                }
-            }
-            
+
+        double latitude, longitude;
+        if (!JsonScanner::toDouble(lat, latitude) || !JsonScanner::toDouble(lon, longitude)
+            || latitude < -90.0 || latitude > 90.0 || longitude < -180.0 || longitude > 180.0) {
+            if (config.debug_mode) logMessage("IP geolocation failed - parsing error");
+            return false;
+        }
+
+        target.latitude = latitude;
+        target.longitude = longitude;
+        if (!city.empty()) {
+            // Also use region for better location name
+            target.location_name = JsonScanner::unescape(city);
+            if (!region.empty()) target.location_name += ", " + JsonScanner::unescape(region);
+        }
+
+        return true;
+    }
+    
+    struct BootstrapResult {
+        bool startup = false;
+        bool locationDetected = false;
+        Config location;
+        bool hasApiBatch = false;
+        SolarWindow::ApiBatch apiBatch;
+        SolarTimes crossCheck; // valid if the job checked this computed day against the API
+        ConcurrentFetcher::Result crossCheckResult;
+    };
+
+    BootstrapResult bootstrapResult;
+
+    static bool sameLocation(const Config& a, const Config& b) {
+        return std::fabs(a.latitude - b.latitude) <= 1e-4 && std::fabs(a.longitude - b.longitude) <= 1e-4;
+    }
+
+    // Slow network work, kept off the render thread: at startup, IP
+    // geolocation; then, in api mode, the solar days the cache needs for the
+    // resolved location (the whole window if it moved), and the API's times
+    // for a computed day when verify_with_api asks for a cross-check. Runs on
+    // bootstrapThread and only touches its own result until it is handed to
+    // the main loop.
+    void runBootstrap(Config location, bool startup, std::vector<long long> apiDays, SolarTimes crossCheck,
+                      long long today, int windowDays) {
+        BootstrapResult result;
+        result.startup = startup;
+        result.location = location;
+
+        if (startup && location.auto_detect_location) {
+            if (location.debug_mode) logMessage("Auto-detecting location...");
+            result.locationDetected = detectLocationFromIP(result.location);
+            if (!result.locationDetected && location.debug_mode) logMessage("All location detection methods failed");
+        } else if (startup && location.debug_mode) {
+            logMessage("Auto-detection disabled in config");
+        }
+
+        if (result.locationDetected && !sameLocation(result.location, location)) {
+            apiDays.clear();
+            for (int offset = 0; offset < windowDays; offset++) apiDays.push_back(today + offset);
+        }
+
+        if (location.solar_source == "api" && !apiDays.empty()) {
+            result.apiBatch = solarWindowFor(result.location).fetch(fetcher, apiDays, location.api_deadline_ms, httpTransport());
+            result.hasApiBatch = true;
+        }
+
+        long long crossCheckDay;
+        if (crossCheck.valid && SolarCache::parseDay(crossCheck.fetch_date, crossCheckDay)) {
+            std::string url = SolarWindow::apiUrl(location.latitude, location.longitude, crossCheckDay);
+            result.crossCheckResult = fetcher.fetchAll({ url }, location.api_deadline_ms, httpTransport())[0];
+            result.crossCheck = crossCheck;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(bootstrapMutex);
+            bootstrapResult = std::move(result);
+            bootstrapReady = true;
+        }
+        if (g_hWnd) PostMessageA(g_hWnd, WM_BOOTSTRAP_READY, 0, 0);
+    }
+
+    // Swaps in the refined location and schedule once the bootstrap has finished.
+    // Returns true if today's solar times changed.
+    bool applyBootstrapResult() {
+        BootstrapResult result;
+        {
+            std::lock_guard<std::mutex> lock(bootstrapMutex);
+            if (!bootstrapReady) return false;
+            bootstrapReady = false;
+            result = std::move(bootstrapResult);
+        }
+        bootstrapBusy = false;
+
+        if (result.crossCheck.valid) logCrossCheck(result.crossCheck, result.crossCheckResult);
+
+        bool locationChanged = false;
+        if (result.locationDetected) {
+            locationChanged = !sameLocation(result.location, config);
+            config.latitude = result.location.latitude;
+            config.longitude = result.location.longitude;
+            config.location_name = result.location.location_name;
+            saveLocationToConfig();
+
             if (config.debug_mode) {
                 logMessage("IP geolocation successful:");
                 logMessage("  Location: " + config.location_name);
                 logMessage("  Coordinates: " + std::to_string(config.latitude) + ", " + std::to_string(config.longitude));
             }
-            
-            return true;
-            
-        } catch (...) {
-            if (config.debug_mode) logMessage("IP geolocation failed - parsing error");
-            return false;
         }
+
+        SolarTimes previous = todaysSolarTimes;
+        if (locationChanged || result.hasApiBatch) {
+            // Cached days belong to the old location; the API batch fills the days that were needed
+            if (locationChanged) solarCache.invalidate();
+            refreshSolarWindow(result.hasApiBatch ? &result : nullptr);
+            SolarTimes* todaysData = solarCache.find(getCurrentDay());
+            if (todaysData && todaysData->valid) {
+                todaysSolarTimes = *todaysData;
+            }
+        } else {
+            fetchSolarTimes();
+        }
+
+        if (result.startup) {
+            logMessage("Bootstrap finished after " + std::to_string(millisecondsSinceStartup()) + " ms"
+                       + (locationChanged ? " - location changed to " + config.location_name : ""));
+        }
+
+        // Work queued while this job ran
+        startBackgroundWork();
+
+        return previous.sunrise_hour != todaysSolarTimes.sunrise_hour
+            || previous.sunset_hour != todaysSolarTimes.sunset_hour
+            || previous.solar_noon_hour != todaysSolarTimes.solar_noon_hour;
     }
-    
-    bool autoDetectLocation() {
-        if (!config.auto_detect_location) {
-            if (config.debug_mode) logMessage("Auto-detection disabled in config");
-            return false;
-        }
-        
-        if (config.debug_mode) logMessage("Auto-detecting location...");
-        
-        // Try IP geolocation first (most reliable)
-        if (detectLocationFromIP()) {
-            saveLocationToConfig();
-            return true;
+
+    // Adds days to the next background job's API batch
+    void queueApiDays(const std::vector<long long>& days) {
+        for (long long day : days) {
+            if (std::find(pendingApiDays.begin(), pendingApiDays.end(), day) == pendingApiDays.end()) pendingApiDays.push_back(day);
         }
-        
-        if (config.debug_mode) logMessage("All location detection methods failed");
-        return false;
     }
-    
+
+    // Starts queued network work on bootstrapThread, unless the previous job
+    // is still running or waiting to be applied; applyBootstrapResult starts
+    // it then. Only the startup job runs with nothing queued.
+    void startBackgroundWork(bool startup = false) {
+        if (bootstrapBusy || (!startup && pendingApiDays.empty() && !pendingCrossCheck.valid)) return;
+        if (bootstrapThread.joinable()) bootstrapThread.join();
+
+        std::vector<long long> apiDays;
+        apiDays.swap(pendingApiDays);
+        SolarTimes crossCheck = pendingCrossCheck;
+        pendingCrossCheck = SolarTimes();
+        bootstrapBusy = true;
+        bootstrapThread = std::thread(&TimeWallpaper::runBootstrap, this, config, startup, apiDays, crossCheck,
+                                      getCurrentDay(), solarWindowDays());
+    }
+
+    long millisecondsSinceStartup() {
+        return static_cast<long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - startupTime).count());
+    }
+
     void saveLocationToConfig() {
+        // Simulated runs leave the user's config.ini as they found it
+        if (simulatedClock) return;
+
         // Update the config file with detected location
         std::string configPath = getConfigPath();
         std::ofstream configFile(configPath);
@@ -448,146 +1004,136 @@ public:
             configFile << "update_interval_minutes=" << config.update_interval_minutes << std::endl;
             configFile << "debug_mode=" << (config.debug_mode ? "true" : "false") << std::endl;
             configFile << "auto_detect_location=" << (config.auto_detect_location ? "true" : "false") << std::endl;
+            configFile << "render_threads=" << config.render_threads << std::endl;
+            configFile << "tiled_gradient=" << (config.tiled_gradient ? "true" : "false") << std::endl;
+            configFile << "verify_with_api=" << (config.verify_with_api ? "true" : "false") << std::endl;
+            configFile << "solar_source=" << config.solar_source << std::endl;
+            configFile << "api_deadline_ms=" << config.api_deadline_ms << std::endl;
+            configFile << "theme_file=" << config.theme_file << std::endl;
+            configFile << "dither_mode=" << config.dither_mode << std::endl;
+            configFile << "solar_cache_days=" << config.solar_cache_days << std::endl;
+            configFile << "solar_max_age_days=" << config.solar_max_age_days << std::endl;
+            configFile << "log_level=" << config.log_level << std::endl;
+            configFile << "log_max_kb=" << config.log_max_kb << std::endl;
+            configFile << "log_keep=" << config.log_keep << std::endl;
             configFile.close();
             
             if (config.debug_mode) logMessage("Location saved to config.ini");
         }
     }
     
-    double parseTimeString(const std::string& timeStr) {
-        if (timeStr.length() < 19) return 0.0;
-        
-        std::string timeOnly = timeStr.substr(11, 8);
-        int hours, minutes, seconds;
-        char colon1, colon2;
-        
-        std::stringstream ss(timeOnly);
-        if (ss >> hours >> colon1 >> minutes >> colon2 >> seconds) {
-            double utcHour = hours + (minutes / 60.0) + (seconds / 3600.0);
-            
-            // Get current system timezone info to determine if DST is active
-            TIME_ZONE_INFORMATION tzi;
-            DWORD tziResult = GetTimeZoneInformation(&tzi);
-            
-            double offsetHours;
-            if (tziResult == TIME_ZONE_ID_DAYLIGHT) {
-                // DST is active - use daylight bias
-                offsetHours = -(tzi.Bias + tzi.DaylightBias) / 60.0;
-            } else {
-                // Standard time - use standard bias
-                offsetHours = -(tzi.Bias + tzi.StandardBias) / 60.0;
-            }
-            
-            double localHour = utcHour + offsetHours;
-            if (localHour < 0) localHour += 24.0;
-            if (localHour >= 24) localHour -= 24.0;
-            
-            return localHour;
+    bool computeSolarTimesForDate(const std::string& targetDate, SolarTimes& solarTimes) {
+        long long day;
+        if (!SolarCache::parseDay(targetDate, day)) {
+            return false;
         }
-        
-        return 0.0;
-    }
-    
-    double parseTimeFromJson(const std::string& json, const std::string& key) {
-        size_t keyPos = json.find(key);
-        if (keyPos == std::string::npos) return 0.0;
-        
-        size_t startQuote = json.find("\"", keyPos + key.length());
-        if (startQuote == std::string::npos) return 0.0;
-        startQuote++;
-        
-        size_t endQuote = json.find("\"", startQuote);
-        if (endQuote == std::string::npos) return 0.0;
-        
-        std::string timeStr = json.substr(startQuote, endQuote - startQuote);
-        return parseTimeString(timeStr);
+        return SolarWindow::computeDay(day, config.latitude, config.longitude, getCurrentDay(), timeZone, solarTimes);
     }
-    
-    bool fetchSolarTimesForDate(const std::string& targetDate, SolarTimes& solarTimes, bool isRetry = false) {
-        std::stringstream urlBuilder;
-        urlBuilder << "https://api.sunrise-sunset.org/json?lat=" << config.latitude
-                   << "&lng=" << config.longitude << "&date=" << targetDate << "&formatted=0";
-
-        std::string url = urlBuilder.str();
-        if (config.debug_mode) logMessage("Fetching solar times for " + targetDate + "..." + std::string(isRetry ? " (retry)" : ""));
 
-        std::string response = httpGetWithTimeout(url, isRetry ? 10000 : 5000);
-
-        if (response.empty()) {
-            if (!isRetry) {
-                if (config.debug_mode) logMessage("API request timed out, retrying once...");
-                return fetchSolarTimesForDate(targetDate, solarTimes, true);
-            }
-            if (config.debug_mode) logMessage("API Error: Request timed out for " + targetDate);
-            return false;
+    // Logs how far a computed day is from the API's times for it
+    void logCrossCheck(const SolarTimes& computed, const ConcurrentFetcher::Result& response) {
+        SolarTimes fetched;
+        if (!response.completed || !parseSolarResponse(response.body, computed.fetch_date, fetched)) {
+            logMessage("API cross-check skipped for " + computed.fetch_date + " - no response");
+            return;
         }
 
-        if (response.find("\"status\":\"OK\"") == std::string::npos) {
+        auto minutesOff = [](double a, double b) {
+            double diff = std::fabs(a - b);
+            return static_cast<int>(std::lround(std::min(diff, 24.0 - diff) * 60.0));
+        };
+        logMessage("API cross-check for " + computed.fetch_date + " (minutes off):"
+                   + " sunrise " + std::to_string(minutesOff(computed.sunrise_hour, fetched.sunrise_hour))
+                   + ", noon " + std::to_string(minutesOff(computed.solar_noon_hour, fetched.solar_noon_hour))
+                   + ", sunset " + std::to_string(minutesOff(computed.sunset_hour, fetched.sunset_hour))
+                   + ", twilight end " + std::to_string(minutesOff(computed.civil_twilight_end, fetched.civil_twilight_end)));
+    }
+
+    bool parseSolarResponse(const std::string& response, const std::string& targetDate, SolarTimes& solarTimes) {
+        long long day;
+        if (!SolarCache::parseDay(targetDate, day) || !SolarWindow::parseDay(response, day, getCurrentDay(), timeZone, solarTimes)) {
             if (config.debug_mode) logMessage("API Error: Invalid response for " + targetDate);
             return false;
         }
 
-        try {
-            solarTimes.sunrise_hour = parseTimeFromJson(response, "\"sunrise\":");
-            solarTimes.sunset_hour = parseTimeFromJson(response, "\"sunset\":");
-            solarTimes.solar_noon_hour = parseTimeFromJson(response, "\"solar_noon\":");
-            solarTimes.civil_twilight_begin = parseTimeFromJson(response, "\"civil_twilight_begin\":");
-            solarTimes.civil_twilight_end = parseTimeFromJson(response, "\"civil_twilight_end\":");
-
-            if (solarTimes.sunrise_hour > 0 && solarTimes.sunset_hour > 0) {
-                solarTimes.valid = true;
-                solarTimes.fetch_date = targetDate;
-                solarTimes.source = "api";
+        if (config.debug_mode) {
+            logMessage("Solar times fetched successfully for " + targetDate + ":");
+            logMessage("  Sunrise: " + formatHour(solarTimes.sunrise_hour));
+            logMessage("  Sunset: " + formatHour(solarTimes.sunset_hour));
+        }
 
-                if (config.debug_mode) {
-                    logMessage("Solar times fetched successfully for " + targetDate + ":");
-                    logMessage("  Sunrise: " + formatHour(solarTimes.sunrise_hour));
-                    logMessage("  Sunset: " + formatHour(solarTimes.sunset_hour));
-                }
+        return true;
+    }
 
-                return true;
-            }
-        } catch (...) {
-            if (config.debug_mode) logMessage("JSON parsing error for " + targetDate);
-        }
+    // The rolling window settings of a config; reads only its argument, so
+    // the bootstrap thread can use it on its own copy
+    static SolarWindow solarWindowFor(const Config& settings) {
+        SolarWindow window;
+        window.latitude = settings.latitude;
+        window.longitude = settings.longitude;
+        window.windowDays = settings.solar_cache_days;
+        window.maxAgeDays = settings.solar_max_age_days;
+        window.apiMode = settings.solar_source == "api";
+        return window;
+    }
 
-        return false;
+    int solarWindowDays() const {
+        return solarWindowFor(config).length();
     }
 
-    bool fetchEightDaySolarData() {
-        // Initialize cache with 8 days if not already sized
-        if (solarCache.days.size() != 8) {
-            solarCache.days.resize(8);
+    // Shifts the cache window to start today and fills only the days that
+    // are missing or stale: from a background job's API batch where it
+    // answered, computing the rest. In api mode without a batch, the days
+    // are computed for now and queued for the next job, which refreshes the
+    // window again when it lands. A stale API day the API failed to refresh
+    // keeps its old times.
+    bool refreshSolarWindow(const BootstrapResult* prefetched = nullptr) {
+        long long today = getCurrentDay();
+        SolarWindow window = solarWindowFor(config);
+
+        const SolarWindow::ApiBatch* batch = prefetched ? &prefetched->apiBatch : nullptr;
+        if (!batch && window.apiMode) {
+            solarCache.shift(today, window.length());
+            queueApiDays(window.daysToRefresh(solarCache, today));
         }
 
-        int successCount = 0;
+        SolarWindow::Refresh refresh = window.refresh(solarCache, today, batch, timeZone);
+        if (batch) logApiBatch(*batch, refresh);
 
-        // Fetch data for today and next 7 days (8 days total)
-        for (int dayOffset = 0; dayOffset < 8; dayOffset++) {
-            std::string targetDate = getDateOffset(dayOffset);
-            if (fetchSolarTimesForDate(targetDate, solarCache.days[dayOffset])) {
-                successCount++;
-            }
+        SolarTimes* todaysData = solarCache.find(today);
+        if (!todaysData || !todaysData->valid) {
+            logMessage("Failed to compute solar data for " + SolarCache::formatDay(today));
+            return false;
         }
 
-        if (successCount > 0) {
-            solarCache.last_updated = getCurrentDate();
-            saveSolarCache();
-            logMessage("Updated solar cache with " + std::to_string(successCount) + "/8 days from API");
-            return true;
+        // Checked on the next background job and logged when it lands. In
+        // api mode today's computed times are only a stand-in for the batch.
+        if (config.verify_with_api && !window.apiMode && !refresh.wanted.empty()) {
+            pendingCrossCheck = *todaysData;
         }
 
-        logMessage("Failed to fetch any solar data from API");
-        return false;
+        saveSolarCache();
+        logMessage("Solar window " + solarCache.last_updated + " +" + std::to_string(window.length()) + " days: "
+                   + std::to_string(refresh.wanted.size()) + " missing or stale, " + std::to_string(refresh.fromApi.size()) + " from API, "
+                   + std::to_string(refresh.computed) + " computed, " + std::to_string(refresh.kept) + " stale kept"
+                   + (pendingApiDays.empty() ? "" : ", " + std::to_string(pendingApiDays.size()) + " queued for API"));
+        startBackgroundWork();
+        return true;
     }
 
-    SolarTimes* findCachedDataForDate(const std::string& targetDate) {
-        for (size_t i = 0; i < solarCache.days.size(); i++) {
-            if (solarCache.days[i].fetch_date == targetDate) {
-                return &solarCache.days[i];
-            }
+    void logApiBatch(const SolarWindow::ApiBatch& batch, const SolarWindow::Refresh& refresh) {
+        for (size_t i = 0; i < batch.results.size(); i++) {
+            const ConcurrentFetcher::Result& result = batch.results[i];
+            logMessage("  API " + SolarCache::formatDay(batch.days[i]) + ": " + std::to_string(result.latencyMs) + " ms, "
+                       + std::to_string(result.attempts) + " attempt(s), "
+                       + (refresh.apiOk[i] ? "ok" : (result.completed ? "invalid response" : "timed out")));
         }
-        return nullptr;
+
+        logMessage("Fetched " + std::to_string(refresh.fromApi.size()) + "/" + std::to_string(batch.results.size())
+                   + " days from API within " + std::to_string(config.api_deadline_ms) + " ms budget");
+        HttpClient::Stats httpStats = http->getStats();
+        logMessage("HTTP: " + std::to_string(httpStats.requests) + " requests over "
+                   + std::to_string(httpStats.connectionsOpened) + " host connection(s) so far");
     }
 
     bool shouldUpdateCache() {
@@ -602,49 +1148,42 @@ public:
     }
 
     bool fetchSolarTimes(bool forceRefresh = false) {
-        std::string today = getCurrentDate();
+        long long today = getCurrentDay();
+        std::string todayDate = SolarCache::formatDay(today);
 
         // Load cache first
         loadSolarCache();
 
-        // Check if we have valid cached data for today
-        SolarTimes* todaysData = findCachedDataForDate(today);
-        if (!forceRefresh && todaysData && todaysData->valid) {
-            todaysSolarTimes = *todaysData;
-            if (config.debug_mode) logMessage("Using cached solar times for " + today + " (source: " + todaysData->source + ")");
-            return true;
-        }
-
-        // Only attempt API fetch if we haven't already updated today
-        if (shouldUpdateCache()) {
-            logMessage("Attempting daily solar data update for " + today + " (8 days)");
-            if (fetchEightDaySolarData()) {
-                // Use today's data if available
-                todaysData = findCachedDataForDate(today);
-                if (todaysData && todaysData->valid) {
-                    todaysSolarTimes = *todaysData;
-                    return true;
-                }
-            }
+        // Move the window once a day; only new, missing or stale days are fetched
+        if (forceRefresh || shouldUpdateCache()) {
+            logMessage("Refreshing solar window for " + todayDate + " (" + std::to_string(solarWindowDays()) + " days)");
+            refreshSolarWindow();
         } else {
-            if (config.debug_mode) logMessage("Skipping API update - already updated today");
+            if (config.debug_mode) logMessage("Skipping solar update - already updated today");
         }
 
-        // Fall back to cached data if available (any cached data for today)
-        todaysData = findCachedDataForDate(today);
+        SolarTimes* todaysData = solarCache.find(today);
         if (todaysData && todaysData->valid) {
             todaysSolarTimes = *todaysData;
-            logMessage("Using cached solar times for " + today + " (source: " + todaysData->source + ")");
+            if (config.debug_mode) logMessage("Using cached solar times for " + todayDate + " (source: " + todaysData->source + ")");
+            return true;
+        }
+
+        // Compute today directly rather than borrowing another day's times
+        SolarTimes computed;
+        if (computeSolarTimesForDate(todayDate, computed)) {
+            todaysSolarTimes = computed;
+            logMessage("Using computed solar times for " + todayDate);
             return true;
         }
 
-        // Check for any available cached data as backup (search all 8 days)
+        // Check for any available cached data as backup
         for (size_t i = 0; i < solarCache.days.size(); i++) {
             if (solarCache.days[i].valid) {
                 todaysSolarTimes = solarCache.days[i];
-                todaysSolarTimes.fetch_date = today;
+                todaysSolarTimes.fetch_date = todayDate;
                 todaysSolarTimes.source = "cache-backup-day" + std::to_string(i);
-                logMessage("Using cached solar times from day " + std::to_string(i) + " as backup for " + today);
+                logMessage("Using cached solar times from day " + std::to_string(i) + " as backup for " + todayDate);
                 return true;
             }
         }
@@ -668,8 +1207,20 @@ public:
         return false;
     }
     
+    // Current time from the injected clock; everything that reads the time of day goes through this
+    time_t currentTime() const {
+        return std::chrono::system_clock::to_time_t(clock->now());
+    }
+
+    static std::string formatTimePoint(TimeSource::TimePoint point) {
+        time_t seconds = std::chrono::system_clock::to_time_t(point);
+        char text[32];
+        strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", localtime(&seconds));
+        return text;
+    }
+
     std::string getCurrentDate() {
-        time_t now = time(0);
+        time_t now = currentTime();
         tm* timeinfo = localtime(&now);
 
         std::stringstream ss;
@@ -679,70 +1230,65 @@ public:
         return ss.str();
     }
 
-    std::string getDateOffset(int dayOffset) {
-        time_t now = time(0);
-        now += dayOffset * 24 * 60 * 60; // Add/subtract days
+    // Today's local date as a day number (see daysFromCivil)
+    long long getCurrentDay() const {
+        time_t now = currentTime();
         tm* timeinfo = localtime(&now);
-
-        std::stringstream ss;
-        ss << (timeinfo->tm_year + 1900) << "-"
-           << std::setfill('0') << std::setw(2) << (timeinfo->tm_mon + 1) << "-"
-           << std::setw(2) << timeinfo->tm_mday;
-        return ss.str();
+        return daysFromCivil(timeinfo->tm_year + 1900, timeinfo->tm_mon + 1, timeinfo->tm_mday);
     }
 
     std::string getSolarCachePath() {
         std::string configPath = getConfigPath();
         size_t lastSlash = configPath.find_last_of("\\/");
         if (lastSlash != std::string::npos) {
-            return configPath.substr(0, lastSlash + 1) + "solar_cache.txt";
+            return configPath.substr(0, lastSlash + 1) + (simulatedClock ? "solar_cache_replay.bin" : "solar_cache.bin");
         }
-        return "solar_cache.txt";
+        return simulatedClock ? "solar_cache_replay.bin" : "solar_cache.bin";
+    }
+
+    // Text cache written by earlier versions; only read once to seed the binary cache
+    std::string getLegacySolarCachePath() {
+        std::string cachePath = getSolarCachePath();
+        return cachePath.substr(0, cachePath.size() - 4) + ".txt";
     }
 
     void saveSolarCache() {
+        FrameStats::Scope timed(frameStats, FrameStats::STAGE_CACHE_IO);
         std::string cachePath = getSolarCachePath();
-        std::ofstream cacheFile(cachePath);
-        if (!cacheFile.is_open()) {
+        if (!SolarCacheFile::save(cachePath, solarCache)) {
             if (config.debug_mode) logMessage("Failed to save solar cache to " + cachePath);
             return;
         }
+        if (config.debug_mode) logMessage("Solar cache saved successfully (" + std::to_string(solarCache.days.size()) + " days)");
+    }
 
-        cacheFile << "# TimeWallpaper Solar Cache - Eight Day Data (Today + Next 7 Days)" << std::endl;
-        cacheFile << "last_updated=" << solarCache.last_updated << std::endl;
-        cacheFile << std::endl;
-
-        // Save all 8 days of data
-        for (size_t i = 0; i < solarCache.days.size(); i++) {
-            const SolarTimes& dayData = solarCache.days[i];
+    bool loadSolarCache() {
+        FrameStats::Scope timed(frameStats, FrameStats::STAGE_CACHE_IO);
+        if (SolarCacheFile::load(getSolarCachePath(), solarCache)) {
+            if (config.debug_mode) logMessage("Solar cache loaded successfully (" + std::to_string(solarCache.days.size()) + " days)");
+            return true;
+        }
 
-            cacheFile << "[day" << i << "]" << std::endl;
-            cacheFile << "date=" << dayData.fetch_date << std::endl;
-            cacheFile << "sunrise=" << std::fixed << std::setprecision(6) << dayData.sunrise_hour << std::endl;
-            cacheFile << "sunset=" << std::fixed << std::setprecision(6) << dayData.sunset_hour << std::endl;
-            cacheFile << "solar_noon=" << std::fixed << std::setprecision(6) << dayData.solar_noon_hour << std::endl;
-            cacheFile << "civil_twilight_begin=" << std::fixed << std::setprecision(6) << dayData.civil_twilight_begin << std::endl;
-            cacheFile << "civil_twilight_end=" << std::fixed << std::setprecision(6) << dayData.civil_twilight_end << std::endl;
-            cacheFile << "valid=" << (dayData.valid ? "true" : "false") << std::endl;
-            cacheFile << "source=" << dayData.source << std::endl;
-            cacheFile << std::endl;
+        // One-time import of the old text cache into the binary format
+        if (importLegacySolarCache()) {
+            saveSolarCache();
+            logMessage("Imported legacy solar cache from " + getLegacySolarCachePath());
+            return true;
         }
 
-        cacheFile.close();
-        if (config.debug_mode) logMessage("Solar cache saved successfully (8 days)");
+        if (config.debug_mode) logMessage("No existing solar cache found");
+        return false;
     }
 
-    bool loadSolarCache() {
-        std::string cachePath = getSolarCachePath();
-        std::ifstream cacheFile(cachePath);
+    bool importLegacySolarCache() {
+        std::ifstream cacheFile(getLegacySolarCachePath());
         if (!cacheFile.is_open()) {
-            if (config.debug_mode) logMessage("No existing solar cache found");
             return false;
         }
 
-        // Initialize with 8 empty entries
-        solarCache.days.clear();
-        solarCache.days.resize(8);
+        // The old format always had 8 numbered slots; they are placed into the window by date below
+        std::vector<SolarTimes> legacyDays(8);
+        std::string lastUpdated;
 
         std::string line;
         int currentDayIndex = -1;
@@ -766,9 +1312,9 @@ public:
                 std::string value = line.substr(equalPos + 1);
 
                 if (key == "last_updated") {
-                    solarCache.last_updated = value;
+                    lastUpdated = value;
                 } else if (currentDayIndex >= 0 && currentDayIndex < 8) {
-                    SolarTimes& currentTimes = solarCache.days[currentDayIndex];
+                    SolarTimes& currentTimes = legacyDays[currentDayIndex];
                     if (key == "date") currentTimes.fetch_date = value;
                     else if (key == "sunrise") currentTimes.sunrise_hour = std::stod(value);
                     else if (key == "sunset") currentTimes.sunset_hour = std::stod(value);
@@ -782,10 +1328,86 @@ public:
         }
 
         cacheFile.close();
-        if (config.debug_mode) logMessage("Solar cache loaded successfully (8 days)");
+
+        solarCache = SolarCache();
+        solarCache.last_updated = lastUpdated;
+        long long refreshedDay = 0;
+        SolarCache::parseDay(lastUpdated, refreshedDay);
+        for (SolarTimes& legacyDay : legacyDays) {
+            long long day;
+            if (!SolarCache::parseDay(legacyDay.fetch_date, day)) continue;
+            legacyDay.refreshed_day = refreshedDay;
+            solarCache.put(day, legacyDay);
+        }
         return true;
     }
     
+    // Theme file path; relative names are next to config.ini
+    static std::string resolveThemePath(const std::string& themeFile) {
+        if (themeFile.empty()) return "";
+        if (themeFile.find(':') != std::string::npos || themeFile[0] == '\\' || themeFile[0] == '/') return themeFile;
+
+        std::string configPath = getConfigPath();
+        size_t lastSlash = configPath.find_last_of("\\/");
+        return (lastSlash != std::string::npos ? configPath.substr(0, lastSlash + 1) : "") + themeFile;
+    }
+
+    // Last write time of a file, 0 if it cannot be read
+    static uint64_t fileWriteTime(const std::string& path) {
+        WIN32_FILE_ATTRIBUTE_DATA attributes;
+        if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &attributes)) return 0;
+        return (static_cast<uint64_t>(attributes.ftLastWriteTime.dwHighDateTime) << 32)
+             | attributes.ftLastWriteTime.dwLowDateTime;
+    }
+
+    // Theme from a config, or the built-in one when unset or invalid
+    static std::shared_ptr<const ColorTheme> loadThemeFile(const std::string& path, std::string& error) {
+        if (path.empty()) return ColorTheme::builtIn();
+
+        auto theme = std::make_shared<ColorTheme>();
+        if (!ColorTheme::load(path, *theme, error)) return nullptr;
+        return theme;
+    }
+
+    void loadTheme() {
+        themePath = resolveThemePath(config.theme_file);
+        themeWriteTime = themePath.empty() ? 0 : fileWriteTime(themePath);
+
+        std::string error;
+        std::shared_ptr<const ColorTheme> theme = loadThemeFile(themePath, error);
+        if (!theme) {
+            std::cout << "Theme " << themePath << " not loaded (" << error << "), using built-in colors" << std::endl;
+            logger.log(AsyncLogger::LOG_WARN, "Theme error: {}", error);
+            theme = ColorTheme::builtIn();
+        } else if (!themePath.empty()) {
+            std::cout << "Loaded theme " << themePath << " (" << theme->getStops().size() << " stops)" << std::endl;
+        }
+        colorSchedule.setTheme(theme);
+    }
+
+    // Reloads the theme file when its modification time changes. A file
+    // that fails to parse leaves the current theme in place.
+    bool reloadThemeIfChanged() {
+        if (themePath.empty()) return false;
+
+        uint64_t writeTime = fileWriteTime(themePath);
+        if (writeTime == 0 || writeTime == themeWriteTime) return false;
+        themeWriteTime = writeTime;
+
+        std::string error;
+        std::shared_ptr<const ColorTheme> theme = loadThemeFile(themePath, error);
+        if (!theme) {
+            std::cout << "Theme " << themePath << " changed but was not reloaded: " << error << std::endl;
+            logger.log(AsyncLogger::LOG_WARN, "Theme reload failed: {}", error);
+            return false;
+        }
+
+        colorSchedule.setTheme(theme);
+        std::cout << "Reloaded theme " << themePath << " (" << theme->getStops().size() << " stops)" << std::endl;
+        logMessage("Reloaded theme " + themePath);
+        return true;
+    }
+
     void generateTodaysColors() {
         if (config.debug_mode) {
             logMessage("Solar-based continuous color calculation initialized");
@@ -814,155 +1436,58 @@ public:
             return;
         }
         
-        // Write CSV header
-        csvFile << "Time,Hour,Minute,R,G,B,Period" << std::endl;
-        
-        // Generate colors for each minute of the day
-        for (int hour = 0; hour < 24; hour++) {
-            for (int minute = 0; minute < 60; minute++) {
-                double timeHour = hour + (minute / 60.0);
-                std::string period;
-                Color color = getColorForHour(timeHour, &period);
-
-                // Format time as HH:MM
-                std::stringstream timeStr;
-                timeStr << std::setfill('0') << std::setw(2) << hour
-                       << ":" << std::setw(2) << minute;
-
-                csvFile << timeStr.str() << ","
-                       << std::fixed << std::setprecision(2) << timeHour << ","
-                       << minute << ","
-                       << color.r << "," << color.g << "," << color.b << ","
-                       << period << std::endl;
-            }
+        // One batch lookup for every minute of the day
+        const int minutesPerDay = 24 * 60;
+        std::vector<int> seconds(minutesPerDay);
+        for (int minute = 0; minute < minutesPerDay; minute++) seconds[minute] = minute * 60;
+        std::vector<Color> colors(minutesPerDay);
+        std::vector<PeriodId> periods(minutesPerDay);
+        getSchedule().colorsAtSeconds(seconds.data(), minutesPerDay, colors.data(), periods.data());
+
+        std::string text = "Time,Hour,Minute,R,G,B,Period\n";
+        text.reserve(minutesPerDay * 48);
+        char line[96];
+        for (int i = 0; i < minutesPerDay; i++) {
+            int hour = i / 60;
+            int minute = i % 60;
+            int length = snprintf(line, sizeof(line), "%02d:%02d,%.2f,%d,%d,%d,%d,", hour, minute,
+                                  hour + (minute / 60.0), minute, colors[i].r, colors[i].g, colors[i].b);
+            text.append(line, length);
+            text += getSchedule().periodName(periods[i]);
+            text += '\n';
         }
+        csvFile << text;
         
         csvFile.close();
         logMessage("Debug CSV generated: " + csvPath);
     }
     
     
-    Color getCurrentColor() {
-        time_t now = time(0);
+    const ColorSchedule& getSchedule() {
+        // Recompile only when today's solar times have changed
+        if (!colorSchedule.isBuiltFor(todaysSolarTimes)) {
+            colorSchedule.build(todaysSolarTimes);
+        }
+        return colorSchedule;
+    }
+
+    int getCurrentSecondOfDay() {
+        time_t now = currentTime();
         tm* timeinfo = localtime(&now);
-        // Include seconds for 15-second granularity
-        double currentHour = timeinfo->tm_hour + (timeinfo->tm_min / 60.0) + (timeinfo->tm_sec / 3600.0);
+        return timeinfo->tm_hour * 3600 + timeinfo->tm_min * 60 + timeinfo->tm_sec;
+    }
 
-        return getColorForHour(currentHour);
+    Color getCurrentColor() {
+        // Include seconds for 15-second granularity
+        return getSchedule().colorAtSecond(getCurrentSecondOfDay());
     }
     
     
     Color getColorForHour(double hour, std::string* outPeriod = nullptr) {
-        double sunrise = todaysSolarTimes.sunrise_hour;
-        double sunset = todaysSolarTimes.sunset_hour;
-        double solar_noon = todaysSolarTimes.solar_noon_hour;
-        double civil_twilight_end = todaysSolarTimes.civil_twilight_end;
-
-        // Normalize hour to 0-24 range
-        while (hour < 0) hour += 24.0;
-        while (hour >= 24) hour -= 24.0;
-
-        // Create base timeline points ensuring no overlaps
-        std::vector<ColorPoint> points;
-        
-        // Night and early morning
-        points.push_back({0.0, Color(8, 8, 25), "Deep Night"});
-        points.push_back({std::max(1.0, sunrise - 3.0), Color(10, 10, 25), "Pre-Dawn"});
-        points.push_back({std::max(2.0, sunrise - 1.5), Color(15, 15, 45), "Early Dawn"});
-        points.push_back({std::max(3.0, sunrise - 1.0), Color(25, 15, 65), "Early Dawn"});
-        points.push_back({std::max(4.0, sunrise - 0.5), Color(50, 30, 65), "Dawn"});
-        points.push_back({std::max(5.0, sunrise - 0.25), Color(120, 80, 110), "Dawn"});
-        
-        // Sunrise and morning
-        points.push_back({std::max(6.0, sunrise), Color(160, 120, 130), "Sunrise"});
-        points.push_back({std::max(7.0, sunrise + 0.25), Color(190, 150, 140), "Sunrise"});
-        points.push_back({std::max(8.0, sunrise + 0.5), Color(210, 180, 160), "Early Morning"});
-        points.push_back({std::max(9.0, sunrise + 1.0), Color(220, 200, 180), "Early Morning"});
-        points.push_back({std::max(10.0, sunrise + 2.0), Color(230, 240, 220), "Morning"});
-        
-        // Day time
-        points.push_back({std::max(11.0, solar_noon - 1.5), Color(210, 230, 200), "Late Morning"});
-        points.push_back({std::max(11.5, solar_noon - 1.0), Color(190, 220, 190), "Late Morning"});
-        points.push_back({std::max(12.0, solar_noon), Color(170, 210, 230), "Noon"});
-        points.push_back({std::max(13.0, solar_noon + 1.0), Color(170, 210, 230), "Early Afternoon"});
-        points.push_back({std::max(14.0, solar_noon + 1.5), Color(170, 210, 230), "Early Afternoon"});
-        
-        // Afternoon to sunset - ensure progressive timing
-        double late_afternoon_start = sunset - 2.0;
-        double pre_sunset_start = sunset - 1.5;
-        double pre_sunset_mid = sunset - 1.0;
-        double pre_sunset_end = sunset - 0.5;
-        double sunset_time = sunset;
-        
-        points.push_back({late_afternoon_start, Color(170, 210, 230), "Late Afternoon"});
-        points.push_back({pre_sunset_start, Color(170, 210, 230), "Late Afternoon"});
-        points.push_back({pre_sunset_mid, Color(175, 200, 225), "Pre-Sunset"});
-        points.push_back({pre_sunset_end, Color(180, 195, 220), "Pre-Sunset"});
-        points.push_back({sunset_time, Color(230, 140, 70), "Sunset"});
-        
-        // Post-sunset to evening - ensure monotonic progression
-        double post_sunset_1 = sunset_time + 0.1;
-        double post_sunset_2 = post_sunset_1 + 0.1;
-        double post_sunset_3 = post_sunset_2 + 0.1;
-        double twilight_1 = post_sunset_3 + 0.1;
-        double twilight_2 = twilight_1 + 0.1;
-        double twilight_3 = twilight_2 + 0.1;
-        
-        points.push_back({post_sunset_1, Color(210, 120, 70), "Sunset"});
-        points.push_back({post_sunset_2, Color(170, 100, 75), "Post-Sunset"});
-        points.push_back({post_sunset_3, Color(140, 90, 80), "Post-Sunset"});
-        points.push_back({twilight_1, Color(110, 80, 85), "Civil Twilight"});
-        points.push_back({twilight_2, Color(95, 75, 95), "Civil Twilight"});
-        points.push_back({twilight_3, Color(80, 65, 85), "Civil Twilight"});
-        
-        // Evening progression - based on twilight end
-        double evening_start = twilight_3 + 0.1;
-        points.push_back({evening_start, Color(65, 60, 75), "Evening"});
-        points.push_back({evening_start + 0.25, Color(65, 55, 70), "Evening"});
-        points.push_back({evening_start + 0.5, Color(60, 50, 70), "Evening"});
-        points.push_back({evening_start + 0.75, Color(50, 45, 65), "Evening"});
-        points.push_back({evening_start + 1.0, Color(45, 40, 65), "Evening"});
-        points.push_back({evening_start + 1.25, Color(40, 35, 60), "Evening"});
-        points.push_back({evening_start + 1.5, Color(35, 30, 55), "Evening"});
-        points.push_back({evening_start + 1.75, Color(32, 28, 52), "Late Evening"});
-        points.push_back({evening_start + 2.25, Color(32, 22, 48), "Late Evening"});
-        points.push_back({evening_start + 2.75, Color(22, 17, 42), "Late Evening"});
-        points.push_back({evening_start + 3.25, Color(15, 12, 35), "Night"});
-        points.push_back({23.99, Color(8, 8, 20), "Night"});
-        
-        // Fix times outside 0-24 range
-        for (auto& point : points) {
-            while (point.hour < 0) point.hour += 24.0;
-            while (point.hour >= 24) point.hour -= 24.0;
-        }
-        
-        // Sort points by time
-        std::sort(points.begin(), points.end(), 
-                  [](const ColorPoint& a, const ColorPoint& b) {
-                      return a.hour < b.hour;
-                  });
-        
-        // Find the appropriate color interpolation
-        for (size_t i = 0; i < points.size() - 1; i++) {
-            if (hour >= points[i].hour && hour <= points[i + 1].hour) {
-                double progress = (hour - points[i].hour) / (points[i + 1].hour - points[i].hour);
-                if (outPeriod) *outPeriod = points[i].period;
-                return interpolateColor(points[i].color, points[i + 1].color, progress);
-            }
-        }
-
-        // Handle wrap-around (from last point to first point)
-        double lastHour = points.back().hour;
-        double firstHour = points.front().hour + 24;
-
-        if (hour >= lastHour) {
-            double progress = (hour - lastHour) / (firstHour - lastHour);
-            if (outPeriod) *outPeriod = points.back().period;
-            return interpolateColor(points.back().color, points.front().color, progress);
-        }
-
-        if (outPeriod) *outPeriod = points.front().period;
-        return points.front().color;
+        PeriodId period;
+        Color color = getSchedule().colorAtHour(hour, &period);
+        if (outPeriod) *outPeriod = getSchedule().periodName(period);
+        return color;
     }
     
     bool isTimeBetween(double current, double start, double end) {
@@ -985,38 +1510,13 @@ public:
         return (current - start) / (end - start);
     }
     
-    std::string getCurrentPeriod() {
-        time_t now = time(0);
-        tm* timeinfo = localtime(&now);
-        double currentHour = timeinfo->tm_hour + (timeinfo->tm_min / 60.0);
+    const char* getCurrentPeriod() {
+        // Period is reported at minute resolution
+        int minuteStart = getCurrentSecondOfDay() / 60 * 60;
 
-        std::string period;
-        getColorForHour(currentHour, &period);
-        return period;
-    }
-    
-    Color interpolateColor(Color start, Color end, double ratio) {
-        ratio = std::max(0.0, std::min(1.0, ratio));
-        
-        int r = static_cast<int>(start.r * (1 - ratio) + end.r * ratio);
-        int g = static_cast<int>(start.g * (1 - ratio) + end.g * ratio);
-        int b = static_cast<int>(start.b * (1 - ratio) + end.b * ratio);
-        
-        return Color(r, g, b);
-    }
-    
-    std::string formatHour(double hour) {
-        int h = static_cast<int>(hour);
-        int m = static_cast<int>((hour - h) * 60);
-        
-        std::string ampm = "AM";
-        if (h == 0) h = 12;
-        else if (h == 12) ampm = "PM";
-        else if (h > 12) { h -= 12; ampm = "PM"; }
-        
-        std::stringstream ss;
-        ss << h << ":" << std::setfill('0') << std::setw(2) << m << " " << ampm;
-        return ss.str();
+        PeriodId period;
+        getSchedule().colorAtSecond(minuteStart, &period);
+        return getSchedule().periodName(period);
     }
     
     void loadWatermark() {
@@ -1040,69 +1540,73 @@ public:
         }
     }
 
-    void renderFrame(const Color& bgColor) {
-        // Get current time and calculate future time (1 hour ahead)
-        time_t now = time(0);
-        tm* timeinfo = localtime(&now);
-        double currentHour = timeinfo->tm_hour + (timeinfo->tm_min / 60.0) + (timeinfo->tm_sec / 3600.0);
-        double futureHour = currentHour + 1.0;
-
-        // Get colors for current and future times
-        Color bottomColor = bgColor; // Current color (already calculated)
-        Color topColor = getColorForHour(futureHour);
-
-        // 8x8 Bayer matrix for ordered dithering
-        static const int bayerMatrix[8][8] = {
-            { 0, 32,  8, 40,  2, 34, 10, 42},
-            {48, 16, 56, 24, 50, 18, 58, 26},
-            {12, 44,  4, 36, 14, 46,  6, 38},
-            {60, 28, 52, 20, 62, 30, 54, 22},
-            { 3, 35, 11, 43,  1, 33,  9, 41},
-            {51, 19, 59, 27, 49, 17, 57, 25},
-            {15, 47,  7, 39, 13, 45,  5, 37},
-            {63, 31, 55, 23, 61, 29, 53, 21}
+    void renderFrame(const Color& bottomColor, const Color& topColor) {
+        int64_t rasterStart = frameStats.start();
+        GradientRasterizer rasterizer(bottomColor, topColor, *ditherPattern);
+
+        // Find monitors whose cached gradient is stale and split them into row bands
+        struct RasterBand {
+            MonitorWindow* monitor;
+            int rowBegin, rowEnd;
         };
+        std::vector<RasterBand> bands;
+        std::vector<MonitorWindow*> staleMonitors;
 
-        // Render to all monitor windows
         for (auto& m : monitors) {
             if (m.window && m.window->isOpen()) {
-                // Create dithered gradient using per-pixel rendering
-                sf::Image gradientImage;
-                gradientImage.create(m.width, m.height);
-
-                for (int y = 0; y < m.height; y++) {
-                    // Calculate vertical progress (0.0 at bottom, 1.0 at top)
-                    double verticalProgress = 1.0 - (static_cast<double>(y) / m.height);
-
-                    // Interpolate base color at this row
-                    Color baseColor = interpolateColor(bottomColor, topColor, 1.0 - verticalProgress);
-
-                    for (int x = 0; x < m.width; x++) {
-                        // Get dither threshold from Bayer matrix (0-63)
-                        int bayerValue = bayerMatrix[y % 8][x % 8];
-                        double threshold = (bayerValue / 64.0) - 0.5; // Range: -0.5 to ~0.5
-
-                        // Apply dithering: add threshold scaled by color difference
-                        Color colorDiff;
-                        colorDiff.r = topColor.r - bottomColor.r;
-                        colorDiff.g = topColor.g - bottomColor.g;
-                        colorDiff.b = topColor.b - bottomColor.b;
+                GradientKey key;
+                key.bottom = bottomColor;
+                key.top = topColor;
+                key.width = m.width;
+                key.height = m.height;
+
+                if (m.hasGradient && m.gradientKey == key) {
+                    renderCacheHits++;
+                    continue;
+                }
+                renderCacheMisses++;
 
-                        int r = std::max(0, std::min(255, baseColor.r + static_cast<int>(threshold * abs(colorDiff.r) * 0.5)));
-                        int g = std::max(0, std::min(255, baseColor.g + static_cast<int>(threshold * abs(colorDiff.g) * 0.5)));
-                        int b = std::max(0, std::min(255, baseColor.b + static_cast<int>(threshold * abs(colorDiff.b) * 0.5)));
+                if (!m.hasGradient || m.gradientKey.width != m.width || m.gradientKey.height != m.height) {
+                    m.gradientWidth = config.tiled_gradient ? std::min(m.width, rasterizer.getPatternWidth()) : m.width;
+                    m.gradientPixels.assign(static_cast<size_t>(m.gradientWidth) * m.height * 4, 0);
+                    m.gradientTexture.create(m.gradientWidth, m.height);
+                    m.gradientTexture.setRepeated(config.tiled_gradient);
+                }
+                m.gradientKey = key;
+                staleMonitors.push_back(&m);
 
-                        gradientImage.setPixel(x, y, sf::Color(r, g, b));
-                    }
+                for (int row = 0; row < m.height; row += kRasterBandRows) {
+                    bands.push_back({&m, row, std::min(m.height, row + kRasterBandRows)});
                 }
+            }
+        }
 
-                // Create texture from image and draw it
-                sf::Texture gradientTexture;
-                gradientTexture.loadFromImage(gradientImage);
-                sf::Sprite gradientSprite(gradientTexture);
+        // Rasterize all bands of all monitors across the pool
+        rasterPool->run(bands.size(), [&](size_t i) {
+            const RasterBand& band = bands[i];
+            rasterizer.rasterizeRows(band.monitor->gradientPixels.data(), band.monitor->gradientWidth,
+                                     band.monitor->height, band.rowBegin, band.rowEnd);
+        });
+
+        if (!staleMonitors.empty()) {
+            frameStats.stop(FrameStats::STAGE_RASTER, rasterStart);
+
+            // Texture uploads stay on this thread, which owns the GL contexts
+            FrameStats::Scope timed(frameStats, FrameStats::STAGE_UPLOAD);
+            for (MonitorWindow* m : staleMonitors) {
+                m->gradientTexture.update(m->gradientPixels.data());
+                m->gradientSprite.setTexture(m->gradientTexture);
+                m->gradientSprite.setTextureRect(sf::IntRect(0, 0, m->width, m->height));
+                m->hasGradient = true;
+            }
+        }
 
+        // Render to all monitor windows
+        FrameStats::Scope timed(frameStats, FrameStats::STAGE_DISPLAY);
+        for (auto& m : monitors) {
+            if (m.window && m.window->isOpen()) {
                 m.window->clear();
-                m.window->draw(gradientSprite);
+                m.window->draw(m.gradientSprite);
 
                 // Draw watermark if available
                 if (hasWatermark) {
@@ -1115,8 +1619,41 @@ public:
     }
 
     void updateDisplay() {
-        Color currentColor = getCurrentColor();
-        renderFrame(currentColor);
+        // Colors for the current time and one hour ahead
+        int secondOfDay = getCurrentSecondOfDay();
+        Color currentColor, aheadColor;
+        PeriodId period;
+        {
+            FrameStats::Scope timed(frameStats, FrameStats::STAGE_COLOR);
+            currentColor = getSchedule().colorAtSecond(secondOfDay, &period);
+            aheadColor = getSchedule().colorAtSecond(secondOfDay + 3600);
+        }
+        renderFrame(currentColor, aheadColor);
+        publishColorFeed(secondOfDay, currentColor, period);
+    }
+
+    void publishColorFeed(int secondOfDay, const Color& color, PeriodId period) {
+        if (!colorFeed.isOpen()) return;
+        const ColorSchedule& schedule = getSchedule();
+
+        twf_snapshot snapshot = {};
+        snapshot.updated_unix = static_cast<int64_t>(currentTime());
+        snapshot.color = color.packed();
+        snapshot.local_hour = secondOfDay / 3600.0;
+        ColorFeed::copyName(snapshot.period, schedule.periodName(period));
+
+        Color nextColor;
+        PeriodId nextPeriod;
+        schedule.nextKeyframe(snapshot.local_hour, snapshot.next_keyframe_hour, nextColor, nextPeriod);
+        snapshot.next_color = nextColor.packed();
+        ColorFeed::copyName(snapshot.next_period, schedule.periodName(nextPeriod));
+
+        snapshot.sunrise_hour = todaysSolarTimes.sunrise_hour;
+        snapshot.sunset_hour = todaysSolarTimes.sunset_hour;
+        snapshot.solar_noon_hour = todaysSolarTimes.solar_noon_hour;
+        snapshot.civil_twilight_begin = todaysSolarTimes.civil_twilight_begin;
+        snapshot.civil_twilight_end = todaysSolarTimes.civil_twilight_end;
+        colorFeed.publish(snapshot);
     }
     
     void createMessageWindow() {
@@ -1145,13 +1682,135 @@ public:
         return DefWindowProc(hWnd, uMsg, wParam, lParam);
     }
 
-    void run() {
+    // Blocks until the deadline or until a window/power message arrives.
+    // A stepped simulated clock jumps straight to the deadline instead.
+    void waitUntil(TimeSource::TimePoint deadline) {
+        if (simulatedClock && simulatedClock->isStepped()) {
+            simulatedClock->advanceTo(deadline);
+            wakeupCount++;
+            return;
+        }
+
+        auto delay = std::chrono::duration_cast<std::chrono::microseconds>(clock->realDelayUntil(deadline));
+        if (delay.count() <= 0) return;
+
+        // Relative due time in 100ns units
+        LARGE_INTEGER dueTime;
+        dueTime.QuadPart = -static_cast<long long>(delay.count()) * 10;
+        SetWaitableTimer(wakeTimer, &dueTime, 0, NULL, NULL, FALSE);
+
+        MsgWaitForMultipleObjectsEx(1, &wakeTimer, INFINITE, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+        wakeupCount++;
+    }
+
+    // Turns on per-stage loop timing, dumped to frame_stats.txt next to config.ini
+    void enableFrameStats() {
+        std::string statsPath = getConfigPath();
+        size_t lastSlash = statsPath.find_last_of("\\/");
+        statsPath = (lastSlash != std::string::npos ? statsPath.substr(0, lastSlash + 1) : "") + "frame_stats.txt";
+        frameStats.enable(statsPath);
+    }
+
+    // Headless per-second export for --export; reads config.ini but opens no windows
+    static int exportColors(const std::string& range, const std::string& path) {
+        Config settings;
+        if (!readConfigFile(getConfigPath(), settings)) {
+            std::cout << "No config.ini found, exporting for " << settings.location_name << std::endl;
+        }
+
+        time_t now = time(0);
+        tm* today = localtime(&now);
+        int year = today->tm_year + 1900;
+        long long firstDay;
+        int dayCount;
+        if (range == "day") {
+            firstDay = daysFromCivil(year, today->tm_mon + 1, today->tm_mday);
+            dayCount = 1;
+        } else if (range == "year") {
+            firstDay = daysFromCivil(year, 1, 1);
+            dayCount = static_cast<int>(daysFromCivil(year + 1, 1, 1) - firstDay);
+        } else {
+            std::cout << "Unknown export range '" << range << "' (use day or year)" << std::endl;
+            return 1;
+        }
+
+        int threads = settings.render_threads > 0
+            ? settings.render_threads
+            : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        std::string error;
+        std::shared_ptr<const ColorTheme> theme = loadThemeFile(resolveThemePath(settings.theme_file), error);
+        if (!theme) {
+            std::cout << "Theme not loaded (" << error << ")" << std::endl;
+            return 1;
+        }
+
+        WorkStealingPool pool(threads);
+        TimeZoneTable zone(std::make_unique<WindowsTimeZoneProvider>());
+
+        auto start = std::chrono::steady_clock::now();
+        bool ok = ColorExporter::exportDays(firstDay, dayCount, settings.latitude, settings.longitude, theme, zone, pool, path);
+        long long elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+
+        if (!ok) {
+            std::cout << "Export to " << path << " failed" << std::endl;
+            return 1;
+        }
+        std::cout << "Exported " << dayCount << " day(s) for " << settings.location_name << " to " << path
+                  << " in " << elapsedMs << " ms" << std::endl;
+        return 0;
+    }
+
+    // Evaluates every site in a CSV at the current time using the configured theme
+    static int runBatch(const std::string& sitesPath, const std::string& outputPath) {
+        Config settings;
+        readConfigFile(getConfigPath(), settings);
+
+        std::string error;
+        std::shared_ptr<const ColorTheme> theme = loadThemeFile(resolveThemePath(settings.theme_file), error);
+        if (!theme) {
+            std::cout << "Theme not loaded (" << error << ")" << std::endl;
+            return 1;
+        }
+
+        std::vector<SiteBatch::Site> sites;
+        std::vector<std::string> warnings;
+        if (!SiteBatch::readSites(sitesPath, sites, warnings, error, WindowsTimeZoneProvider::forZone)) {
+            std::cout << "Batch failed: " << error << std::endl;
+            return 1;
+        }
+        for (const std::string& warning : warnings) std::cout << "Skipped " << warning << std::endl;
+
+        int threads = settings.render_threads > 0
+            ? settings.render_threads
+            : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        WorkStealingPool pool(threads);
+
+        long long now = static_cast<long long>(time(0));
+        std::vector<SiteBatch::Result> results;
+        auto start = std::chrono::steady_clock::now();
+        SiteBatch::evaluate(sites, now, theme, pool, results, WindowsTimeZoneProvider::forZone);
+        double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        if (!SiteBatch::write(outputPath, now, sites, results, *theme)) {
+            std::cout << "Writing " << outputPath << " failed" << std::endl;
+            return 1;
+        }
+        std::cout << "Evaluated " << sites.size() << " site(s) on " << threads << " thread(s) in "
+                  << std::fixed << std::setprecision(1) << elapsedMs << " ms ("
+                  << std::setprecision(0) << (elapsedMs > 0 ? sites.size() / (elapsedMs / 1000.0) : 0.0)
+                  << " sites/s), wrote " << outputPath << std::endl;
+        return 0;
+    }
+
+    // Runs until a window is closed or, for a replay, until the clock reaches stopAt
+    void run(TimeSource::TimePoint stopAt = TimeSource::TimePoint::max()) {
         std::cout << "\nStarting TimeWallpaper..." << std::endl;
-        std::cout << "Display will update every 15 seconds for smooth color transitions" << std::endl;
+        std::cout << "Display will update whenever the color changes, with status every 15 seconds" << std::endl;
         std::cout << "Use Task Manager to terminate the application" << std::endl << std::endl;
 
         logMessage("Starting TimeWallpaper...");
-        logMessage("Display will update every 15 seconds for smooth color transitions");
+        logMessage("Display will update whenever the color changes, with status every 15 seconds");
 
         // Create hidden window for power management messages
         createMessageWindow();
@@ -1161,29 +1820,63 @@ public:
             logMessage("Power management enabled - will update on wake from sleep");
         }
 
-        // Initial setup
-        std::cout << "Fetching solar times..." << std::endl;
-        fetchSolarTimes();
+        // Timer the loop blocks on between deadlines
+        wakeTimer = CreateWaitableTimerA(NULL, TRUE, NULL);
+        UpdateScheduler scheduler(*clock, timeZone);
+
+        // Initial setup from the cache and last known location - no network before the first frame
+        std::cout << "Loading solar times..." << std::endl;
+        SolarTimes* cachedToday = solarCache.find(getCurrentDay());
+        if (cachedToday && cachedToday->valid) {
+            todaysSolarTimes = *cachedToday;
+        } else if (!computeSolarTimesForDate(getCurrentDate(), todaysSolarTimes)) {
+            useFallbackSolarTimes();
+        }
         std::cout << "Generating color schedule..." << std::endl;
         generateTodaysColors();
 
         int updateCount = 0;
         std::string lastDate = getCurrentDate();
-        sf::Clock updateClock;
+        TimeSource::TimePoint lastStatusUpdate = clock->now();
 
         // Do initial render and set initial accent color
         std::cout << "Rendering initial frame..." << std::endl;
         updateDisplay();
         updateCount++;
 
+        long firstFrameMs = millisecondsSinceStartup();
+        std::cout << "First frame after " << firstFrameMs << " ms" << std::endl;
+        logMessage("First frame after " + std::to_string(firstFrameMs) + " ms");
+
+        // Resolve geolocation and refresh solar data in the background
+        // In api mode the bootstrap fetches only the days the cache window is missing
+        if (config.solar_source == "api" && shouldUpdateCache()) {
+            queueApiDays(solarWindowFor(config).daysToRefresh(solarCache, getCurrentDay()));
+        }
+        startBackgroundWork(true);
+
         Color initialColor = getCurrentColor();
         setWindowsAccentColor(initialColor);
-        lastAccentColorUpdate = time(0);
+        lastAccentColorUpdate = std::chrono::system_clock::to_time_t(clock->now());
 
         std::cout << "\nEntering main loop..." << std::endl;
 
+        // Stats are dumped on real time so a warped clock does not flood the file
+        std::chrono::steady_clock::time_point lastStatsDump = std::chrono::steady_clock::now();
+        TimeSource::TimePoint runStart = clock->now();
+        long loopCount = 0;
+        int dayRollovers = 0;
+        if (frameStats.isEnabled()) {
+            std::cout << "Frame stats enabled, writing " << frameStats.getDumpPath() << " every "
+                      << kStatsDumpIntervalSeconds << " seconds" << std::endl;
+        }
+
         bool shouldRun = true;
-        while (shouldRun) {
+        while (shouldRun && clock->now() < stopAt) {
+            loopCount++;
+            int64_t loopStart = frameStats.start();
+            int64_t eventsStart = loopStart;
+
             // Handle SFML events for all windows
             for (auto& m : monitors) {
                 if (m.window && m.window->isOpen()) {
@@ -1203,6 +1896,7 @@ public:
                 TranslateMessage(&msg);
                 DispatchMessage(&msg);
             }
+            frameStats.stop(FrameStats::STAGE_EVENTS, eventsStart);
             
             try {
                 // Check if we just woke up from sleep
@@ -1214,12 +1908,12 @@ public:
                     std::string today = getCurrentDate();
                     loadSolarCache();
 
-                    SolarTimes* todaysData = findCachedDataForDate(today);
+                    SolarTimes* todaysData = solarCache.find(getCurrentDay());
                     if (todaysData && todaysData->valid) {
                         todaysSolarTimes = *todaysData;
                         logMessage("Using cached solar data after wake (source: " + todaysData->source + ")");
                     } else {
-                        // Use any available cached data as backup from the 8-day cache
+                        // Use any available cached data from the window as backup
                         bool foundBackup = false;
                         for (size_t i = 0; i < solarCache.days.size(); i++) {
                             if (solarCache.days[i].valid) {
@@ -1242,6 +1936,18 @@ public:
                     forceUpdate = true;
                     g_justWokeUp = false;
                 }
+
+                // Swap in the refined location and schedule once the bootstrap is done
+                if (applyBootstrapResult()) {
+                    generateTodaysColors();
+                    forceUpdate = true;
+                }
+
+                // Pick up theme edits without a restart
+                if (reloadThemeIfChanged()) {
+                    generateTodaysColors();
+                    forceUpdate = true;
+                }
                 
                 // Check if we need to refresh solar times (new day)
                 std::string currentDate = getCurrentDate();
@@ -1250,22 +1956,23 @@ public:
                     fetchSolarTimes();
                     generateTodaysColors();
                     lastDate = currentDate;
+                    dayRollovers++;
                     forceUpdate = true;
                 }
 
                 // Check if it's time for periodic update (every 15 seconds)
-                if (updateClock.getElapsedTime().asSeconds() >= 15.0f) {
+                if (clock->now() - lastStatusUpdate >= std::chrono::seconds(UpdateScheduler::kStatusIntervalSeconds)) {
                     forceUpdate = true;
-                    updateClock.restart();
+                    lastStatusUpdate = clock->now();
                 }
 
-                // Always render, but only log on updates
+                // Always render (a cache hit unless the colors moved), but only log on updates
                 updateDisplay();
                 if (forceUpdate) {
                     updateCount++;
 
                     if (config.debug_mode || updateCount % 1 == 0) { // Show status updates
-                        time_t now = time(0);
+                        time_t now = currentTime();
                         tm* timeinfo = localtime(&now);
                         Color currentColor = getCurrentColor();
                         std::string period = getCurrentPeriod();
@@ -1276,7 +1983,10 @@ public:
                                                + " | RGB(" + std::to_string(currentColor.r) + ", "
                                                + std::to_string(currentColor.g) + ", "
                                                + std::to_string(currentColor.b) + ")"
-                                               + " | Source: " + todaysSolarTimes.source;
+                                               + " | Source: " + todaysSolarTimes.source
+                                               + " | Render cache: " + std::to_string(renderCacheHits) + " hit / "
+                                               + std::to_string(renderCacheMisses) + " miss"
+                                               + " | Wakeups: " + std::to_string(wakeupCount);
 
                         std::cout << statusMsg << std::endl;
                         logMessage(statusMsg);
@@ -1284,43 +1994,120 @@ public:
                 }
 
                 // Check if it's time to update Windows accent color (every 30 minutes)
-                time_t now = time(0);
-                if (difftime(now, lastAccentColorUpdate) >= 1800) { // 30 minutes = 1800 seconds
+                time_t now = std::chrono::system_clock::to_time_t(clock->now());
+                if (difftime(now, lastAccentColorUpdate) >= UpdateScheduler::kAccentIntervalSeconds) {
+                    FrameStats::Scope timed(frameStats, FrameStats::STAGE_ACCENT);
                     Color currentColor = getCurrentColor();
                     setWindowsAccentColor(currentColor);
                     lastAccentColorUpdate = now;
                 }
 
-                // Small sleep to prevent high CPU usage
-                std::this_thread::sleep_for(std::chrono::milliseconds(16)); // ~60fps
+                frameStats.stop(FrameStats::STAGE_LOOP, loopStart);
+                if (frameStats.isEnabled()
+                    && std::chrono::steady_clock::now() - lastStatsDump >= std::chrono::seconds(kStatsDumpIntervalSeconds)) {
+                    if (!frameStats.dump()) logMessage("Failed to write frame stats to " + frameStats.getDumpPath());
+                    std::cout << frameStats.summary();
+                    lastStatsDump = std::chrono::steady_clock::now();
+                }
+
+                // Sleep until the next visible change; window and power messages wake us early
+                waitUntil(std::min(stopAt, scheduler.nextDeadline(getSchedule(), lastStatusUpdate,
+                                                                  std::chrono::system_clock::from_time_t(lastAccentColorUpdate))));
                 
             } catch (const std::exception& e) {
-                std::string errorMsg = "Error in main loop: " + std::string(e.what());
-                logMessage(errorMsg);
+                logger.log(AsyncLogger::LOG_ERROR, "Error in main loop: {}", e.what());
                 std::this_thread::sleep_for(std::chrono::minutes(1));
             }
         }
+
+        if (simulatedClock) reportSimulatedRun(runStart, loopCount, dayRollovers, updateCount);
+    }
+
+    // Throughput of a --time-warp or --replay run, followed by the frame timings
+    void reportSimulatedRun(TimeSource::TimePoint runStart, long loopCount, int dayRollovers, int updateCount) {
+        double simulatedHours = std::chrono::duration<double>(clock->now() - runStart).count() / 3600.0;
+        double realSeconds = millisecondsSinceStartup() / 1000.0;
+
+        std::stringstream report;
+        report << std::fixed << std::setprecision(2)
+               << "Simulated " << simulatedHours << " h (" << formatTimePoint(runStart) << " to "
+               << formatTimePoint(clock->now()) << ") in " << realSeconds << " s real time\n"
+               << "Loop iterations: " << loopCount << ", status updates: " << updateCount
+               << ", day rollovers: " << dayRollovers << ", wakeups: " << wakeupCount << "\n"
+               << "Render cache: " << renderCacheHits << " hit / " << renderCacheMisses << " miss\n";
+        std::cout << "\n" << report.str() << frameStats.summary();
+        logMessage(report.str());
+
+        if (!frameStats.dump()) {
+            std::cout << "Failed to write frame stats to " << frameStats.getDumpPath() << std::endl;
+        } else {
+            std::cout << "Frame stats written to " << frameStats.getDumpPath() << std::endl;
+        }
     }
 
+    // Info-level line; the text is copied into the log record, truncated to
+    // what the record holds. Hot paths should call logger.log with a literal
+    // format and raw arguments instead of building a string.
     void logMessage(const std::string& message) {
-        // Logging disabled to prevent large log files with 15-second updates
-        // Re-enable this function if debugging is needed
-        (void)message; // Suppress unused parameter warning
+        logger.log(AsyncLogger::LOG_INFO, "{}", message);
+    }
+
+    // Opens log.txt next to config.ini at the configured level (log_replay.txt
+    // for simulated runs); messages logged while reading the config are
+    // already queued and go first
+    void startLogger() {
+        AsyncLogger::Level level = AsyncLogger::LOG_INFO;
+        bool levelValid = AsyncLogger::parseLevel(config.log_level, level);
+
+        std::string logPath = getConfigPath();
+        size_t lastSlash = logPath.find_last_of("\\/");
+        logPath = (lastSlash != std::string::npos ? logPath.substr(0, lastSlash + 1) : "")
+                + (simulatedClock ? "log_replay.txt" : "log.txt");
+        logger.start(logPath, level, static_cast<size_t>(std::max(0, config.log_max_kb)) * 1024, config.log_keep);
+
+        if (!levelValid) {
+            logger.log(AsyncLogger::LOG_WARN, "Unknown log_level '{}', using info", config.log_level);
+        }
     }
 
 };
 
+// Benchmark cases for the Windows-only path: the mapped solar cache file
+static void addWindowsBenchmarks(BenchmarkSuite& suite, const std::string& scratchPath) {
+    SolarCache cache = BenchmarkSuite::sampleSolarWindow();
+    std::string cachePath = scratchPath + ".cache.bin";
+    suite.add("saveSolarCache", [&] { return SolarCacheFile::save(cachePath, cache) ? 1 : 0; });
+    suite.add("loadSolarCache", [&] {
+        SolarCache loaded;
+        return SolarCacheFile::load(cachePath, loaded) ? loaded.days.size() : 0;
+    });
+    std::remove(cachePath.c_str());
+}
+
 int main(int argc, char* argv[]) {
     // Set DPI awareness to prevent scaling issues on high-DPI displays
     SetProcessDPIAware();
 
-    TimeWallpaper app;
-    
     if (argc > 1) {
         std::string mode = argv[1];
         if (mode == "--help" || mode == "-h") {
             std::cout << "\nUsage:" << std::endl;
             std::cout << "  TimeWallpaper.exe              - Run fullscreen color overlay based on solar position" << std::endl;
+            std::cout << "  TimeWallpaper.exe --benchmark [file]" << std::endl;
+            std::cout << "                                 - Time the hot paths and write JSON results (default benchmark.json)" << std::endl;
+            std::cout << "  TimeWallpaper.exe --export day|year [file]" << std::endl;
+            std::cout << "                                 - Write per-second colors as CSV (.csv) or columnar binary" << std::endl;
+            std::cout << "  TimeWallpaper.exe --batch sites.csv [file]" << std::endl;
+            std::cout << "                                 - Colors now and in an hour for each site_id,latitude,longitude,zone row" << std::endl;
+            std::cout << "                                   (zone: UTC offset or Windows zone name), as CSV (.csv) or binary" << std::endl;
+            std::cout << "  TimeWallpaper.exe --stats      - Run with per-stage frame timings (frame_stats.txt)" << std::endl;
+            std::cout << "  TimeWallpaper.exe --time-warp factor" << std::endl;
+            std::cout << "                                 - Run from now with the clock going factor times faster, with frame timings" << std::endl;
+            std::cout << "  TimeWallpaper.exe --replay start end [factor]" << std::endl;
+            std::cout << "                                 - Run the loop over a local time range (YYYY-MM-DD[THH:MM[:SS]]) and exit;" << std::endl;
+            std::cout << "                                   factor 0 (default) steps between deadlines without sleeping" << std::endl;
+            std::cout << "                                 - Simulated runs use log_replay.txt and solar_cache_replay.bin and leave" << std::endl;
+            std::cout << "                                   config.ini, the accent color and the color feed alone" << std::endl;
             std::cout << "  TimeWallpaper.exe --help       - Show this help" << std::endl;
             std::cout << "\nFeatures:" << std::endl;
             std::cout << "  • Fullscreen SFML overlay (fast, no wallpaper API calls)" << std::endl;
@@ -1329,14 +2116,63 @@ int main(int argc, char* argv[]) {
             std::cout << "  • Real-time color transitions based on sun position" << std::endl;
             std::cout << "  • Transparent watermark support (Watermark.png)" << std::endl;
             std::cout << "  • Wake from sleep detection - updates immediately on resume" << std::endl;
+            std::cout << "  • Live color published to other programs through shared memory (timewallpaper_feed.h)" << std::endl;
             std::cout << "  • All output is logged to log.txt file" << std::endl;
             std::cout << "\nControls:" << std::endl;
             std::cout << "  ESC - Exit application" << std::endl;
-            std::cout << "\nEdit config.ini to set manual location coordinates if needed." << std::endl;
+            std::cout << "\nconfig.ini (next to the exe, created on first run):" << std::endl;
+            std::cout << "  latitude, longitude, location_name, auto_detect_location - location and its fallback" << std::endl;
+            std::cout << "  debug_mode - verbose output and daily_colors.csv" << std::endl;
+            std::cout << "  solar_source=computed|api, api_deadline_ms, verify_with_api - where solar times come from" << std::endl;
+            std::cout << "  solar_cache_days, solar_max_age_days - days cached ahead and when a cached day is refreshed" << std::endl;
+            std::cout << "  theme_file, dither_mode=bayer|blue_noise, render_threads, tiled_gradient - look and rendering" << std::endl;
+            std::cout << "  log_level=debug|info|warn|error|off, log_max_kb, log_keep - log.txt level and rotation" << std::endl;
+            std::cout << "  See README.md or the comments at the top of config.ini for details." << std::endl;
             return 0;
         }
+        if (mode == "--benchmark") {
+            return BenchmarkSuite::runAll(argc > 2 ? argv[2] : "benchmark.json", addWindowsBenchmarks);
+        }
+        if (mode == "--export") {
+            std::string range = argc > 2 ? argv[2] : "day";
+            std::string defaultPath = range == "year" ? "colors_year.bin" : "colors_day.csv";
+            return TimeWallpaper::exportColors(range, argc > 3 ? argv[3] : defaultPath);
+        }
+        if (mode == "--batch") {
+            if (argc < 3) {
+                std::cout << "Usage: TimeWallpaper.exe --batch sites.csv [file]" << std::endl;
+                return 1;
+            }
+            return TimeWallpaper::runBatch(argv[2], argc > 3 ? argv[3] : "batch_colors.bin");
+        }
     }
-    
-    app.run();
+
+    // Simulated clock for --time-warp and --replay; these always record frame timings
+    std::unique_ptr<SimulatedTimeSource> simulatedClock;
+    TimeSource::TimePoint stopAt = TimeSource::TimePoint::max();
+    if (argc > 1 && std::string(argv[1]) == "--time-warp") {
+        double factor = argc > 2 ? strtod(argv[2], nullptr) : 0.0;
+        if (factor <= 0.0) {
+            std::cout << "Usage: TimeWallpaper.exe --time-warp factor (factor > 0)" << std::endl;
+            return 1;
+        }
+        simulatedClock = std::make_unique<SimulatedTimeSource>(std::chrono::system_clock::now(), factor);
+    } else if (argc > 1 && std::string(argv[1]) == "--replay") {
+        TimeSource::TimePoint start;
+        double factor = argc > 4 ? strtod(argv[4], nullptr) : 0.0;
+        if (argc < 4 || !SimulatedTimeSource::parseLocal(argv[2], start)
+            || !SimulatedTimeSource::parseLocal(argv[3], stopAt) || stopAt <= start || factor < 0.0) {
+            std::cout << "Usage: TimeWallpaper.exe --replay start end [factor] (YYYY-MM-DD[THH:MM[:SS]], end after start)" << std::endl;
+            return 1;
+        }
+        simulatedClock = std::make_unique<SimulatedTimeSource>(start, factor);
+    }
+
+    bool simulated = simulatedClock != nullptr;
+    TimeWallpaper app(std::move(simulatedClock));
+    if (simulated || (argc > 1 && std::string(argv[1]) == "--stats")) {
+        app.enableFrameStats();
+    }
+    app.run(stopAt);
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,111 @@
+// AccentWorker against a sink that blocks until the test lets it go, as a
+// slow registry write or broadcast would: submit() returns while the sink is
+// stuck, colors submitted meanwhile coalesce to the latest, and a color equal
+// to the last one applied is skipped.
+#include "timewallpaper_core.h"
+#include "check.h"
+
+// Records each color and holds apply() until released
+class GatedSink : public AccentSink {
+public:
+    struct Gate {
+        std::mutex mutex;
+        std::condition_variable changed;
+        bool open = false;
+        int entered = 0;
+        std::vector<Color> applied;
+    };
+
+    explicit GatedSink(Gate& gate) : gate(gate) {}
+
+    void apply(const Color& accentColor) override {
+        std::unique_lock<std::mutex> lock(gate.mutex);
+        gate.entered++;
+        gate.changed.notify_all();
+        gate.changed.wait(lock, [this] { return gate.open; });
+        gate.applied.push_back(accentColor);
+    }
+
+private:
+    Gate& gate;
+};
+
+static void setOpen(GatedSink::Gate& gate, bool open) {
+    std::lock_guard<std::mutex> lock(gate.mutex);
+    gate.open = open;
+    gate.changed.notify_all();
+}
+
+static bool waitEntered(GatedSink::Gate& gate, int count) {
+    std::unique_lock<std::mutex> lock(gate.mutex);
+    return gate.changed.wait_for(lock, std::chrono::seconds(5), [&] { return gate.entered >= count; });
+}
+
+int main() {
+    GatedSink::Gate gate;
+    std::thread release;
+    {
+        AccentWorker worker(std::make_unique<GatedSink>(gate));
+
+        // The first color reaches the sink, which then blocks
+        worker.submit(Color(10, 20, 30));
+        CHECK(waitEntered(gate, 1));
+
+        // A minute of per-second updates while the sink is stuck: every
+        // submit returns at once and none reaches the sink yet
+        auto start = std::chrono::steady_clock::now();
+        for (int second = 0; second < 60; second++) worker.submit(Color(static_cast<unsigned char>(second), 100, 200));
+        double submitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "60 submits against a blocked sink took " << submitMs << " ms" << std::endl;
+        CHECK(submitMs < 100.0);
+        {
+            std::lock_guard<std::mutex> lock(gate.mutex);
+            CHECK_EQ(gate.entered, 1);
+            CHECK(gate.applied.empty());
+        }
+
+        // Released, the sink sees the first color and then only the latest
+        setOpen(gate, true);
+        worker.flush();
+        {
+            std::lock_guard<std::mutex> lock(gate.mutex);
+            CHECK_EQ(gate.applied.size(), static_cast<size_t>(2));
+            CHECK(gate.applied.size() == 2 && gate.applied[0] == Color(10, 20, 30));
+            CHECK(gate.applied.size() == 2 && gate.applied[1] == Color(59, 100, 200));
+        }
+        AccentWorker::Stats stats = worker.getStats();
+        CHECK_EQ(stats.submitted, 61UL);
+        CHECK_EQ(stats.applied, 2UL);
+
+        // Resubmitting the color already applied does not touch the sink
+        worker.submit(Color(59, 100, 200));
+        worker.flush();
+        stats = worker.getStats();
+        CHECK_EQ(stats.applied, 2UL);
+        CHECK_EQ(stats.unchanged, 1UL);
+        CHECK_EQ(gate.entered, 2);
+
+        // A change applies once; flush returns with the sink idle
+        worker.submit(Color(1, 2, 3));
+        worker.submit(Color(1, 2, 3));
+        worker.flush();
+        stats = worker.getStats();
+        CHECK_EQ(stats.applied, 3UL); // the repeat coalesced or was skipped
+        CHECK(gate.applied.back() == Color(1, 2, 3));
+
+        // Shutting down with the sink blocked and a color pending: the
+        // destructor waits for the call in progress and drops the rest
+        setOpen(gate, false);
+        worker.submit(Color(4, 5, 6));
+        CHECK(waitEntered(gate, 4));
+        worker.submit(Color(7, 8, 9));
+        release = std::thread([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            setOpen(gate, true);
+        });
+    }
+    release.join();
+    std::lock_guard<std::mutex> lock(gate.mutex);
+    CHECK(gate.applied.back() == Color(4, 5, 6));
+    return checkResult();
+}
@@ -0,0 +1,40 @@
+// Minimal assertions for the test executables: CHECK records a failure and
+// keeps going, and main returns checkResult() so ctest sees the outcome.
+#ifndef TIMEWALLPAPER_TESTS_CHECK_H
+#define TIMEWALLPAPER_TESTS_CHECK_H
+
+#include <iostream>
+
+inline int& checkFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed" << std::endl; \
+            checkFailures()++; \
+        } \
+    } while (0)
+
+#define CHECK_EQ(actual, expected) \
+    do { \
+        auto checkActual = (actual); \
+        auto checkExpected = (expected); \
+        if (!(checkActual == checkExpected)) { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK_EQ(" #actual ", " #expected ") failed: " \
+                      << checkActual << " != " << checkExpected << std::endl; \
+            checkFailures()++; \
+        } \
+    } while (0)
+
+inline int checkResult() {
+    if (checkFailures() > 0) {
+        std::cerr << checkFailures() << " check(s) failed" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+#endif // TIMEWALLPAPER_TESTS_CHECK_H
@@ -0,0 +1,108 @@
+// The color feed's sequence lock with the feed in ordinary process memory:
+// one thread publishes snapshots as fast as it can while readers check that
+// every snapshot they get is whole (all fields from the same publish) and
+// never older than the one before. Also an uninitialized feed and a writer
+// stuck mid-update.
+#include "timewallpaper_core.h"
+#include "timewallpaper_feed.h"
+#include "check.h"
+
+// Every field is derived from n, so a mix of two publishes shows
+static twf_snapshot snapshotFor(uint32_t n) {
+    twf_snapshot snapshot = {};
+    snapshot.updated_unix = 1700000000LL + n;
+    snapshot.color = n;
+    snapshot.next_color = ~n;
+    snapshot.local_hour = n * 0.5;
+    snapshot.next_keyframe_hour = n * 0.5 + 1.0;
+    snapshot.sunrise_hour = n + 0.25;
+    snapshot.sunset_hour = n + 0.75;
+    snapshot.solar_noon_hour = n + 0.5;
+    snapshot.civil_twilight_begin = n + 0.125;
+    snapshot.civil_twilight_end = n + 0.875;
+    std::snprintf(snapshot.period, sizeof(snapshot.period), "period-%u", n);
+    std::snprintf(snapshot.next_period, sizeof(snapshot.next_period), "next-%u", n);
+    return snapshot;
+}
+
+static bool whole(const twf_snapshot& snapshot) {
+    twf_snapshot expected = snapshotFor(snapshot.color);
+    return std::memcmp(&snapshot, &expected, sizeof(snapshot)) == 0;
+}
+
+int main() {
+    twf_feed* feed = new twf_feed();
+    twf_snapshot out;
+
+    // Not initialized yet: readers give up at once
+    CHECK_EQ(twf_read(feed, &out, 100), 0);
+
+    twf_init(feed);
+    CHECK_EQ(feed->size, static_cast<uint32_t>(sizeof(twf_feed)));
+    twf_snapshot first = snapshotFor(0);
+    twf_publish(feed, &first);
+    CHECK_EQ(twf_read(feed, &out, 1), 1);
+    CHECK(whole(out) && out.color == 0);
+
+    // A writer that never finishes its update: bounded retries, then 0
+    uint32_t sequence = feed->sequence;
+    feed->sequence = sequence + 1;
+    CHECK_EQ(twf_read(feed, &out, 1000), 0);
+    feed->sequence = sequence;
+
+    // One writer, several readers
+    const int kReaders = 3;
+    const auto runFor = std::chrono::milliseconds(600);
+    std::atomic<bool> done{false};
+    std::atomic<long> torn{0}, backwards{0}, reads{0}, misses{0};
+    std::atomic<uint32_t> published{0};
+
+    std::thread writer([&] {
+        uint32_t n = 0;
+        auto until = std::chrono::steady_clock::now() + runFor;
+        while (std::chrono::steady_clock::now() < until) {
+            for (int i = 0; i < 256; i++) {
+                twf_snapshot next = snapshotFor(++n);
+                twf_publish(feed, &next);
+            }
+        }
+        published = n;
+        done = true;
+    });
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < kReaders; r++) {
+        readers.emplace_back([&] {
+            uint32_t last = 0;
+            while (!done) {
+                twf_snapshot snapshot;
+                if (!twf_read(feed, &snapshot, 64)) {
+                    misses++;
+                    continue;
+                }
+                reads++;
+                if (!whole(snapshot)) torn++;
+                else if (snapshot.color < last) backwards++;
+                else last = snapshot.color;
+            }
+        });
+    }
+
+    writer.join();
+    for (std::thread& reader : readers) reader.join();
+
+    std::cout << published.load() << " publishes, " << reads.load() << " reads (" << misses.load()
+              << " gave up mid-update), " << torn.load() << " torn" << std::endl;
+    CHECK_EQ(torn.load(), 0L);
+    CHECK_EQ(backwards.load(), 0L);
+    CHECK(reads.load() > 0);
+    CHECK(published.load() > 0);
+
+    // The last publish is what a reader sees once the writer is done
+    CHECK_EQ(twf_read(feed, &out, 1), 1);
+    CHECK(whole(out) && out.color == published.load());
+    CHECK_EQ(feed->sequence % 2, 0u);
+
+    delete feed;
+    return checkResult();
+}
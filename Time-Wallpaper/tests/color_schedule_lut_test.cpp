@@ -0,0 +1,231 @@
+// The lookup table against the original per-call getColorForHour, kept
+// here as the reference: every second of the day must give the same color
+// and period, bit for bit, across a sweep of sunrise, noon and sunset times.
+//
+// The reference looks up the keyframes the schedule compiles from the
+// built-in theme. Those are checked separately against the original
+// hard-coded list: same colors and periods in the same order, at the same
+// hours to within rounding (the theme adds flat offsets to each anchor where
+// the original chained +0.1 steps). The original double blend is checked to
+// stay within the one step that the 16.16 fixed-point blend may move it.
+#include "timewallpaper_core.h"
+#include "check.h"
+
+namespace original {
+
+struct ColorPoint {
+    double hour;
+    Color color;
+    std::string period;
+};
+
+typedef Color (*BlendFn)(Color start, Color end, double ratio);
+
+Color doubleInterpolateColor(Color start, Color end, double ratio) {
+    ratio = std::max(0.0, std::min(1.0, ratio));
+
+    int r = static_cast<int>(start.r * (1 - ratio) + end.r * ratio);
+    int g = static_cast<int>(start.g * (1 - ratio) + end.g * ratio);
+    int b = static_cast<int>(start.b * (1 - ratio) + end.b * ratio);
+
+    return Color(r, g, b);
+}
+
+Color fixedInterpolateColor(Color start, Color end, double ratio) {
+    return ::interpolateColor(start, end, ratio);
+}
+
+// The hard-coded keyframes, in the order they were pushed
+std::vector<ColorPoint> hardCodedPoints(const SolarTimes& todaysSolarTimes) {
+    double sunrise = todaysSolarTimes.sunrise_hour;
+    double sunset = todaysSolarTimes.sunset_hour;
+    double solar_noon = todaysSolarTimes.solar_noon_hour;
+
+    std::vector<ColorPoint> points;
+
+    points.push_back({0.0, Color(8, 8, 25), "Deep Night"});
+    points.push_back({std::max(1.0, sunrise - 3.0), Color(10, 10, 25), "Pre-Dawn"});
+    points.push_back({std::max(2.0, sunrise - 1.5), Color(15, 15, 45), "Early Dawn"});
+    points.push_back({std::max(3.0, sunrise - 1.0), Color(25, 15, 65), "Early Dawn"});
+    points.push_back({std::max(4.0, sunrise - 0.5), Color(50, 30, 65), "Dawn"});
+    points.push_back({std::max(5.0, sunrise - 0.25), Color(120, 80, 110), "Dawn"});
+
+    points.push_back({std::max(6.0, sunrise), Color(160, 120, 130), "Sunrise"});
+    points.push_back({std::max(7.0, sunrise + 0.25), Color(190, 150, 140), "Sunrise"});
+    points.push_back({std::max(8.0, sunrise + 0.5), Color(210, 180, 160), "Early Morning"});
+    points.push_back({std::max(9.0, sunrise + 1.0), Color(220, 200, 180), "Early Morning"});
+    points.push_back({std::max(10.0, sunrise + 2.0), Color(230, 240, 220), "Morning"});
+
+    points.push_back({std::max(11.0, solar_noon - 1.5), Color(210, 230, 200), "Late Morning"});
+    points.push_back({std::max(11.5, solar_noon - 1.0), Color(190, 220, 190), "Late Morning"});
+    points.push_back({std::max(12.0, solar_noon), Color(170, 210, 230), "Noon"});
+    points.push_back({std::max(13.0, solar_noon + 1.0), Color(170, 210, 230), "Early Afternoon"});
+    points.push_back({std::max(14.0, solar_noon + 1.5), Color(170, 210, 230), "Early Afternoon"});
+
+    double late_afternoon_start = sunset - 2.0;
+    double pre_sunset_start = sunset - 1.5;
+    double pre_sunset_mid = sunset - 1.0;
+    double pre_sunset_end = sunset - 0.5;
+    double sunset_time = sunset;
+
+    points.push_back({late_afternoon_start, Color(170, 210, 230), "Late Afternoon"});
+    points.push_back({pre_sunset_start, Color(170, 210, 230), "Late Afternoon"});
+    points.push_back({pre_sunset_mid, Color(175, 200, 225), "Pre-Sunset"});
+    points.push_back({pre_sunset_end, Color(180, 195, 220), "Pre-Sunset"});
+    points.push_back({sunset_time, Color(230, 140, 70), "Sunset"});
+
+    double post_sunset_1 = sunset_time + 0.1;
+    double post_sunset_2 = post_sunset_1 + 0.1;
+    double post_sunset_3 = post_sunset_2 + 0.1;
+    double twilight_1 = post_sunset_3 + 0.1;
+    double twilight_2 = twilight_1 + 0.1;
+    double twilight_3 = twilight_2 + 0.1;
+
+    points.push_back({post_sunset_1, Color(210, 120, 70), "Sunset"});
+    points.push_back({post_sunset_2, Color(170, 100, 75), "Post-Sunset"});
+    points.push_back({post_sunset_3, Color(140, 90, 80), "Post-Sunset"});
+    points.push_back({twilight_1, Color(110, 80, 85), "Civil Twilight"});
+    points.push_back({twilight_2, Color(95, 75, 95), "Civil Twilight"});
+    points.push_back({twilight_3, Color(80, 65, 85), "Civil Twilight"});
+
+    double evening_start = twilight_3 + 0.1;
+    points.push_back({evening_start, Color(65, 60, 75), "Evening"});
+    points.push_back({evening_start + 0.25, Color(65, 55, 70), "Evening"});
+    points.push_back({evening_start + 0.5, Color(60, 50, 70), "Evening"});
+    points.push_back({evening_start + 0.75, Color(50, 45, 65), "Evening"});
+    points.push_back({evening_start + 1.0, Color(45, 40, 65), "Evening"});
+    points.push_back({evening_start + 1.25, Color(40, 35, 60), "Evening"});
+    points.push_back({evening_start + 1.5, Color(35, 30, 55), "Evening"});
+    points.push_back({evening_start + 1.75, Color(32, 28, 52), "Late Evening"});
+    points.push_back({evening_start + 2.25, Color(32, 22, 48), "Late Evening"});
+    points.push_back({evening_start + 2.75, Color(22, 17, 42), "Late Evening"});
+    points.push_back({evening_start + 3.25, Color(15, 12, 35), "Night"});
+    points.push_back({23.99, Color(8, 8, 20), "Night"});
+
+    return points;
+}
+
+// The same keyframes as the schedule builds them from the built-in theme
+std::vector<ColorPoint> themePoints(const SolarTimes& solarTimes) {
+    const ColorTheme& theme = *ColorTheme::builtIn();
+    std::vector<ColorPoint> points;
+    for (const ColorTheme::Stop& stop : theme.getStops()) {
+        double hour = ColorTheme::anchorHour(stop.anchor, solarTimes) + stop.offsetHours;
+        if (stop.notBeforeHour >= 0) hour = std::max(stop.notBeforeHour, hour);
+        points.push_back({ hour, stop.color, theme.periodName(stop.period) });
+    }
+    return points;
+}
+
+Color getColorForHour(std::vector<ColorPoint> points, double hour, std::string* outPeriod, BlendFn interpolateColor) {
+    // Normalize hour to 0-24 range
+    while (hour < 0) hour += 24.0;
+    while (hour >= 24) hour -= 24.0;
+
+    // Fix times outside 0-24 range
+    for (auto& point : points) {
+        while (point.hour < 0) point.hour += 24.0;
+        while (point.hour >= 24) point.hour -= 24.0;
+    }
+
+    // Sort points by time
+    std::sort(points.begin(), points.end(),
+              [](const ColorPoint& a, const ColorPoint& b) {
+                  return a.hour < b.hour;
+              });
+
+    // Find the appropriate color interpolation
+    for (size_t i = 0; i < points.size() - 1; i++) {
+        if (hour >= points[i].hour && hour <= points[i + 1].hour) {
+            double progress = (hour - points[i].hour) / (points[i + 1].hour - points[i].hour);
+            if (outPeriod) *outPeriod = points[i].period;
+            return interpolateColor(points[i].color, points[i + 1].color, progress);
+        }
+    }
+
+    // Handle wrap-around (from last point to first point)
+    double lastHour = points.back().hour;
+    double firstHour = points.front().hour + 24;
+
+    if (hour >= lastHour) {
+        double progress = (hour - lastHour) / (firstHour - lastHour);
+        if (outPeriod) *outPeriod = points.back().period;
+        return interpolateColor(points.back().color, points.front().color, progress);
+    }
+
+    if (outPeriod) *outPeriod = points.front().period;
+    return points.front().color;
+}
+
+int channelDistance(Color a, Color b) {
+    return std::max({ std::abs(a.r - b.r), std::abs(a.g - b.g), std::abs(a.b - b.b) });
+}
+
+// Distance between two hours on the 24-hour circle
+double hourDistance(double a, double b) {
+    double distance = std::fmod(std::fabs(a - b), 24.0);
+    return std::min(distance, 24.0 - distance);
+}
+
+} // namespace original
+
+int main() {
+    const double sunrises[] = { 1.5, 4.0, 5.1, 6.3, 7.4, 8.5 };
+    const double sunsets[] = { 16.0, 17.3, 18.6, 19.9, 21.2, 22.8 };
+
+    int days = 0, mismatches = 0, keyframeMismatches = 0, maxDoubleDistance = 0;
+    for (double sunrise : sunrises) {
+        for (double sunset : sunsets) {
+            SolarTimes solarTimes;
+            solarTimes.sunrise_hour = sunrise;
+            solarTimes.sunset_hour = sunset;
+            solarTimes.solar_noon_hour = (sunrise + sunset) / 2.0;
+            solarTimes.civil_twilight_begin = sunrise - 0.5;
+            solarTimes.civil_twilight_end = sunset + 0.5;
+            solarTimes.valid = true;
+            days++;
+
+            std::vector<original::ColorPoint> hardCoded = original::hardCodedPoints(solarTimes);
+            std::vector<original::ColorPoint> keyframes = original::themePoints(solarTimes);
+            CHECK_EQ(keyframes.size(), hardCoded.size());
+            for (size_t i = 0; i < std::min(keyframes.size(), hardCoded.size()); i++) {
+                if (!(keyframes[i].color == hardCoded[i].color) || keyframes[i].period != hardCoded[i].period
+                    || original::hourDistance(keyframes[i].hour, hardCoded[i].hour) > 1e-9) {
+                    keyframeMismatches++;
+                }
+            }
+
+            ColorSchedule schedule;
+            schedule.build(solarTimes);
+
+            for (int second = 0; second < 24 * 3600; second++) {
+                // Same hour arithmetic as the tm-based callers
+                double hour = (second / 3600) + (((second / 60) % 60) / 60.0) + ((second % 60) / 3600.0);
+                std::string expectedPeriod;
+                Color expected = original::getColorForHour(keyframes, hour, &expectedPeriod, original::fixedInterpolateColor);
+
+                PeriodId period;
+                Color actual = schedule.colorAtSecond(second, &period);
+                if (!(actual == expected) || expectedPeriod != schedule.periodName(period)) {
+                    if (mismatches++ < 10) {
+                        std::cerr << "sunrise " << sunrise << " sunset " << sunset << " second " << second
+                                  << ": (" << int(actual.r) << "," << int(actual.g) << "," << int(actual.b) << ") "
+                                  << schedule.periodName(period) << " != (" << int(expected.r) << ","
+                                  << int(expected.g) << "," << int(expected.b) << ") " << expectedPeriod << std::endl;
+                    }
+                }
+
+                if (second % 7 == 0) {
+                    Color doubleBlend = original::getColorForHour(keyframes, hour, nullptr, original::doubleInterpolateColor);
+                    maxDoubleDistance = std::max(maxDoubleDistance, original::channelDistance(expected, doubleBlend));
+                }
+            }
+        }
+    }
+
+    CHECK_EQ(days, 36);
+    CHECK_EQ(keyframeMismatches, 0);
+    CHECK_EQ(mismatches, 0);
+    CHECK(maxDoubleDistance <= 1);
+    return checkResult();
+}
@@ -0,0 +1,138 @@
+// ConcurrentFetcher against a loopback server that delays and fails
+// requests: retries, the overall deadline, the cap on requests in flight,
+// and that no worker is still running once the fetcher is gone.
+#include "timewallpaper_core.h"
+#include "check.h"
+#include "stub_server.h"
+
+static long elapsedMs(std::chrono::steady_clock::time_point since) {
+    return static_cast<long>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - since).count());
+}
+
+int main() {
+    // /ok answers after delay=<ms>, /flaky fails its first request with 500,
+    // /broken always fails and /drop closes the connection unanswered
+    std::mutex seenMutex;
+    std::map<std::string, int> seen;
+    StubServer server([&](const std::string& path) {
+        StubServer::Response response;
+        size_t delay = path.find("delay=");
+        if (delay != std::string::npos) response.delayMs = std::atoi(path.c_str() + delay + 6);
+
+        int count;
+        {
+            std::lock_guard<std::mutex> lock(seenMutex);
+            count = ++seen[path];
+        }
+        if (path.compare(0, 6, "/flaky") == 0 && count == 1) response.status = 500;
+        else if (path.compare(0, 7, "/broken") == 0) response.status = 500;
+        else if (path.compare(0, 5, "/drop") == 0) response.drop = true;
+        response.body = "{\"path\":\"" + path + "\"}";
+        return response;
+    });
+
+    auto client = std::make_shared<LoopbackHttpClient>(server.port());
+    std::atomic<int> active{0};
+    ConcurrentFetcher::Transport transport = [client, &active](const std::string& url, int timeoutMs) {
+        active++;
+        std::string body = client->get(url, timeoutMs);
+        active--;
+        return body;
+    };
+    // Like a client whose per-operation timeouts overshoot the budget it was
+    // given, so its requests run on past the deadline
+    ConcurrentFetcher::Transport overshooting = [client, &active](const std::string& url, int) {
+        active++;
+        std::string body = client->get(url, 5000);
+        active--;
+        return body;
+    };
+
+    {
+        // Eight days of 40 ms requests: all complete, four at a time
+        ConcurrentFetcher fetcher;
+        std::vector<std::string> urls;
+        for (int day = 0; day < 8; day++) urls.push_back(server.url("/ok?day=" + std::to_string(day) + "&delay=40"));
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<ConcurrentFetcher::Result> results = fetcher.fetchAll(urls, 3000, transport);
+        long took = elapsedMs(start);
+        CHECK_EQ(results.size(), urls.size());
+        for (size_t i = 0; i < results.size(); i++) {
+            CHECK(results[i].completed);
+            CHECK_EQ(results[i].attempts, 1);
+            CHECK(results[i].body.find("day=" + std::to_string(i) + "&") != std::string::npos);
+            CHECK(results[i].latencyMs >= 40 && results[i].latencyMs <= took);
+        }
+        CHECK(server.maxInFlight() <= ConcurrentFetcher::kDefaultConcurrency);
+        CHECK(server.maxInFlight() >= 2);
+        CHECK(took >= 80);   // at least two rounds under the cap
+        CHECK(took < 8 * 40); // faster than one at a time
+    }
+
+    {
+        // One retry: a single failure is recovered, two are not
+        ConcurrentFetcher fetcher;
+        std::vector<ConcurrentFetcher::Result> results =
+            fetcher.fetchAll({ server.url("/flaky?day=0"), server.url("/broken?day=1"), server.url("/drop?day=2") }, 3000, transport);
+        CHECK(results[0].completed);
+        CHECK_EQ(results[0].attempts, 2);
+        for (size_t i = 1; i < 3; i++) {
+            CHECK(!results[i].completed);
+            CHECK_EQ(results[i].attempts, ConcurrentFetcher::kMaxAttempts);
+            CHECK(results[i].body.empty());
+        }
+    }
+
+    {
+        // A hung request times out at the deadline; the others still count
+        ConcurrentFetcher fetcher;
+        auto start = std::chrono::steady_clock::now();
+        std::vector<ConcurrentFetcher::Result> results =
+            fetcher.fetchAll({ server.url("/ok?day=0"), server.url("/ok?day=1&delay=5000"), server.url("/ok?day=2") }, 300, transport);
+        long took = elapsedMs(start);
+        CHECK(took >= 290 && took < 1500);
+        CHECK(results[0].completed && results[2].completed);
+        CHECK(!results[1].completed);
+        CHECK(results[1].latencyMs >= 250 && results[1].latencyMs <= 350);
+    }
+
+    {
+        // Twelve 200 ms requests in 300 ms: the first four finish, the next
+        // four are still running at the deadline, the last four never start
+        long before = server.requestCount();
+        std::vector<ConcurrentFetcher::Result> results;
+        {
+            ConcurrentFetcher fetcher;
+            std::vector<std::string> urls;
+            for (int day = 0; day < 12; day++) urls.push_back(server.url("/ok?slow=" + std::to_string(day) + "&delay=200"));
+            results = fetcher.fetchAll(urls, 300, overshooting);
+            CHECK_EQ(active.load(), 4);
+        }
+        // The fetcher joined its workers on the way out
+        CHECK_EQ(active.load(), 0);
+        CHECK_EQ(server.requestCount() - before, 8L);
+
+        int completed = 0, started = 0;
+        for (const ConcurrentFetcher::Result& result : results) {
+            if (result.completed) completed++;
+            if (result.attempts > 0) started++;
+        }
+        CHECK_EQ(completed, 4);
+        CHECK_EQ(started, 4); // requests past the deadline report as never finished
+        for (size_t i = 4; i < results.size(); i++) CHECK_EQ(results[i].latencyMs, 300L);
+    }
+
+    {
+        // Stragglers from one batch are joined before the next one starts
+        ConcurrentFetcher fetcher;
+        fetcher.fetchAll({ server.url("/ok?straggler=0&delay=400") }, 100, overshooting);
+        CHECK_EQ(active.load(), 1);
+        std::vector<ConcurrentFetcher::Result> results = fetcher.fetchAll({ server.url("/ok?next=0") }, 3000, transport);
+        CHECK(results[0].completed);
+        CHECK_EQ(active.load(), 0);
+    }
+
+    CHECK_EQ(client->getStats().requests, client->getStats().connectionsOpened);
+    return checkResult();
+}
@@ -0,0 +1,86 @@
+// SocketHttpClient against a loopback server that counts the connections it
+// accepts: sequential and concurrent requests reuse pooled connections, and
+// closed, dropped and timed-out connections are replaced.
+#include "timewallpaper_core.h"
+#include "timewallpaper_socket_http.h"
+#include "check.h"
+#include "stub_server.h"
+
+int main() {
+    // /close answers with Connection: close, /stale drops its first request,
+    // /chunked answers in chunks, /error with 500 and /slow after 500 ms
+    std::mutex seenMutex;
+    std::map<std::string, int> seen;
+    StubServer server([&](const std::string& path) {
+        StubServer::Response response;
+        int count;
+        {
+            std::lock_guard<std::mutex> lock(seenMutex);
+            count = ++seen[path];
+        }
+        response.body = "{\"path\":\"" + path + "\",\"status\":\"OK\"}";
+        if (path.compare(0, 6, "/close") == 0) response.close = true;
+        else if (path.compare(0, 6, "/stale") == 0 && count == 1) response.drop = true;
+        else if (path.compare(0, 8, "/chunked") == 0) response.chunked = true;
+        else if (path.compare(0, 6, "/error") == 0) response.status = 500;
+        else if (path.compare(0, 5, "/slow") == 0) response.delayMs = 500;
+        else if (path.compare(0, 6, "/batch") == 0) response.delayMs = 30;
+        return response;
+    });
+
+    SocketHttpClient client;
+
+    // An eight-day refresh one request at a time: one connection
+    for (int day = 0; day < 8; day++) {
+        std::string path = "/json?day=" + std::to_string(day);
+        CHECK_EQ(client.get(server.url(path), 2000), "{\"path\":\"" + path + "\",\"status\":\"OK\"}");
+    }
+    CHECK_EQ(server.connectionCount(), 1L);
+    CHECK_EQ(client.getStats().requests, 8L);
+    CHECK_EQ(client.getStats().connectionsOpened, 1L);
+
+    // Error statuses and chunked bodies leave the connection reusable
+    CHECK_EQ(client.get(server.url("/error"), 2000), "");
+    CHECK_EQ(client.get(server.url("/chunked?day=1"), 2000), "{\"path\":\"/chunked?day=1\",\"status\":\"OK\"}");
+    CHECK_EQ(server.connectionCount(), 1L);
+
+    // Connection: close retires the connection; the next request reconnects
+    CHECK(!client.get(server.url("/close"), 2000).empty());
+    CHECK(!client.get(server.url("/json?after=close"), 2000).empty());
+    CHECK_EQ(server.connectionCount(), 2L);
+
+    // A pooled connection dropped by the server is replaced once
+    CHECK(!client.get(server.url("/stale"), 2000).empty());
+    CHECK_EQ(server.connectionCount(), 3L);
+    CHECK_EQ(client.getStats().connectionsOpened, 3L);
+
+    // A timed-out connection is not pooled
+    auto start = std::chrono::steady_clock::now();
+    CHECK_EQ(client.get(server.url("/slow"), 100), "");
+    CHECK(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(400));
+    CHECK(!client.get(server.url("/json?after=timeout"), 2000).empty());
+    CHECK_EQ(server.connectionCount(), 4L);
+
+    // Concurrent batches open one connection per worker, then reuse them
+    std::shared_ptr<SocketHttpClient> shared = std::make_shared<SocketHttpClient>();
+    ConcurrentFetcher::Transport transport = [shared](const std::string& url, int timeoutMs) { return shared->get(url, timeoutMs); };
+    ConcurrentFetcher fetcher;
+    long before = server.connectionCount();
+    for (int refresh = 0; refresh < 3; refresh++) {
+        std::vector<std::string> urls;
+        for (int day = 0; day < 8; day++) {
+            urls.push_back(server.url("/batch?refresh=" + std::to_string(refresh) + "&day=" + std::to_string(day)));
+        }
+        std::vector<ConcurrentFetcher::Result> results = fetcher.fetchAll(urls, 3000, transport);
+        for (const ConcurrentFetcher::Result& result : results) CHECK(result.completed);
+    }
+    long opened = server.connectionCount() - before;
+    std::cout << "24 batch requests over " << opened << " connections" << std::endl;
+    CHECK(opened >= 1 && opened <= ConcurrentFetcher::kDefaultConcurrency);
+    CHECK_EQ(shared->getStats().connectionsOpened, opened);
+    CHECK_EQ(shared->getStats().requests, 24L);
+
+    // https is not supported and fails without touching the network
+    CHECK_EQ(client.get("https://127.0.0.1:" + std::to_string(server.port()) + "/json", 500), "");
+    return checkResult();
+}
@@ -0,0 +1,200 @@
+// JsonScanner over recorded API responses and fuzzed input: the fields the
+// app reads come out of each recording, every strict prefix of a document is
+// rejected, malformed escapes, numbers, literals and over-deep nesting are
+// refused, and random mutations of the recordings never read outside the
+// input or report a value the scanner should have rejected.
+#include "timewallpaper_core.h"
+#include "check.h"
+
+#include <cerrno>
+#include <random>
+
+static const char* const kRecorded[] = {
+    // api.sunrise-sunset.org, formatted=0
+    "{\"results\":{\"sunrise\":\"2024-06-21T09:25:09+00:00\",\"sunset\":\"2024-06-22T00:31:15+00:00\","
+    "\"solar_noon\":\"2024-06-21T16:58:12+00:00\",\"day_length\":54366,"
+    "\"civil_twilight_begin\":\"2024-06-21T08:52:15+00:00\",\"civil_twilight_end\":\"2024-06-22T01:04:09+00:00\","
+    "\"nautical_twilight_begin\":\"2024-06-21T08:11:27+00:00\",\"nautical_twilight_end\":\"2024-06-22T01:44:57+00:00\","
+    "\"astronomical_twilight_begin\":\"2024-06-21T07:23:46+00:00\",\"astronomical_twilight_end\":\"2024-06-22T02:32:38+00:00\"},"
+    "\"status\":\"OK\",\"tzid\":\"UTC\"}",
+    // Midnight sun: the API reports the epoch for events that do not happen
+    "{\"results\":{\"sunrise\":\"1970-01-01T00:00:01+00:00\",\"sunset\":\"1970-01-01T00:00:01+00:00\","
+    "\"solar_noon\":\"2024-06-21T10:44:03+00:00\",\"day_length\":0,"
+    "\"civil_twilight_begin\":\"1970-01-01T00:00:01+00:00\",\"civil_twilight_end\":\"1970-01-01T00:00:01+00:00\"},"
+    "\"status\":\"OK\",\"tzid\":\"UTC\"}",
+    // Pretty-printed, status first
+    "{\n  \"status\": \"OK\",\n  \"results\": {\n    \"sunrise\": \"2026-10-17T05:12:44+00:00\",\n"
+    "    \"sunset\": \"2026-10-17T16:02:10+00:00\",\n    \"solar_noon\": \"2026-10-17T10:37:27+00:00\",\n"
+    "    \"day_length\": 38966,\n    \"civil_twilight_begin\": \"2026-10-17T04:40:31+00:00\",\n"
+    "    \"civil_twilight_end\": \"2026-10-17T16:34:23+00:00\"\n  },\n  \"tzid\": \"UTC\"\n}\n",
+    "{\"results\":\"\",\"status\":\"INVALID_DATE\"}",
+    // ip-api.com
+    "{\"status\":\"success\",\"country\":\"Norway\",\"regionName\":\"Troms og Finnmark\",\"city\":\"Troms\\u00f8\","
+    "\"lat\":69.6489,\"lon\":18.9551}",
+    "{\"status\":\"success\",\"country\":\"United States\",\"regionName\":\"New York\",\"city\":\"New York\","
+    "\"lat\":40.7128,\"lon\":-74.006}",
+    "{\"status\":\"fail\",\"message\":\"reserved range\",\"query\":\"127.0.0.1\"}",
+};
+
+struct Scanned {
+    bool ok = false;
+    std::vector<JsonScanner::Member> members;
+};
+
+static Scanned scanAll(std::string_view json) {
+    Scanned scanned;
+    scanned.ok = JsonScanner::scan(json, [&](const JsonScanner::Member& m) { scanned.members.push_back(m); });
+    return scanned;
+}
+
+static bool within(std::string_view inner, std::string_view outer) {
+    return inner.data() >= outer.data() && inner.data() + inner.size() <= outer.data() + outer.size();
+}
+
+static std::string_view find(const Scanned& scanned, std::string_view key, int depth) {
+    for (const JsonScanner::Member& m : scanned.members) {
+        if (m.key == key && m.depth == depth) return m.value;
+    }
+    return std::string_view();
+}
+
+// What a reported member must satisfy whatever the input was
+static void checkMembers(std::string_view json, const Scanned& scanned) {
+    for (const JsonScanner::Member& m : scanned.members) {
+        CHECK(within(m.key, json) && within(m.value, json));
+        CHECK(m.depth >= 0 && m.depth < 32);
+        CHECK(!m.key.empty());
+        for (char c : m.value) CHECK(static_cast<unsigned char>(c) >= 0x20);
+        if (m.type == JsonScanner::JSON_NUMBER) {
+            // Converts in full unless it overflows a double (69E6489)
+            double value;
+            std::string copy(m.value);
+            char* end = nullptr;
+            errno = 0;
+            std::strtod(copy.c_str(), &end);
+            CHECK(end == copy.c_str() + copy.size());
+            CHECK(JsonScanner::toDouble(m.value, value) || errno == ERANGE);
+        } else if (m.type == JsonScanner::JSON_LITERAL) {
+            CHECK(m.value == "true" || m.value == "false" || m.value == "null");
+        } else {
+            JsonScanner::unescape(m.value);
+        }
+    }
+}
+
+static std::string mutate(std::string json, std::mt19937& random) {
+    static const char kInteresting[] = "{}[]\":,\\u0-.eE+ \ntfn";
+    int edits = 1 + static_cast<int>(random() % 4);
+    for (int e = 0; e < edits && !json.empty(); e++) {
+        size_t at = random() % json.size();
+        switch (random() % 5) {
+            case 0: json[at] = static_cast<char>(random() % 256); break;
+            case 1: json[at] = kInteresting[random() % (sizeof(kInteresting) - 1)]; break;
+            case 2: json.insert(at, 1, kInteresting[random() % (sizeof(kInteresting) - 1)]); break;
+            case 3: json.erase(at, 1 + random() % 8); break;
+            default: json.resize(at); break;
+        }
+    }
+    return json;
+}
+
+int main() {
+    // Every recording scans and yields what the app reads from it
+    for (const char* recorded : kRecorded) {
+        std::string json = recorded;
+        Scanned scanned = scanAll(json);
+        CHECK(scanned.ok);
+        checkMembers(json, scanned);
+        CHECK(!find(scanned, "status", 0).empty());
+
+        // No strict prefix of an object is a document; strip the trailing
+        // whitespace of the pretty-printed recording first
+        size_t end = json.find_last_not_of(" \n") + 1;
+        for (size_t length = 0; length < end; length++) {
+            CHECK(!scanAll(std::string_view(json).substr(0, length)).ok);
+        }
+    }
+
+    Scanned sunny = scanAll(kRecorded[0]);
+    CHECK_EQ(std::string(find(sunny, "sunrise", 1)), std::string("2024-06-21T09:25:09+00:00"));
+    CHECK_EQ(std::string(find(sunny, "day_length", 1)), std::string("54366"));
+    CHECK(find(sunny, "sunrise", 0).empty());
+    CHECK_EQ(std::string(find(sunny, "status", 0)), std::string("OK"));
+
+    Scanned tromso = scanAll(kRecorded[4]);
+    double latitude;
+    CHECK(JsonScanner::toDouble(find(tromso, "lat", 0), latitude) && std::fabs(latitude - 69.6489) < 1e-12);
+    CHECK_EQ(JsonScanner::unescape(find(tromso, "city", 0)), std::string("Troms\xC3\xB8"));
+
+    // The parsed sunrise-sunset recordings, UTC+2
+    TimeZoneTable zone(std::make_unique<FixedOffsetTimeZoneProvider>(120));
+    SolarTimes parsed;
+    CHECK(parseSunriseSunsetJson(kRecorded[2], zone, parsed));
+    CHECK(std::fabs(parsed.sunrise_hour - (7 + 12 / 60.0 + 44 / 3600.0)) < 1e-9);
+    CHECK(!parseSunriseSunsetJson(kRecorded[3], zone, parsed));
+
+    // Escapes
+    CHECK_EQ(JsonScanner::unescape(find(scanAll("{\"k\":\"a\\\"b\\\\c\\/d\\n\"}"), "k", 0)), std::string("a\"b\\c/d\n"));
+    CHECK_EQ(JsonScanner::unescape(find(scanAll("{\"k\":\"\\ud83d\\ude00\"}"), "k", 0)), std::string("\xF0\x9F\x98\x80"));
+    CHECK(!scanAll("{\"k\":\"\\x41\"}").ok);
+    CHECK(!scanAll("{\"k\":\"\\u00g1\"}").ok);
+    CHECK(!scanAll("{\"k\":\"\\u00\"}").ok);
+    CHECK(!scanAll("{\"k\":\"tab\there\"}").ok);
+    CHECK(!scanAll("{\"k\":\"unterminated\\\"}").ok);
+
+    // Numbers and literals
+    CHECK(scanAll("{\"a\":-0.5e+3,\"b\":0,\"c\":12E-1,\"d\":true,\"e\":false,\"f\":null}").ok);
+    const char* const badValues[] = {"01", "-", "1.", ".5", "1e", "+1", "0x10", "tru", "nul", "True", "1.5.2", "--1"};
+    for (const char* bad : badValues) CHECK(!scanAll(std::string("{\"a\":") + bad + "}").ok);
+
+    // Structure
+    CHECK(!scanAll("{\"a\":1,}").ok);
+    CHECK(!scanAll("{\"a\" 1}").ok);
+    CHECK(!scanAll("{\"a\":1}}").ok);
+    CHECK(!scanAll("{a:1}").ok);
+    CHECK(!scanAll("").ok);
+    CHECK(scanAll("[1,[2,{\"x\":3}]]").ok);
+    CHECK_EQ(scanAll("[1,[2,{\"x\":3}]]").members.size(), static_cast<size_t>(1)); // array items are not members
+
+    // Nesting stops at the depth limit instead of recursing without bound
+    auto nested = [](int depth) { return std::string(depth, '[') + std::string(depth, ']'); };
+    CHECK(scanAll(nested(32)).ok);
+    CHECK(!scanAll(nested(33)).ok);
+    CHECK(!scanAll(nested(100000)).ok);
+
+    // Fuzz: mutated recordings and random bytes
+    std::mt19937 random(20261017);
+    long accepted = 0;
+    for (int round = 0; round < 200000; round++) {
+        std::string json;
+        if (round % 10 == 9) {
+            json.resize(random() % 64);
+            for (char& c : json) c = static_cast<char>(random() % 256);
+        } else {
+            json = mutate(kRecorded[random() % (sizeof(kRecorded) / sizeof(kRecorded[0]))], random);
+        }
+
+        // Scanned from an allocation of exactly the input's size, so reads
+        // past the end hit no terminator (and trip AddressSanitizer builds)
+        std::unique_ptr<char[]> exact(new char[json.size()]);
+        std::memcpy(exact.get(), json.data(), json.size());
+        std::string_view view(exact.get(), json.size());
+        Scanned scanned = scanAll(view);
+        checkMembers(view, scanned);
+        if (scanned.ok) accepted++;
+        // The result depends on the input alone
+        Scanned again = scanAll(view);
+        CHECK_EQ(again.ok, scanned.ok);
+        CHECK_EQ(again.members.size(), scanned.members.size());
+
+        // The parsers built on the scanner take whatever comes back
+        SolarTimes times;
+        if (parseSunriseSunsetJson(json, zone, times)) {
+            CHECK(times.sunrise_hour >= 0 && times.sunrise_hour < 24);
+            CHECK(times.sunset_hour >= 0 && times.sunset_hour < 24);
+        }
+    }
+    std::cout << accepted << " of 200000 fuzzed inputs were well-formed" << std::endl;
+    CHECK(accepted > 0);
+    return checkResult();
+}
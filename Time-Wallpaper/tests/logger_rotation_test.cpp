@@ -0,0 +1,57 @@
+// AsyncLogger size rotation through the portable file calls: archives shift
+// up, the oldest beyond keep is deleted and no temp file is left behind.
+#include "timewallpaper_core.h"
+#include "check.h"
+
+static bool exists(const std::string& path) {
+    return std::ifstream(path, std::ios::binary).is_open();
+}
+
+static std::string readAll(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+int main() {
+    const std::string path = "logger_rotation_test.txt";
+    const char* const archives[] = { "logger_rotation_test.1.gz", "logger_rotation_test.2.gz", "logger_rotation_test.3.gz" };
+    std::remove(path.c_str());
+    for (const char* archive : archives) std::remove(archive);
+
+    AsyncLogger logger;
+    logger.start(path, AsyncLogger::LOG_INFO, 1024, 2);
+    for (int burst = 0; burst < 5; burst++) {
+        for (int line = 0; line < 100; line++) {
+            logger.log(AsyncLogger::LOG_INFO, "burst {} line {} of rotation output", burst, line);
+        }
+        logger.flush();
+    }
+    logger.log(AsyncLogger::LOG_INFO, "{}", "after the last rotation");
+    logger.stop();
+
+    CHECK(exists(archives[0]));
+    CHECK(exists(archives[1]));
+    CHECK(!exists(archives[2]));
+    CHECK(!exists(std::string(archives[0]) + ".tmp"));
+    CHECK_EQ(logger.getDropped(), 0u);
+
+    // Each archive is a gzip member holding one burst: 100 lines and the ISIZE trailer agrees
+    for (int i = 0; i < 2; i++) {
+        std::string archive = readAll(archives[i]);
+        CHECK(archive.size() > 18);
+        if (archive.size() <= 18) continue;
+        CHECK_EQ(static_cast<unsigned char>(archive[0]), 0x1f);
+        CHECK_EQ(static_cast<unsigned char>(archive[1]), 0x8b);
+        uint32_t inputSize;
+        std::memcpy(&inputSize, archive.data() + archive.size() - 4, 4);
+        CHECK(inputSize > 1024);
+    }
+
+    std::string current = readAll(path);
+    CHECK(current.find("after the last rotation") != std::string::npos);
+    CHECK(current.find("line 99") == std::string::npos);
+
+    std::remove(path.c_str());
+    for (const char* archive : archives) std::remove(archive);
+    return checkResult();
+}
@@ -0,0 +1,151 @@
+// SiteBatch off Windows: reading a sites CSV with fixed offsets and with
+// named zones from an injected provider factory, evaluating blocks across a
+// pool against each site worked out on its own, and both output layouts.
+#include "timewallpaper_core.h"
+#include "check.h"
+
+class RulesProvider : public TimeZoneProvider {
+public:
+    explicit RulesProvider(const ZoneRules& rules) : rules(rules) {}
+    ZoneRules rulesForYear(int) override { return rules; }
+
+private:
+    ZoneRules rules;
+};
+
+// US Eastern under the name Windows gives it; every other name is unknown
+static std::unique_ptr<TimeZoneProvider> easternOnly(const std::string& zoneName) {
+    if (zoneName != "Eastern Standard Time") return nullptr;
+    ZoneRules rules = {};
+    rules.standardOffsetMinutes = -300;
+    rules.daylightOffsetMinutes = -240;
+    rules.daylightDate.wMonth = 3;
+    rules.daylightDate.wDay = 2;
+    rules.daylightDate.wHour = 2;
+    rules.standardDate.wMonth = 11;
+    rules.standardDate.wDay = 1;
+    rules.standardDate.wHour = 2;
+    return std::make_unique<RulesProvider>(rules);
+}
+
+static std::string readAll(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+int main() {
+    const std::string sitesPath = "site_batch_test.csv";
+    {
+        std::ofstream csv(sitesPath);
+        csv << "site_id,latitude,longitude,zone\n"
+            << "nyc,40.7128,-74.0060,Eastern Standard Time\r\n"
+            << "# a comment\n"
+            << "delhi, 28.6139, 77.2090, UTC+05:30\n"
+            << "london,51.5074,-0.1278,Z\n"
+            << "nowhere,10,10,Mars Standard Time\n"
+            << "pole,95,0,UTC\n"
+            << "short,1,2\n"
+            << ",1,2,UTC\n";
+    }
+
+    // Without a factory, named zones are unknown; with one, they resolve
+    std::vector<SiteBatch::Site> portable, named;
+    std::vector<std::string> warnings;
+    std::string error;
+    CHECK(SiteBatch::readSites(sitesPath, portable, warnings, error));
+    CHECK_EQ(portable.size(), static_cast<size_t>(2));
+    CHECK_EQ(warnings.size(), static_cast<size_t>(5));
+    CHECK(!warnings.empty() && warnings[0] == "line 2: unknown zone 'Eastern Standard Time'");
+
+    warnings.clear();
+    CHECK(SiteBatch::readSites(sitesPath, named, warnings, error, easternOnly));
+    CHECK_EQ(named.size(), static_cast<size_t>(3));
+    CHECK_EQ(warnings.size(), static_cast<size_t>(4));
+    CHECK(named.size() == 3 && named[0].id == "nyc" && !named[0].fixedOffset);
+    CHECK(named.size() == 3 && named[1].fixedOffset && named[1].offsetMinutes == 330);
+    CHECK(named.size() == 3 && named[2].fixedOffset && named[2].offsetMinutes == 0);
+    CHECK(!SiteBatch::readSites("site_batch_test_missing.csv", named, warnings, error));
+
+    int offset = 0;
+    CHECK(SiteBatch::parseUtcOffset("GMT-0800", offset) && offset == -480);
+    CHECK(SiteBatch::parseUtcOffset("-8", offset) && offset == -480);
+    CHECK(!SiteBatch::parseUtcOffset("UTC+15", offset));
+    CHECK(!SiteBatch::parseUtcOffset("UTC+5:3", offset));
+
+    // Enough sites for several blocks: the named sites, then a grid on
+    // whole-hour offsets. 2024-07-01 03:30 UTC is still June 30 in New York.
+    std::vector<SiteBatch::Site> sites = named;
+    for (int i = 0; i < 700; i++) {
+        SiteBatch::Site site;
+        site.id = "grid" + std::to_string(i);
+        site.latitude = -60.0 + (i % 25) * 5.0;
+        site.longitude = -180.0 + (i / 25) * 12.5;
+        site.fixedOffset = true;
+        site.offsetMinutes = static_cast<int>(std::lround(site.longitude / 15.0)) * 60;
+        site.zone = "UTC" + std::string(site.offsetMinutes < 0 ? "-" : "+") + std::to_string(std::abs(site.offsetMinutes / 60));
+        sites.push_back(site);
+    }
+    const long long now = daysFromCivil(2024, 7, 1) * 86400 + 3 * 3600 + 30 * 60;
+
+    std::shared_ptr<const ColorTheme> theme = ColorTheme::builtIn();
+    std::vector<SiteBatch::Result> results, pooled;
+    WorkStealingPool single(1), several(3);
+    SiteBatch::evaluate(sites, now, theme, single, results, easternOnly);
+    SiteBatch::evaluate(sites, now, theme, several, pooled, easternOnly);
+    CHECK_EQ(results.size(), sites.size());
+    CHECK_EQ(pooled.size(), sites.size());
+
+    // Every site against its own zone table and schedule
+    ColorSchedule schedule;
+    for (size_t i = 0; i < sites.size() && i < results.size() && i < pooled.size(); i++) {
+        const SiteBatch::Site& site = sites[i];
+        TimeZoneTable zone(site.fixedOffset ? std::make_unique<FixedOffsetTimeZoneProvider>(site.offsetMinutes)
+                                            : easternOnly(site.zone));
+        long long local = now + zone.offsetMinutesAt(now) * 60LL;
+        long long days = local / 86400;
+        int second = static_cast<int>(local - days * 86400);
+        int year, month, day;
+        civilFromDays(days, year, month, day);
+        SolarTimes solarTimes;
+        computeLocalSolarTimes(year, month, day, site.latitude, site.longitude, zone, solarTimes);
+        schedule.buildKeyframes(solarTimes);
+        PeriodId period, nextPeriod;
+        Color current = schedule.evaluate(second / 3600.0, period);
+        Color next = schedule.evaluate(((second + 3600) % 86400) / 3600.0, nextPeriod);
+
+        for (const SiteBatch::Result* r : { &results[i], &pooled[i] }) {
+            CHECK_EQ(r->localSecond, second);
+            CHECK_EQ(r->solarTimes.sunrise_hour, solarTimes.sunrise_hour);
+            CHECK(r->current == current && r->next == next);
+            CHECK(r->currentPeriod == period && r->nextPeriod == nextPeriod);
+        }
+    }
+    CHECK(!results.empty() && results[0].localSecond == 23 * 3600 + 30 * 60); // 23:30 EDT
+    CHECK(results.size() > 1 && results[1].localSecond == 9 * 3600);           // 09:00 IST
+
+    // CSV output: a header and a row per site
+    const std::string csvPath = "site_batch_test_out.csv";
+    CHECK(SiteBatch::write(csvPath, now, sites, results, *theme));
+    std::string csv = readAll(csvPath);
+    CHECK_EQ(static_cast<size_t>(std::count(csv.begin(), csv.end(), '\n')), sites.size() + 1);
+    CHECK(csv.find("\nnyc,23:30:00,") != std::string::npos);
+
+    // Binary output: header, records, ids, period names
+    const std::string binPath = "site_batch_test_out.bin";
+    CHECK(SiteBatch::write(binPath, now, sites, results, *theme));
+    std::string bin = readAll(binPath);
+    SiteBatch::Header header = {};
+    CHECK(bin.size() > sizeof(header) + sites.size() * sizeof(SiteBatch::Record));
+    std::memcpy(&header, bin.data(), std::min(bin.size(), sizeof(header)));
+    CHECK_EQ(header.magic, SiteBatch::kMagic);
+    CHECK_EQ(header.siteCount, static_cast<uint32_t>(sites.size()));
+    CHECK_EQ(header.recordSize, static_cast<uint32_t>(sizeof(SiteBatch::Record)));
+    CHECK_EQ(header.utcSeconds, static_cast<int64_t>(now));
+    size_t ids = sizeof(header) + sites.size() * sizeof(SiteBatch::Record);
+    CHECK(bin.size() > ids && std::string(bin.c_str() + ids) == "nyc");
+
+    std::remove(sitesPath.c_str());
+    std::remove(csvPath.c_str());
+    std::remove(binPath.c_str());
+    return checkResult();
+}
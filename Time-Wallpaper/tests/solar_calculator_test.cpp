@@ -0,0 +1,122 @@
+// SolarCalculator against published sunrise/sunset times, against the
+// independent USNO "Almanac for Computers" algorithm over a grid of places
+// and dates, and on polar day and night.
+#include "timewallpaper_core.h"
+#include "check.h"
+
+static constexpr double kPi = 3.14159265358979323846;
+
+static double toRad(double deg) { return deg * kPi / 180.0; }
+static double toDeg(double rad) { return rad * 180.0 / kPi; }
+
+static double wrap(double value, double range) {
+    value = std::fmod(value, range);
+    return value < 0 ? value + range : value;
+}
+
+// Minutes between two hours on the 24-hour circle
+static double minutesApart(double a, double b) {
+    double hours = std::fmod(std::fabs(a - b), 24.0);
+    return std::min(hours, 24.0 - hours) * 60.0;
+}
+
+// USNO sunrise/sunset algorithm (Almanac for Computers, 1990). Returns false
+// when the sun does not reach the zenith that day.
+static bool usnoEventUTC(int dayOfYear, double latitude, double longitude, double zenith, bool rising, double& utcHour) {
+    double lngHour = longitude / 15.0;
+    double t = dayOfYear + ((rising ? 6.0 : 18.0) - lngHour) / 24.0;
+    double meanAnomaly = 0.9856 * t - 3.289;
+    double trueLongitude = wrap(meanAnomaly + 1.916 * std::sin(toRad(meanAnomaly))
+                                + 0.020 * std::sin(toRad(2 * meanAnomaly)) + 282.634, 360.0);
+
+    double rightAscension = wrap(toDeg(std::atan(0.91764 * std::tan(toRad(trueLongitude)))), 360.0);
+    rightAscension += std::floor(trueLongitude / 90.0) * 90.0 - std::floor(rightAscension / 90.0) * 90.0;
+    rightAscension /= 15.0;
+
+    double sinDec = 0.39782 * std::sin(toRad(trueLongitude));
+    double cosDec = std::cos(std::asin(sinDec));
+    double cosHourAngle = (std::cos(toRad(zenith)) - sinDec * std::sin(toRad(latitude))) / (cosDec * std::cos(toRad(latitude)));
+    if (cosHourAngle > 1.0 || cosHourAngle < -1.0) return false;
+
+    double hourAngle = (rising ? 360.0 - toDeg(std::acos(cosHourAngle)) : toDeg(std::acos(cosHourAngle))) / 15.0;
+    double localMeanTime = hourAngle + rightAscension - 0.06571 * t - 6.622;
+    utcHour = wrap(localMeanTime - lngHour, 24.0);
+    return true;
+}
+
+struct Published {
+    const char* place;
+    int year, month, day;
+    double latitude, longitude;
+    double utcOffsetHours;
+    int sunriseMinute, sunsetMinute; // local clock time, minutes after midnight
+};
+
+int main() {
+    // Published local times, rounded to the minute
+    const Published table[] = {
+        { "New York", 2024, 1, 1, 40.7128, -74.0060, -5.0, 7 * 60 + 20, 16 * 60 + 39 },
+        { "London", 2024, 6, 21, 51.5074, -0.1278, 1.0, 4 * 60 + 43, 21 * 60 + 21 },
+        { "Sydney", 2024, 12, 21, -33.8688, 151.2093, 11.0, 5 * 60 + 41, 20 * 60 + 5 },
+        { "Quito", 2024, 3, 20, -0.1807, -78.4678, -5.0, 6 * 60 + 18, 18 * 60 + 24 },
+    };
+    for (const Published& row : table) {
+        SolarCalculator::Events events = SolarCalculator::compute(row.year, row.month, row.day, row.latitude, row.longitude);
+        double sunriseOff = minutesApart(events.sunrise + row.utcOffsetHours, row.sunriseMinute / 60.0);
+        double sunsetOff = minutesApart(events.sunset + row.utcOffsetHours, row.sunsetMinute / 60.0);
+        if (sunriseOff > 1.5 || sunsetOff > 1.5) {
+            std::cerr << row.place << ": sunrise off by " << sunriseOff << " min, sunset by " << sunsetOff << " min" << std::endl;
+        }
+        CHECK(sunriseOff <= 1.5); // a minute, plus the published rounding
+        CHECK(sunsetOff <= 1.5);
+    }
+
+    // Every third day of 2024 between +/-60 degrees, eight longitudes
+    double worst = 0.0;
+    int compared = 0;
+    const long long firstDay = daysFromCivil(2024, 1, 1);
+    for (double latitude = -60.0; latitude <= 60.0; latitude += 5.0) {
+        for (double longitude = -180.0; longitude < 180.0; longitude += 45.0) {
+            for (int dayOfYear = 1; dayOfYear <= 366; dayOfYear += 3) {
+                int year, month, day;
+                civilFromDays(firstDay + dayOfYear - 1, year, month, day);
+                SolarCalculator::Events events = SolarCalculator::compute(year, month, day, latitude, longitude);
+
+                const struct { double zenith; bool rising; double hour; } cases[] = {
+                    { 90.833, true, events.sunrise }, { 90.833, false, events.sunset },
+                    { 96.0, true, events.civil_twilight_begin }, { 96.0, false, events.civil_twilight_end },
+                };
+                for (const auto& c : cases) {
+                    double reference;
+                    if (!usnoEventUTC(dayOfYear, latitude, longitude, c.zenith, c.rising, reference)) continue;
+                    worst = std::max(worst, minutesApart(c.hour, reference));
+                    compared++;
+                }
+            }
+        }
+    }
+    std::cout << compared << " events within " << worst << " min of the USNO algorithm" << std::endl;
+    CHECK(compared > 30000);
+    CHECK(worst <= 2.0);
+
+    // Tromso never sees sunset on 21 June: both events collapse onto solar
+    // midnight. On 21 December the sun never rises: both land on solar noon.
+    SolarCalculator::Events midnightSun = SolarCalculator::compute(2024, 6, 21, 69.6492, 18.9553);
+    CHECK(minutesApart(midnightSun.sunrise, midnightSun.solar_noon + 12.0) < 1.0);
+    CHECK(minutesApart(midnightSun.sunset, midnightSun.solar_noon + 12.0) < 1.0);
+    SolarCalculator::Events polarNight = SolarCalculator::compute(2024, 12, 21, 69.6492, 18.9553);
+    CHECK(minutesApart(polarNight.sunrise, polarNight.solar_noon) < 1.0);
+    CHECK(minutesApart(polarNight.sunset, polarNight.solar_noon) < 1.0);
+    CHECK(polarNight.civil_twilight_begin < polarNight.solar_noon); // civil twilight still happens
+    CHECK(polarNight.civil_twilight_end > polarNight.solar_noon);
+
+    // No latitude produces NaN
+    for (double latitude = -89.5; latitude <= 89.5; latitude += 0.5) {
+        for (int month = 1; month <= 12; month++) {
+            SolarCalculator::Events events = SolarCalculator::compute(2024, month, 15, latitude, 10.0);
+            CHECK(std::isfinite(events.sunrise) && std::isfinite(events.sunset) && std::isfinite(events.solar_noon)
+                  && std::isfinite(events.civil_twilight_begin) && std::isfinite(events.civil_twilight_end));
+        }
+    }
+    return checkResult();
+}
@@ -0,0 +1,203 @@
+// The rolling solar window over simulated months against a loopback
+// sunrise-sunset API: requests per day and per month, staleness checked
+// against the server's own record of what it served, and a failed day
+// computed in the meantime and fetched again the next day. The cache goes
+// through the binary file encoding after every refresh, as it does on disk.
+#include "timewallpaper_core.h"
+#include "timewallpaper_socket_http.h"
+#include "check.h"
+#include "stub_server.h"
+
+struct Served {
+    long long servedOn; // simulated day the request arrived on
+    std::string date;
+};
+
+class MonthRun {
+public:
+    SolarWindow window;
+    SolarCache cache;
+    std::vector<int> requestsPerDay;
+
+    MonthRun(StubServer& server, std::atomic<long long>& simulatedDay) : server(server), simulatedDay(simulatedDay) {
+        window.apiMode = true;
+        window.latitude = 69.65;
+        window.longitude = 18.96;
+    }
+
+    // One simulated day, as the app's once-a-day refresh does it
+    void runDay(long long today) {
+        simulatedDay = today;
+        long before = server.requestCount();
+        if (cache.last_updated != SolarCache::formatDay(today)) {
+            cache.shift(today, window.length());
+            std::vector<long long> wanted = window.daysToRefresh(cache, today);
+            bool fetching = window.apiMode && !wanted.empty();
+            SolarWindow::ApiBatch batch;
+            if (fetching) {
+                batch = window.fetch(fetcher, wanted, 3000, transport,
+                                     [this](long long day) { return server.url("/json?date=" + SolarCache::formatDay(day) + "&formatted=0"); });
+            }
+            window.refresh(cache, today, fetching ? &batch : nullptr, zone);
+
+            std::string bytes = SolarCacheCodec::encode(cache);
+            SolarCache decoded;
+            CHECK(SolarCacheCodec::decode(bytes.data(), bytes.size(), decoded));
+            cache = decoded;
+        }
+        requestsPerDay.push_back(static_cast<int>(server.requestCount() - before));
+    }
+
+    int total() const {
+        int sum = 0;
+        for (int count : requestsPerDay) sum += count;
+        return sum;
+    }
+
+private:
+    StubServer& server;
+    std::atomic<long long>& simulatedDay;
+    TimeZoneTable zone{std::make_unique<FixedOffsetTimeZoneProvider>(60)};
+    std::shared_ptr<SocketHttpClient> client = std::make_shared<SocketHttpClient>();
+    ConcurrentFetcher::Transport transport = [client = client](const std::string& url, int timeoutMs) { return client->get(url, timeoutMs); };
+    ConcurrentFetcher fetcher;
+};
+
+static std::string sunriseSunsetJson(const std::string& date) {
+    auto at = [&](const char* time) { return "\"" + date + "T" + time + "+00:00\""; };
+    return "{\"results\":{\"sunrise\":" + at("05:00:00") + ",\"sunset\":" + at("16:30:00")
+        + ",\"solar_noon\":" + at("10:45:00") + ",\"day_length\":41400,\"civil_twilight_begin\":" + at("04:20:00")
+        + ",\"civil_twilight_end\":" + at("17:10:00") + "},\"status\":\"OK\"}";
+}
+
+int main() {
+    const long long firstDay = daysFromCivil(2026, 10, 1);
+    const std::string failingDate = SolarCache::formatDay(firstDay + 5);
+
+    std::mutex logMutex;
+    std::vector<Served> log;
+    std::atomic<long long> simulatedDay{0};
+    // Every date answers, except that failingDate fails on the first simulated day
+    StubServer server([&](const std::string& path) {
+        StubServer::Response response;
+        size_t datePos = path.find("date=");
+        std::string date = datePos == std::string::npos ? "" : path.substr(datePos + 5, 10);
+        {
+            std::lock_guard<std::mutex> lock(logMutex);
+            log.push_back({ simulatedDay.load(), date });
+        }
+        if (date == failingDate && simulatedDay.load() == firstDay) response.status = 500;
+        else response.body = sunriseSunsetJson(date);
+        return response;
+    });
+
+    auto servedOn = [&](long long day, const std::string& date) {
+        std::lock_guard<std::mutex> lock(logMutex);
+        int count = 0;
+        for (const Served& served : log) {
+            if (served.servedOn == day && (date.empty() || served.date == date)) count++;
+        }
+        return count;
+    };
+
+    {
+        // A 30-day window that keeps days for 30 days: the whole window once,
+        // then one new day each morning
+        MonthRun run(server, simulatedDay);
+        run.window.windowDays = 30;
+        run.window.maxAgeDays = 30;
+        for (int d = 0; d < 30; d++) {
+            run.runDay(firstDay + d);
+            run.runDay(firstDay + d); // later checks the same day fetch nothing
+
+            for (int offset = 0; offset < 30; offset++) {
+                SolarTimes* entry = run.cache.find(firstDay + d + offset);
+                CHECK(entry && entry->valid);
+                if (d > 0) CHECK(entry && entry->source == "api");
+            }
+            CHECK_EQ(run.requestsPerDay[2 * d + 1], 0);
+        }
+
+        // Day 0: 29 days once plus the failing day twice (one retry); it was
+        // computed that day and fetched again on day 1 along with the new day
+        CHECK_EQ(run.requestsPerDay[0], 31);
+        CHECK_EQ(servedOn(firstDay, failingDate), 2);
+        CHECK_EQ(run.requestsPerDay[2], 2);
+        CHECK_EQ(servedOn(firstDay + 1, failingDate), 1);
+        for (int d = 2; d < 30; d++) CHECK_EQ(run.requestsPerDay[2 * d], 1);
+        std::cout << "30-day window, 30-day max age: " << run.total() << " requests per simulated month" << std::endl;
+        CHECK_EQ(run.total(), 31 + 2 + 28);
+    }
+
+    {
+        // Eight days, as the old fixed window had: 8 then 1 a day instead of
+        // 8 every day
+        MonthRun run(server, simulatedDay);
+        run.window.windowDays = 8;
+        run.window.maxAgeDays = 30;
+        for (int d = 100; d < 130; d++) run.runDay(firstDay + d);
+        std::cout << "8-day window: " << run.total() << " requests per simulated month (re-fetching all 8 daily: 240)" << std::endl;
+        CHECK_EQ(run.total(), 8 + 29);
+    }
+
+    {
+        // Days go stale after a week. What the server saw each day must be
+        // exactly the window days it had not served in the last seven days.
+        MonthRun run(server, simulatedDay);
+        run.window.windowDays = 30;
+        run.window.maxAgeDays = 7;
+        std::map<std::string, long long> lastServed;
+        const long long start = firstDay + 200;
+        for (int d = 0; d < 30; d++) {
+            long long today = start + d;
+            std::vector<std::string> expected;
+            for (int offset = 0; offset < 30; offset++) {
+                std::string date = SolarCache::formatDay(today + offset);
+                auto it = lastServed.find(date);
+                if (it == lastServed.end() || today - it->second >= 7) expected.push_back(date);
+            }
+
+            run.runDay(today);
+
+            std::vector<std::string> served;
+            {
+                std::lock_guard<std::mutex> lock(logMutex);
+                for (const Served& entry : log) {
+                    if (entry.servedOn == today) served.push_back(entry.date);
+                }
+            }
+            std::sort(expected.begin(), expected.end());
+            std::sort(served.begin(), served.end());
+            CHECK(served == expected);
+            for (const std::string& date : served) lastServed[date] = today;
+
+            for (int offset = 0; offset < 30; offset++) {
+                SolarTimes* entry = run.cache.find(today + offset);
+                CHECK(entry && entry->source == "api" && today - entry->refreshed_day < 7);
+            }
+        }
+        std::cout << "30-day window, 7-day max age: " << run.total() << " requests per simulated month" << std::endl;
+        CHECK(run.total() < 30 * 30);
+    }
+
+    {
+        // Computed mode never touches the network and still fills the window
+        MonthRun run(server, simulatedDay);
+        run.window.apiMode = false;
+        run.window.windowDays = 30;
+        for (int d = 300; d < 330; d++) run.runDay(firstDay + d);
+        CHECK_EQ(run.total(), 0);
+        SolarTimes* entry = run.cache.find(firstDay + 329);
+        CHECK(entry && entry->valid && entry->source == "computed");
+    }
+
+    // Parsed API times are local (UTC+1 here)
+    {
+        TimeZoneTable zone(std::make_unique<FixedOffsetTimeZoneProvider>(60));
+        SolarTimes parsed;
+        CHECK(SolarWindow::parseDay(sunriseSunsetJson("2026-10-01"), firstDay, firstDay, zone, parsed));
+        CHECK(std::fabs(parsed.sunrise_hour - 6.0) < 1e-9 && std::fabs(parsed.sunset_hour - 17.5) < 1e-9);
+        CHECK_EQ(parsed.fetch_date, std::string("2026-10-01"));
+    }
+    return checkResult();
+}
@@ -0,0 +1,241 @@
+// A loopback HTTP/1.1 server for the network tests. Each request is answered
+// by a handler that can delay, fail or drop it; the server counts requests,
+// accepted connections and the most requests it had in flight at once.
+// POSIX sockets only.
+#ifndef TIMEWALLPAPER_TESTS_STUB_SERVER_H
+#define TIMEWALLPAPER_TESTS_STUB_SERVER_H
+
+#include "timewallpaper_core.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+class StubServer {
+public:
+    struct Response {
+        int status = 200;
+        std::string body;
+        int delayMs = 0;
+        bool drop = false;    // close without answering
+        bool close = false;   // answer with Connection: close
+        bool chunked = false; // send the body in chunked encoding
+    };
+
+    // Called with the request path including the query, on a connection thread
+    typedef std::function<Response(const std::string& path)> Handler;
+
+    explicit StubServer(Handler handler) : handler(std::move(handler)) {
+        listener = socket(AF_INET, SOCK_STREAM, 0);
+        int reuse = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = 0;
+        if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 64) != 0) {
+            std::cerr << "StubServer: cannot listen on loopback" << std::endl;
+            std::exit(1);
+        }
+        socklen_t length = sizeof(address);
+        getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length);
+        listenPort = ntohs(address.sin_port);
+
+        acceptThread = std::thread([this] { acceptLoop(); });
+    }
+
+    ~StubServer() {
+        stopping = true;
+        shutdown(listener, SHUT_RDWR);
+        acceptThread.join();
+        close(listener);
+
+        std::vector<std::thread> finishing;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (int fd : openSockets) shutdown(fd, SHUT_RDWR);
+            finishing.swap(connections);
+        }
+        for (std::thread& connection : finishing) connection.join();
+    }
+
+    StubServer(const StubServer&) = delete;
+    StubServer& operator=(const StubServer&) = delete;
+
+    int port() const { return listenPort; }
+    std::string url(const std::string& path) const { return "http://127.0.0.1:" + std::to_string(listenPort) + path; }
+
+    long requestCount() const { return requests.load(); }
+    long connectionCount() const { return accepted.load(); }
+    int maxInFlight() const { return peakInFlight.load(); }
+
+private:
+    Handler handler;
+    int listener = -1;
+    int listenPort = 0;
+    std::atomic<bool> stopping{false};
+    std::thread acceptThread;
+
+    std::mutex mutex;
+    std::vector<std::thread> connections;
+    std::vector<int> openSockets;
+
+    std::atomic<long> requests{0};
+    std::atomic<long> accepted{0};
+    std::atomic<int> inFlight{0};
+    std::atomic<int> peakInFlight{0};
+
+    void acceptLoop() {
+        for (;;) {
+            int fd = accept(listener, nullptr, nullptr);
+            if (fd < 0) {
+                if (stopping) return;
+                continue;
+            }
+            accepted++;
+            std::lock_guard<std::mutex> lock(mutex);
+            openSockets.push_back(fd);
+            connections.emplace_back([this, fd] { serve(fd); });
+        }
+    }
+
+    // Answers requests on one connection until the client closes it or asks
+    // for Connection: close
+    void serve(int fd) {
+        std::string buffer;
+        char chunk[4096];
+        for (;;) {
+            size_t headerEnd;
+            while ((headerEnd = buffer.find("\r\n\r\n")) == std::string::npos) {
+                ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+                if (received <= 0) {
+                    finish(fd);
+                    return;
+                }
+                buffer.append(chunk, static_cast<size_t>(received));
+            }
+            std::string head = buffer.substr(0, headerEnd);
+            buffer.erase(0, headerEnd + 4);
+
+            size_t pathStart = head.find(' ');
+            size_t pathEnd = head.find(' ', pathStart + 1);
+            std::string path = head.substr(pathStart + 1, pathEnd - pathStart - 1);
+            bool keepAlive = head.find("HTTP/1.1") != std::string::npos && head.find("Connection: close") == std::string::npos;
+
+            requests++;
+            int now = ++inFlight;
+            int peak = peakInFlight.load();
+            while (now > peak && !peakInFlight.compare_exchange_weak(peak, now)) {}
+
+            Response response = handler(path);
+            if (response.delayMs > 0 && !stopping) {
+                // Sleeps in slices so shutdown does not wait out long delays
+                auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(response.delayMs);
+                while (!stopping && std::chrono::steady_clock::now() < until) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                }
+            }
+            inFlight--;
+
+            if (response.drop) {
+                finish(fd);
+                return;
+            }
+            keepAlive = keepAlive && !response.close;
+            std::string reply = "HTTP/1.1 " + std::to_string(response.status) + (response.status == 200 ? " OK" : " Error")
+                + (keepAlive ? "" : "\r\nConnection: close");
+            if (response.chunked) {
+                reply += "\r\nTransfer-Encoding: chunked\r\n\r\n";
+                for (size_t at = 0; at < response.body.size(); at += 7) {
+                    std::string piece = response.body.substr(at, 7);
+                    char size[16];
+                    std::snprintf(size, sizeof(size), "%zx\r\n", piece.size());
+                    reply += size + piece + "\r\n";
+                }
+                reply += "0\r\n\r\n";
+            } else {
+                reply += "\r\nContent-Length: " + std::to_string(response.body.size()) + "\r\n\r\n" + response.body;
+            }
+            send(fd, reply.data(), reply.size(), MSG_NOSIGNAL);
+            if (!keepAlive) {
+                finish(fd);
+                return;
+            }
+        }
+    }
+
+    void finish(int fd) {
+        std::lock_guard<std::mutex> lock(mutex);
+        openSockets.erase(std::remove(openSockets.begin(), openSockets.end(), fd), openSockets.end());
+        close(fd);
+    }
+};
+
+// One connection per request, HTTP/1.0, honouring the timeout; enough for
+// tests that only care what the server saw
+class LoopbackHttpClient : public HttpClient {
+public:
+    explicit LoopbackHttpClient(int port) : port(port) {}
+
+    std::string get(const std::string& url, int timeoutMs) override {
+        requests++;
+        size_t hostStart = url.find("://");
+        size_t pathStart = url.find('/', hostStart == std::string::npos ? 0 : hostStart + 3);
+        std::string path = pathStart == std::string::npos ? "/" : url.substr(pathStart);
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(static_cast<uint16_t>(port));
+        if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            close(fd);
+            return "";
+        }
+        connections++;
+
+        std::string request = "GET " + path + " HTTP/1.0\r\nHost: 127.0.0.1\r\n\r\n";
+        send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+
+        std::string response;
+        char chunk[4096];
+        for (;;) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            pollfd waiting{ fd, POLLIN, 0 };
+            if (remaining.count() <= 0 || poll(&waiting, 1, static_cast<int>(remaining.count())) <= 0) {
+                close(fd);
+                return ""; // timed out
+            }
+            ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+            if (received < 0) {
+                close(fd);
+                return "";
+            }
+            if (received == 0) break;
+            response.append(chunk, static_cast<size_t>(received));
+        }
+        close(fd);
+
+        size_t bodyStart = response.find("\r\n\r\n");
+        if (response.compare(0, 12, "HTTP/1.1 200") != 0 || bodyStart == std::string::npos) return "";
+        return response.substr(bodyStart + 4);
+    }
+
+    Stats getStats() const override {
+        Stats stats;
+        stats.requests = requests.load();
+        stats.connectionsOpened = connections.load();
+        return stats;
+    }
+
+private:
+    int port;
+    std::atomic<long> requests{0};
+    std::atomic<long> connections{0};
+};
+
+#endif // TIMEWALLPAPER_TESTS_STUB_SERVER_H
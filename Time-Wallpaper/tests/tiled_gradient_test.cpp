@@ -0,0 +1,47 @@
+// tiled_gradient draws a texture one dither tile wide and repeats it across
+// the monitor. Repeating that tile must give exactly the full-width frame.
+#include "timewallpaper_core.h"
+#include "check.h"
+
+// The frame a repeated texture of tileWidth columns produces on screen
+static std::vector<uint8_t> repeatTile(const std::vector<uint8_t>& tile, int tileWidth, int width, int height) {
+    std::vector<uint8_t> frame(static_cast<size_t>(width) * height * 4);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            std::memcpy(&frame[(static_cast<size_t>(y) * width + x) * 4],
+                        &tile[(static_cast<size_t>(y) * tileWidth + x % tileWidth) * 4], 4);
+        }
+    }
+    return frame;
+}
+
+int main() {
+    const Color colors[][2] = {
+        { Color(10, 20, 60), Color(250, 180, 90) },
+        { Color(230, 140, 70), Color(8, 8, 25) },
+        { Color(0, 0, 0), Color(255, 255, 255) },
+    };
+    const int sizes[][2] = { { 1920, 1080 }, { 2560, 1440 }, { 1366, 768 }, { 1000, 333 }, { 5, 40 } };
+    const DitherPattern* patterns[] = { &DitherPattern::bayer(), &DitherPattern::blueNoise() };
+
+    int frames = 0;
+    for (const DitherPattern* dither : patterns) {
+        for (const auto& pair : colors) {
+            GradientRasterizer rasterizer(pair[0], pair[1], *dither);
+            for (const auto& size : sizes) {
+                const int width = size[0], height = size[1];
+                // Same width choice as the render loop
+                const int tileWidth = std::min(width, rasterizer.getPatternWidth());
+
+                std::vector<uint8_t> full(static_cast<size_t>(width) * height * 4);
+                std::vector<uint8_t> tile(static_cast<size_t>(tileWidth) * height * 4);
+                rasterizer.rasterize(full.data(), width, height);
+                rasterizer.rasterize(tile.data(), tileWidth, height);
+                CHECK(repeatTile(tile, tileWidth, width, height) == full);
+                frames++;
+            }
+        }
+    }
+    CHECK_EQ(frames, 30);
+    return checkResult();
+}
@@ -0,0 +1,199 @@
+// UpdateScheduler on a stepped SimulatedTimeSource: each kind of deadline
+// (the next color change, the 15-second status tick, the 30-minute accent
+// tick and local midnight, also across DST switches that land on midnight)
+// wins when it should, and two simulated days of the main loop wake it a few
+// hundred times an hour where the old 16 ms poll woke it 225000 times.
+#include "timewallpaper_core.h"
+#include "check.h"
+
+class RulesProvider : public TimeZoneProvider {
+public:
+    explicit RulesProvider(const ZoneRules& rules) : rules(rules) {}
+    ZoneRules rulesForYear(int) override { return rules; }
+
+private:
+    ZoneRules rules;
+};
+
+// Recurring "Nth weekday of month" date; nth 5 means the last one
+static ZoneDate recurring(int month, int weekday, int nth, int hour) {
+    ZoneDate date = {};
+    date.wMonth = static_cast<uint16_t>(month);
+    date.wDayOfWeek = static_cast<uint16_t>(weekday);
+    date.wDay = static_cast<uint16_t>(nth);
+    date.wHour = static_cast<uint16_t>(hour);
+    return date;
+}
+
+static std::unique_ptr<TimeZoneProvider> rules(int standardOffset, int daylightOffset, ZoneDate daylightDate, ZoneDate standardDate) {
+    ZoneRules zone = {};
+    zone.standardOffsetMinutes = standardOffset;
+    zone.daylightOffsetMinutes = daylightOffset;
+    zone.daylightDate = daylightDate;
+    zone.standardDate = standardDate;
+    return std::make_unique<RulesProvider>(zone);
+}
+
+typedef TimeSource::TimePoint TimePoint;
+
+static long long utc(int year, int month, int day, int hour, int minute = 0, int second = 0) {
+    return daysFromCivil(year, month, day) * 86400 + hour * 3600LL + minute * 60LL + second;
+}
+
+static TimePoint at(long long utcSeconds) {
+    return TimePoint(std::chrono::duration_cast<TimePoint::duration>(std::chrono::seconds(utcSeconds)));
+}
+
+static long long seconds(TimePoint time) {
+    return std::chrono::duration_cast<std::chrono::seconds>(time.time_since_epoch()).count();
+}
+
+static long long localDay(TimeZoneTable& zone, long long utcSeconds) {
+    long long local = utcSeconds + zone.offsetMinutesAt(utcSeconds) * 60LL;
+    return local >= 0 ? local / 86400 : (local - 86399) / 86400;
+}
+
+// First whole minute after from with a different local date; zone switches
+// and midnights all fall on whole minutes
+static long long bruteForceMidnight(TimeZoneTable& zone, long long from) {
+    long long today = localDay(zone, from);
+    long long t = (from / 60 + 1) * 60;
+    while (localDay(zone, t) == today) t += 60;
+    return t;
+}
+
+static int localSecond(TimeZoneTable& zone, long long utcSeconds) {
+    long long local = utcSeconds + zone.offsetMinutesAt(utcSeconds) * 60LL;
+    return static_cast<int>(local - localDay(zone, utcSeconds) * 86400);
+}
+
+int main() {
+    const int kSunday = 0;
+
+    // US Eastern, with the schedule for New York on the spring switch weekend
+    TimeZoneTable newYork(rules(-300, -240, recurring(3, kSunday, 2, 2), recurring(11, kSunday, 1, 2)));
+    SolarTimes solarTimes;
+    computeLocalSolarTimes(2024, 3, 9, 40.7128, -74.0060, newYork, solarTimes);
+    ColorSchedule schedule;
+    schedule.build(solarTimes);
+
+    const long long start = utc(2024, 3, 9, 17); // 12:00 EST
+    SimulatedTimeSource clock(at(start), 0.0);
+    CHECK(clock.isStepped());
+    UpdateScheduler scheduler(clock, newYork);
+
+    // The stepped clock only moves forward, and only when told
+    CHECK_EQ(seconds(clock.now()), start);
+    clock.advanceTo(at(start + 90));
+    CHECK_EQ(seconds(clock.now()), start + 90);
+    clock.advanceTo(at(start + 30));
+    CHECK_EQ(seconds(clock.now()), start + 90);
+
+    // The color deadline is the first second whose color pair differs from
+    // now's, across the whole day
+    for (long long now = utc(2024, 3, 9, 5); now < utc(2024, 3, 10, 5); now += 97) {
+        long long change = seconds(scheduler.nextGradientChange(schedule, at(now)));
+        int second = localSecond(newYork, now);
+        CHECK(change > now);
+        int ahead = static_cast<int>(change - now);
+        for (int step = 1; step < ahead; step++) {
+            CHECK(schedule.colorAtSecond(second + step) == schedule.colorAtSecond(second)
+                  && schedule.colorAtSecond(second + step + 3600) == schedule.colorAtSecond(second + 3600));
+        }
+        if (second + ahead < 24 * 3600) {
+            CHECK(schedule.colorAtSecond(second + ahead) != schedule.colorAtSecond(second)
+                  || schedule.colorAtSecond(second + ahead + 3600) != schedule.colorAtSecond(second + 3600));
+        } else {
+            CHECK_EQ(second + ahead, 24 * 3600); // stops at midnight
+        }
+    }
+
+    // An instant when the colors hold for over a minute, so the ticks win
+    long long flat = utc(2024, 3, 9, 8); // 03:00 EST, deep night
+    while (seconds(scheduler.nextGradientChange(schedule, at(flat))) - flat <= 60) flat += 60;
+    CHECK(flat < utc(2024, 3, 9, 10));
+
+    // Status tick: 15 seconds after the last status update
+    CHECK_EQ(seconds(scheduler.nextDeadline(schedule, at(flat - 5), at(flat))), flat + 10);
+    // Accent tick: 30 minutes after the last accent update
+    CHECK_EQ(seconds(scheduler.nextDeadline(schedule, at(flat), at(flat - 1795))), flat + 5);
+    // Color change: sooner than both ticks
+    long long busy = utc(2024, 3, 9, 11); // 06:00 EST, dawn
+    long long busyChange = seconds(scheduler.nextGradientChange(schedule, at(busy)));
+    CHECK(busyChange - busy < 15);
+    SimulatedTimeSource dawnClock(at(busy), 0.0);
+    CHECK_EQ(seconds(UpdateScheduler(dawnClock, newYork).nextDeadline(schedule, at(busy), at(busy))), busyChange);
+
+    // Midnight: EST and EDT days, the spring-forward day (23 hours) and the
+    // fall-back day (25 hours)
+    CHECK_EQ(seconds(scheduler.nextMidnight(at(utc(2024, 3, 9, 17)))), utc(2024, 3, 10, 5));
+    CHECK_EQ(seconds(scheduler.nextMidnight(at(utc(2024, 3, 10, 5)))), utc(2024, 3, 11, 4));
+    CHECK_EQ(seconds(scheduler.nextMidnight(at(utc(2024, 7, 1, 3, 59, 59)))), utc(2024, 7, 1, 4));
+    CHECK_EQ(seconds(scheduler.nextMidnight(at(utc(2024, 11, 3, 4)))), utc(2024, 11, 4, 5));
+    clock.advanceTo(at(utc(2024, 3, 10, 4, 59, 58)));
+    CHECK_EQ(seconds(scheduler.nextDeadline(schedule, clock.now(), clock.now())), utc(2024, 3, 10, 5));
+
+    // Zones that switch at midnight: spring forward skips 00:00-00:59, so the
+    // date changes at the switch; fall back repeats 23:00-23:59, so it
+    // changes on the second pass
+    TimeZoneTable santiago(rules(-240, -180, recurring(9, kSunday, 1, 0), recurring(4, kSunday, 1, 0)));
+    UpdateScheduler santiagoScheduler(clock, santiago);
+    CHECK_EQ(santiago.offsetMinutesAt(utc(2024, 9, 1, 4) - 1), -240);
+    CHECK_EQ(santiago.offsetMinutesAt(utc(2024, 9, 1, 4)), -180);
+    CHECK_EQ(seconds(santiagoScheduler.nextMidnight(at(utc(2024, 9, 1, 3)))), utc(2024, 9, 1, 4));
+    CHECK_EQ(santiago.offsetMinutesAt(utc(2024, 4, 7, 3) - 1), -180);
+    CHECK_EQ(santiago.offsetMinutesAt(utc(2024, 4, 7, 3)), -240);
+    CHECK_EQ(seconds(santiagoScheduler.nextMidnight(at(utc(2024, 4, 7, 2)))), utc(2024, 4, 7, 4));
+    CHECK_EQ(seconds(santiagoScheduler.nextMidnight(at(utc(2024, 4, 7, 3, 30)))), utc(2024, 4, 7, 4));
+
+    // Against a minute-by-minute search around every switch above
+    const long long around[] = { utc(2024, 3, 10, 7), utc(2024, 11, 3, 6), utc(2024, 9, 1, 4), utc(2024, 4, 7, 3) };
+    for (long long instant : around) {
+        for (long long now = instant - 30 * 3600; now < instant + 30 * 3600; now += 1234) {
+            CHECK_EQ(seconds(scheduler.nextMidnight(at(now))), bruteForceMidnight(newYork, now));
+            CHECK_EQ(seconds(santiagoScheduler.nextMidnight(at(now))), bruteForceMidnight(santiago, now));
+        }
+    }
+
+    // Two days of the main loop from noon before the spring switch: update
+    // the ticks that are due, sleep to the next deadline
+    SimulatedTimeSource loopClock(at(start), 0.0);
+    UpdateScheduler loopScheduler(loopClock, newYork);
+    TimePoint lastStatus = loopClock.now(), lastAccent = loopClock.now();
+    const long long end = start + 48 * 3600;
+    std::vector<long> wakeupsPerHour(48, 0);
+    long statusTicks = 0, accentTicks = 0;
+    while (seconds(loopClock.now()) < end) {
+        TimePoint now = loopClock.now();
+        if (now - lastStatus >= std::chrono::seconds(UpdateScheduler::kStatusIntervalSeconds)) {
+            lastStatus = now;
+            statusTicks++;
+        }
+        if (now - lastAccent >= std::chrono::seconds(UpdateScheduler::kAccentIntervalSeconds)) {
+            lastAccent = now;
+            accentTicks++;
+        }
+        TimePoint deadline = loopScheduler.nextDeadline(schedule, lastStatus, lastAccent);
+        CHECK(deadline > now);
+        if (deadline <= now) break;
+        loopClock.advanceTo(deadline);
+        wakeupsPerHour[static_cast<size_t>((seconds(now) - start) / 3600)]++;
+    }
+
+    // Every tick fired on time (the last ones fall on the end), and no hour
+    // woke more than once a second
+    CHECK_EQ(statusTicks, 48L * 3600 / UpdateScheduler::kStatusIntervalSeconds - 1);
+    CHECK_EQ(accentTicks, 48L * 3600 / UpdateScheduler::kAccentIntervalSeconds - 1);
+    const long kPolledPerHour = static_cast<long>(3600 / 0.016);
+    long busiest = 0, total = 0;
+    for (long wakeups : wakeupsPerHour) {
+        CHECK(wakeups >= 3600 / UpdateScheduler::kStatusIntervalSeconds);
+        CHECK(wakeups <= 3600);
+        busiest = std::max(busiest, wakeups);
+        total += wakeups;
+    }
+    std::cout << "Wakeups per simulated hour: " << total / 48 << " average, " << busiest << " busiest, against "
+              << kPolledPerHour << " polling every 16 ms" << std::endl;
+    CHECK(busiest * 50 < kPolledPerHour);
+    return checkResult();
+}
@@ -0,0 +1,140 @@
+// Time zone conversion around daylight saving boundaries, with the rules
+// fed in the form Windows reports them: the switch instants for northern
+// and southern zones, "last weekday" rules in short months, absolute dates,
+// events either side of a switch on the same day, and solar times on the
+// day the clocks change.
+#include "timewallpaper_core.h"
+#include "check.h"
+
+// Fixed rules, counting how often the table asks for a year
+class RulesProvider : public TimeZoneProvider {
+public:
+    explicit RulesProvider(const ZoneRules& rules) : rules(rules) {}
+
+    ZoneRules rulesForYear(int) override {
+        calls++;
+        return rules;
+    }
+
+    int calls = 0;
+
+private:
+    ZoneRules rules;
+};
+
+// Recurring "Nth weekday of month" date; nth 5 means the last one
+static ZoneDate recurring(int month, int weekday, int nth, int hour) {
+    ZoneDate date = {};
+    date.wMonth = static_cast<uint16_t>(month);
+    date.wDayOfWeek = static_cast<uint16_t>(weekday);
+    date.wDay = static_cast<uint16_t>(nth);
+    date.wHour = static_cast<uint16_t>(hour);
+    return date;
+}
+
+static ZoneRules rules(int standardOffset, int daylightOffset, ZoneDate daylightDate, ZoneDate standardDate) {
+    ZoneRules zone = {};
+    zone.standardOffsetMinutes = standardOffset;
+    zone.daylightOffsetMinutes = daylightOffset;
+    zone.daylightDate = daylightDate;
+    zone.standardDate = standardDate;
+    return zone;
+}
+
+static long long utc(int year, int month, int day, int hour, int minute = 0) {
+    return daysFromCivil(year, month, day) * 86400 + hour * 3600LL + minute * 60LL;
+}
+
+// The offset is `before` up to one second ahead of `instant` and `after` from it on
+static void checkSwitch(TimeZoneTable& zone, long long instant, int before, int after) {
+    CHECK_EQ(zone.offsetMinutesAt(instant - 1), before);
+    CHECK_EQ(zone.offsetMinutesAt(instant), after);
+    CHECK_EQ(zone.offsetMinutesAt(instant - 3600), before);
+    CHECK_EQ(zone.offsetMinutesAt(instant + 3600), after);
+}
+
+int main() {
+    const int kSunday = 0;
+
+    // US Eastern: second Sunday of March 02:00 EST, first Sunday of November 02:00 EDT
+    auto eastern = std::make_unique<RulesProvider>(rules(-300, -240, recurring(3, kSunday, 2, 2), recurring(11, kSunday, 1, 2)));
+    RulesProvider* easternRules = eastern.get();
+    TimeZoneTable newYork(std::move(eastern));
+    checkSwitch(newYork, utc(2024, 3, 10, 7), -300, -240);
+    checkSwitch(newYork, utc(2024, 11, 3, 6), -240, -300);
+    checkSwitch(newYork, utc(2025, 3, 9, 7), -300, -240);
+    checkSwitch(newYork, utc(2025, 11, 2, 6), -240, -300);
+    CHECK_EQ(newYork.offsetMinutesAt(utc(2024, 1, 1, 0)), -300);
+    CHECK_EQ(newYork.offsetMinutesAt(utc(2023, 12, 31, 23, 59)), -300);
+
+    // Same-day events either side of the spring switch (07:00 UTC)
+    CHECK(std::fabs(newYork.utcToLocalHour(2024, 3, 10, 6.5) - 1.5) < 1e-9);
+    CHECK(std::fabs(newYork.utcToLocalHour(2024, 3, 10, 7.5) - 3.5) < 1e-9);
+    CHECK(std::fabs(newYork.utcToLocalHour(2024, 3, 9, 11.0) - 6.0) < 1e-9);
+    CHECK(std::fabs(newYork.utcToLocalHour(2024, 3, 10, 11.0) - 7.0) < 1e-9);
+    // UTC hours past midnight (a sunset late in the UTC day) wrap into the local day
+    CHECK(std::fabs(newYork.utcToLocalHour(2024, 6, 21, 24.5) - 20.5) < 1e-9);
+    CHECK(std::fabs(newYork.utcToLocalHour(2024, 6, 21, 1.0) - 21.0) < 1e-9);
+
+    // Each year's rules are read once
+    CHECK_EQ(easternRules->calls, 3);
+    newYork.offsetMinutesAt(utc(2024, 7, 1, 0));
+    CHECK_EQ(easternRules->calls, 3);
+    newYork.clear();
+    newYork.offsetMinutesAt(utc(2024, 7, 1, 0));
+    CHECK_EQ(easternRules->calls, 4);
+
+    // UK: last Sunday of March 01:00 GMT, last Sunday of October 02:00 BST
+    TimeZoneTable london(std::make_unique<RulesProvider>(rules(0, 60, recurring(3, kSunday, 5, 1), recurring(10, kSunday, 5, 2))));
+    checkSwitch(london, utc(2024, 3, 31, 1), 0, 60);
+    checkSwitch(london, utc(2024, 10, 27, 1), 60, 0);
+    checkSwitch(london, utc(2026, 3, 29, 1), 0, 60);  // March 2026 has four Sundays after the 1st
+    checkSwitch(london, utc(2026, 10, 25, 1), 60, 0);
+
+    // Sydney: the year starts on daylight time. First Sunday of October 02:00
+    // AEST, first Sunday of April 03:00 AEDT
+    TimeZoneTable sydney(std::make_unique<RulesProvider>(rules(600, 660, recurring(10, kSunday, 1, 2), recurring(4, kSunday, 1, 3))));
+    checkSwitch(sydney, utc(2024, 4, 6, 16), 660, 600);
+    checkSwitch(sydney, utc(2024, 10, 5, 16), 600, 660);
+    CHECK_EQ(sydney.offsetMinutesAt(utc(2024, 1, 1, 0)), 660);
+    CHECK_EQ(sydney.offsetMinutesAt(utc(2023, 12, 31, 23, 59)), 660);
+    // A UTC afternoon on the switch date is already the next local day
+    CHECK(std::fabs(sydney.utcToLocalHour(2024, 10, 5, 15.5) - 1.5) < 1e-9);
+    CHECK(std::fabs(sydney.utcToLocalHour(2024, 10, 5, 16.5) - 3.5) < 1e-9);
+
+    // "Last Sunday of February" in a year with four Sundays falls back a week
+    TimeZoneTable february(std::make_unique<RulesProvider>(rules(0, 60, recurring(2, kSunday, 5, 2), recurring(9, kSunday, 5, 2))));
+    checkSwitch(february, utc(2026, 2, 22, 2), 0, 60);
+    checkSwitch(february, utc(2024, 2, 25, 2), 0, 60); // leap year: 29 Feb 2024 is a Thursday
+
+    // Absolute rule dates (wYear set) apply as given
+    ZoneDate start = {};
+    start.wYear = 2024;
+    start.wMonth = 5;
+    start.wDay = 17;
+    start.wHour = 12;
+    ZoneDate end = start;
+    end.wMonth = 8;
+    end.wDay = 2;
+    TimeZoneTable absolute(std::make_unique<RulesProvider>(rules(120, 180, start, end)));
+    checkSwitch(absolute, utc(2024, 5, 17, 10), 120, 180);
+    checkSwitch(absolute, utc(2024, 8, 2, 9), 180, 120);
+
+    // No daylight rules: one offset all year
+    TimeZoneTable tokyo(std::make_unique<FixedOffsetTimeZoneProvider>(540));
+    CHECK_EQ(tokyo.offsetMinutesAt(utc(2024, 3, 10, 7)), 540);
+    CHECK_EQ(tokyo.offsetMinutesAt(utc(2024, 11, 3, 6)), 540);
+
+    // Local sunrise in New York jumps by the hour the clocks moved, give or
+    // take the day's own drift of about a minute
+    SolarTimes saturday, sunday, autumnSaturday, autumnSunday;
+    computeLocalSolarTimes(2024, 3, 9, 40.7128, -74.0060, newYork, saturday);
+    computeLocalSolarTimes(2024, 3, 10, 40.7128, -74.0060, newYork, sunday);
+    computeLocalSolarTimes(2024, 11, 2, 40.7128, -74.0060, newYork, autumnSaturday);
+    computeLocalSolarTimes(2024, 11, 3, 40.7128, -74.0060, newYork, autumnSunday);
+    CHECK(std::fabs(sunday.sunrise_hour - saturday.sunrise_hour - 1.0) < 2.0 / 60.0);
+    CHECK(std::fabs(sunday.sunset_hour - saturday.sunset_hour - 1.0) < 2.0 / 60.0);
+    CHECK(std::fabs(autumnSunday.sunrise_hour - autumnSaturday.sunrise_hour + 1.0) < 2.0 / 60.0);
+    CHECK(std::fabs(autumnSunday.solar_noon_hour - autumnSaturday.solar_noon_hour + 1.0) < 2.0 / 60.0);
+    return checkResult();
+}
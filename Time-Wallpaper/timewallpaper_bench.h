@@ -0,0 +1,637 @@
+// timewallpaper_bench.h - microbenchmark harness over the portable core.
+// TimeWallpaper.exe --benchmark runs it with the Windows-only cases added;
+// bench/benchmark_main.cpp runs it on any platform.
+#ifndef TIMEWALLPAPER_BENCH_H
+#define TIMEWALLPAPER_BENCH_H
+
+#include "timewallpaper_core.h"
+
+// Microbenchmarks for the color, render, cache and parsing hot paths.
+// Each case is calibrated to about 20 ms per batch and timed over several
+// batches; results are written as JSON so runs can be compared across releases.
+class BenchmarkSuite {
+public:
+    struct Result {
+        std::string name;
+        long long iterations;
+        double medianNsPerOp;
+        double minNsPerOp;
+        double pixelsPerOp; // raster cases also report Mpixel/s; 0 otherwise
+    };
+
+    // fn returns a checksum so the work cannot be optimized away
+    template <typename Fn>
+    void add(const std::string& name, Fn&& fn) {
+        report(measure(name, std::forward<Fn>(fn), 0.0));
+    }
+
+    // add() for cases that write pixelsPerOp pixels per call
+    template <typename Fn>
+    void addPixels(const std::string& name, double pixelsPerOp, Fn&& fn) {
+        report(measure(name, std::forward<Fn>(fn), pixelsPerOp));
+    }
+
+    template <typename Fn>
+    Result measure(const std::string& name, Fn&& fn, double pixelsPerOp) {
+        typedef std::chrono::steady_clock Clock;
+        long long batch = 1;
+        for (;;) {
+            auto start = Clock::now();
+            for (long long i = 0; i < batch; i++) sink += static_cast<uint64_t>(fn());
+            if (Clock::now() - start >= std::chrono::milliseconds(kBatchMilliseconds) || batch >= (1LL << 30)) break;
+            batch *= 2;
+        }
+
+        std::vector<double> samples;
+        for (int run = 0; run < kBatches; run++) {
+            auto start = Clock::now();
+            for (long long i = 0; i < batch; i++) sink += static_cast<uint64_t>(fn());
+            double elapsedNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+            samples.push_back(elapsedNs / batch);
+        }
+        std::sort(samples.begin(), samples.end());
+        return { name, batch * kBatches, samples[samples.size() / 2], samples.front(), pixelsPerOp };
+    }
+
+    // Times fixed bursts of calls with settle() run untimed before each, for
+    // cases whose cost depends on background work keeping up (the logger ring)
+    template <typename Fn, typename Settle>
+    void addBursts(const std::string& name, int burst, Fn&& fn, Settle&& settle) {
+        typedef std::chrono::steady_clock Clock;
+        std::vector<double> samples;
+        for (int run = 0; run < kBurstRuns; run++) {
+            settle();
+            auto start = Clock::now();
+            for (int i = 0; i < burst; i++) sink += static_cast<uint64_t>(fn());
+            samples.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count() / burst);
+        }
+        std::sort(samples.begin(), samples.end());
+
+        report({ name, static_cast<long long>(burst) * kBurstRuns, samples[samples.size() / 2], samples.front(), 0.0 });
+    }
+
+    void report(const Result& result) {
+        results.push_back(result);
+        std::cout << "  " << std::left << std::setw(32) << result.name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(14) << result.medianNsPerOp << " ns/op";
+        if (result.pixelsPerOp > 0) std::cout << std::setw(10) << megapixelsPerSecond(result) << " Mpixel/s";
+        std::cout << std::endl;
+    }
+
+    static double megapixelsPerSecond(const Result& result) {
+        return result.pixelsPerOp * 1000.0 / result.medianNsPerOp;
+    }
+
+    std::string toJson() const {
+        std::stringstream json;
+        json << std::fixed << std::setprecision(3);
+        json << "{\n  \"suite\": \"TimeWallpaper\",\n";
+        json << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n";
+        json << "  \"benchmarks\": [\n";
+        for (size_t i = 0; i < results.size(); i++) {
+            const Result& result = results[i];
+            json << "    {\"name\": \"" << result.name << "\", \"iterations\": " << result.iterations
+                 << ", \"median_ns_per_op\": " << result.medianNsPerOp
+                 << ", \"min_ns_per_op\": " << result.minNsPerOp;
+            if (result.pixelsPerOp > 0) json << ", \"mpixels_per_s\": " << megapixelsPerSecond(result);
+            json << "}"
+                 << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        json << "  ]\n}\n";
+        return json.str();
+    }
+
+    // Fixed inputs so runs are comparable: New York on 2024-06-21
+    static SolarTimes sampleSolarTimes() {
+        SolarTimes solarTimes;
+        SolarCalculator::Events events = SolarCalculator::compute(2024, 6, 21, 40.7128, -74.0060);
+        solarTimes.sunrise_hour = events.sunrise - 4.0;
+        solarTimes.sunset_hour = events.sunset - 4.0;
+        solarTimes.solar_noon_hour = events.solar_noon - 4.0;
+        solarTimes.civil_twilight_begin = events.civil_twilight_begin - 4.0;
+        solarTimes.civil_twilight_end = events.civil_twilight_end - 4.0;
+        solarTimes.valid = true;
+        return solarTimes;
+    }
+
+    // A full 30-day window starting 2024-06-21
+    static SolarCache sampleSolarWindow() {
+        SolarCache cache;
+        const SolarTimes solarTimes = sampleSolarTimes();
+        const long long firstDay = daysFromCivil(2024, 6, 21);
+        for (int day = 0; day < 30; day++) {
+            SolarTimes entry = solarTimes;
+            entry.fetch_date = SolarCache::formatDay(firstDay + day);
+            entry.source = "computed";
+            entry.refreshed_day = firstDay;
+            cache.put(firstDay + day, entry);
+        }
+        cache.last_updated = "2024-06-21";
+        return cache;
+    }
+
+    // Cases that need the platform (file mapping, system time zones) are
+    // added by platformCases; scratch files are named after outputPath
+    typedef std::function<void(BenchmarkSuite& suite, const std::string& scratchPath)> PlatformCases;
+
+    static int runAll(const std::string& outputPath, const PlatformCases& platformCases = nullptr) {
+        BenchmarkSuite suite;
+        std::cout << "Running benchmarks..." << std::endl;
+
+        const SolarTimes solarTimes = sampleSolarTimes();
+
+        // Offline ephemeris for every day of 2024 at New York
+        const long long yearStart = daysFromCivil(2024, 1, 1);
+        suite.add("solar_ephemeris_year", [&] {
+            double sum = 0.0;
+            for (long long day = yearStart; day < yearStart + 366; day++) {
+                int year, month, dayOfMonth;
+                civilFromDays(day, year, month, dayOfMonth);
+                SolarCalculator::Events events = SolarCalculator::compute(year, month, dayOfMonth, 40.7128, -74.0060);
+                sum += events.sunrise + events.sunset;
+            }
+            return sum;
+        });
+
+        ColorSchedule schedule;
+        suite.add("color_schedule_build", [&] {
+            schedule.build(solarTimes);
+            return schedule.colorAtSecond(43200).r;
+        });
+
+        int step = 0;
+        suite.add("getColorForHour", [&] {
+            step = (step + 7919) % 86400;
+            PeriodId period;
+            Color color = schedule.colorAtHour(step / 3600.0, &period);
+            return color.r + color.g + color.b + static_cast<int>(period);
+        });
+
+        std::vector<int> minuteSeconds(24 * 60);
+        for (size_t i = 0; i < minuteSeconds.size(); i++) minuteSeconds[i] = static_cast<int>(i) * 60;
+        std::vector<Color> minuteColors(minuteSeconds.size());
+        suite.add("colorsAtSeconds_1440", [&] {
+            schedule.colorsAtSeconds(minuteSeconds.data(), minuteSeconds.size(), minuteColors.data());
+            return minuteColors[720].g;
+        });
+
+        std::vector<ColorSchedule::Sample> daySamples(24 * 3600);
+        suite.add("sweep_day_per_second", [&] {
+            schedule.sweep(1, daySamples.size(), daySamples.data());
+            return daySamples[43200].b;
+        });
+
+        suite.add("interpolateColor", [&] {
+            step = (step + 7919) % 86400;
+            Color color = interpolateColor(Color(10, 20, 60), Color(250, 180, 90), step / 86400.0);
+            return color.r + color.g + color.b;
+        });
+
+        std::vector<Color> blended(1024);
+        suite.add("lerpColor_1024", [&] {
+            Color start(10, 20, 60), end(250, 180, 90);
+            for (size_t i = 0; i < blended.size(); i++) {
+                blended[i] = lerpColor(start, end, static_cast<Fixed16>(i * 64));
+            }
+            return blended[512].g;
+        });
+
+        // The same ramp through the double blend the 16.16 one replaced
+        suite.add("lerpColor_1024_double", [&] {
+            Color start(10, 20, 60), end(250, 180, 90);
+            for (size_t i = 0; i < blended.size(); i++) {
+                blended[i] = legacyInterpolateColor(start, end, (i * 64) / 65536.0);
+            }
+            return blended[512].g;
+        });
+
+        // Single-thread full frames and tile-wide strips at 1080p, 1440p and
+        // 4K, with the Bayer and blue-noise tiles; the blue-noise tile is
+        // built before timing starts
+        struct Resolution { int width, height; };
+        const Resolution resolutions[] = { {1920, 1080}, {2560, 1440}, {3840, 2160} };
+        std::vector<uint8_t> pixels(static_cast<size_t>(3840) * 2160 * 4);
+        const DitherPattern& blueNoise = DitherPattern::blueNoise();
+        for (const Resolution& resolution : resolutions) {
+            const int width = resolution.width, height = resolution.height;
+            const std::string size = std::to_string(width) + "x" + std::to_string(height);
+            const size_t middle = static_cast<size_t>(width) * height * 2;
+            suite.addPixels("rasterize_" + size, width * height, [&, width, height, middle] {
+                GradientRasterizer(Color(10, 20, 60), Color(250, 180, 90)).rasterize(pixels.data(), width, height);
+                return pixels[middle];
+            });
+
+            suite.addPixels("rasterize_tile_8x" + std::to_string(height), 8 * height, [&, height] {
+                GradientRasterizer(Color(10, 20, 60), Color(250, 180, 90)).rasterize(pixels.data(), 8, height);
+                return pixels[8 * 4 * (height / 2)];
+            });
+
+            suite.addPixels("rasterize_" + size + "_blue_noise", width * height, [&, width, height, middle] {
+                GradientRasterizer(Color(10, 20, 60), Color(250, 180, 90), blueNoise).rasterize(pixels.data(), width, height);
+                return pixels[middle];
+            });
+
+            suite.addPixels("rasterize_tile_64x" + std::to_string(height) + "_blue_noise", 64 * height, [&, height] {
+                GradientRasterizer(Color(10, 20, 60), Color(250, 180, 90), blueNoise).rasterize(pixels.data(), 64, height);
+                return pixels[64 * 4 * (height / 2)];
+            });
+        }
+
+        // Thread scaling: 1 to 16 4K monitors split into the render loop's
+        // 64-row bands, every band of every monitor queued on one pool.run as
+        // renderFrame does, across pools of 1, 2, 4, ... hardware threads.
+        // The one-monitor cases keep their original names.
+        const int bandRows = 64, width4k = 3840, height4k = 2160;
+        const int kMaxMonitors = 16;
+        std::vector<std::vector<uint8_t>> frames4k(kMaxMonitors, std::vector<uint8_t>(static_cast<size_t>(width4k) * height4k * 4));
+        const size_t bandsPerFrame = (height4k + bandRows - 1) / bandRows;
+        const int hardwareThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        const GradientRasterizer rasterizer(Color(10, 20, 60), Color(250, 180, 90));
+        for (int threads = 1; ; threads = std::min(threads * 2, hardwareThreads)) {
+            WorkStealingPool pool(threads);
+            for (int monitors = 1; monitors <= kMaxMonitors; monitors *= 2) {
+                std::string name = "rasterize_3840x2160_";
+                if (monitors > 1) name += "x" + std::to_string(monitors) + "_";
+                suite.addPixels(name + std::to_string(threads) + (threads == 1 ? "_thread" : "_threads"),
+                                static_cast<double>(width4k) * height4k * monitors, [&, monitors] {
+                    pool.run(bandsPerFrame * monitors, [&](size_t band) {
+                        uint8_t* frame = frames4k[band / bandsPerFrame].data();
+                        int rowBegin = static_cast<int>(band % bandsPerFrame) * bandRows;
+                        rasterizer.rasterizeRows(frame, width4k, height4k, rowBegin, std::min(height4k, rowBegin + bandRows));
+                    });
+                    return frames4k[monitors - 1][frames4k[monitors - 1].size() / 2];
+                });
+            }
+            if (threads == hardwareThreads) break;
+        }
+
+        // The row fill kernels alone over each frame size, one 8-pixel Bayer row pattern
+        alignas(32) uint8_t rowPattern[8 * 4];
+        for (int i = 0; i < 8 * 4; i++) rowPattern[i] = static_cast<uint8_t>(i * 37);
+        auto addRowFill = [&](const std::string& kernel, RowFillFn fillRow) {
+            for (const Resolution& resolution : resolutions) {
+                const int width = resolution.width, height = resolution.height;
+                suite.addPixels("fill_rows_" + std::to_string(width) + "x" + std::to_string(height) + "_" + kernel,
+                                width * height, [&, fillRow, width, height] {
+                    for (int y = 0; y < height; y++) fillRow(pixels.data() + static_cast<size_t>(y) * width * 4, rowPattern, 8, width);
+                    return pixels[static_cast<size_t>(width) * height * 2];
+                });
+            }
+        };
+        addRowFill("scalar", fillRowScalar);
+#ifdef TIMEWALLPAPER_X86
+        addRowFill("sse2", fillRowSSE2);
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) addRowFill("avx2", fillRowAVX2);
+#endif
+
+        SolarCache cache = sampleSolarWindow();
+        const long long firstDay = daysFromCivil(2024, 6, 21);
+        suite.add("solar_window_find", [&] {
+            step = (step + 7919) % 86400;
+            SolarTimes* entry = cache.find(firstDay + step % 30);
+            return entry ? entry->sunrise_hour : 0.0;
+        });
+
+        std::string encoded = SolarCacheCodec::encode(cache);
+        suite.add("solar_cache_encode", [&] { return SolarCacheCodec::encode(cache).size(); });
+        suite.add("solar_cache_decode", [&] {
+            SolarCache decoded;
+            return SolarCacheCodec::decode(encoded.data(), encoded.size(), decoded) ? decoded.days.size() : 0;
+        });
+
+        // The same window in the old solar_cache.txt layout, read back by the
+        // getline/substr/stod parser the binary format replaced
+        const std::string legacyText = legacySolarCacheText(cache);
+        suite.add("solar_cache_text_parse", [&] {
+            SolarCache parsed;
+            return legacyParseSolarCacheText(legacyText, parsed) ? parsed.days.size() : 0;
+        });
+
+        const std::string response =
+            "{\"results\":{\"sunrise\":\"2024-06-21T09:25:09+00:00\",\"sunset\":\"2024-06-22T00:31:15+00:00\","
+            "\"solar_noon\":\"2024-06-21T16:58:12+00:00\",\"day_length\":54366,"
+            "\"civil_twilight_begin\":\"2024-06-21T08:52:15+00:00\",\"civil_twilight_end\":\"2024-06-22T01:04:09+00:00\","
+            "\"nautical_twilight_begin\":\"2024-06-21T08:11:27+00:00\",\"nautical_twilight_end\":\"2024-06-22T01:44:57+00:00\","
+            "\"astronomical_twilight_begin\":\"2024-06-21T07:23:46+00:00\",\"astronomical_twilight_end\":\"2024-06-22T02:32:38+00:00\"},"
+            "\"status\":\"OK\",\"tzid\":\"UTC\"}";
+        TimeZoneTable zone(std::make_unique<FixedOffsetTimeZoneProvider>(0));
+        suite.add("parseSunriseSunsetJson", [&] {
+            SolarTimes parsed;
+            return parseSunriseSunsetJson(response, zone, parsed) ? static_cast<int>(parsed.sunrise_hour * 60) : 0;
+        });
+
+        // UTC to local through a zone with daylight rules, stepping across
+        // 2024 so lookups land on both sides of each switch. The year's rules
+        // are loaded on the first call; after that only the cached lookup runs.
+        TimeZoneTable eastern(std::make_unique<RulesProvider>(easternRules()));
+        const long long yearSeconds = 366 * 86400LL;
+        long long instant = 0;
+        suite.add("zone_utc_to_local", [&] {
+            instant = (instant + 7919) % yearSeconds;
+            return eastern.offsetMinutesAt(yearStart * 86400 + instant);
+        });
+
+        // A corpus of recorded sunrise-sunset and ip-api responses, parsed by
+        // the scanner and by the find/substr/stod code it replaced
+        const std::vector<std::string> corpus = recordedResponses();
+        suite.add("json_corpus_scanner", [&] {
+            double sum = 0.0;
+            for (const std::string& recorded : corpus) {
+                SolarTimes parsed;
+                double latitude = 0.0, longitude = 0.0;
+                if (parseSunriseSunsetJson(recorded, zone, parsed)) sum += parsed.sunrise_hour;
+                else if (scanIpApi(recorded, latitude, longitude)) sum += latitude + longitude;
+            }
+            return sum;
+        });
+        suite.add("json_corpus_legacy", [&] {
+            double sum = 0.0;
+            for (const std::string& recorded : corpus) {
+                SolarTimes parsed;
+                double latitude = 0.0, longitude = 0.0;
+                if (legacyParseSunriseSunset(recorded, parsed)) sum += parsed.sunrise_hour;
+                else if (legacyParseIpApi(recorded, latitude, longitude)) sum += latitude + longitude;
+            }
+            return sum;
+        });
+
+        // 4096 sites on a lat/lon grid, each on its nearest whole-hour offset
+        std::vector<SiteBatch::Site> sites(4096);
+        for (size_t i = 0; i < sites.size(); i++) {
+            sites[i].id = "site" + std::to_string(i);
+            sites[i].latitude = -60.0 + 120.0 * (i % 64) / 63.0;
+            sites[i].longitude = -180.0 + 360.0 * (i / 64) / 64.0;
+            sites[i].fixedOffset = true;
+            sites[i].offsetMinutes = static_cast<int>(std::lround(sites[i].longitude / 15.0)) * 60;
+            sites[i].zone = (sites[i].offsetMinutes >= 0 ? "UTC+" : "UTC") + std::to_string(sites[i].offsetMinutes / 60);
+        }
+        const long long batchTime = daysFromCivil(2024, 6, 21) * 86400 + 12 * 3600;
+        std::shared_ptr<const ColorTheme> theme = ColorTheme::builtIn();
+        std::vector<SiteBatch::Result> siteResults;
+        WorkStealingPool singlePool(1);
+        suite.add("site_batch_4096_1_thread", [&] {
+            SiteBatch::evaluate(sites, batchTime, theme, singlePool, siteResults);
+            return siteResults[100].current.r;
+        });
+        WorkStealingPool fullPool(hardwareThreads);
+        suite.add("site_batch_4096_all_threads", [&] {
+            SiteBatch::evaluate(sites, batchTime, theme, fullPool, siteResults);
+            return siteResults[100].current.r;
+        });
+
+        suite.add("formatHour", [&] {
+            step = (step + 7919) % 86400;
+            return formatHour(step / 3600.0).size();
+        });
+
+        // Caller-side cost with the logger writing to a real file. Bursts fit in
+        // the ring and it is drained between them, so no call takes the drop path.
+        std::string logPath = outputPath + ".log.txt";
+        {
+            AsyncLogger logger;
+            logger.start(logPath, AsyncLogger::LOG_INFO, 0, 0);
+            auto drain = [&] { logger.flush(); };
+            suite.addBursts("log_3_args", 1024, [&] {
+                logger.log(AsyncLogger::LOG_INFO, "frame {} raster {} us on {} threads", ++step, 812.5, 8);
+                return 1;
+            }, drain);
+            const std::string message = "Solar cache saved successfully for 2024-06-21 (source: computed)";
+            suite.addBursts("log_string_64", 1024, [&] {
+                logger.log(AsyncLogger::LOG_INFO, "{}", message);
+                return 1;
+            }, drain);
+            suite.add("log_filtered_debug", [&] {
+                logger.log(AsyncLogger::LOG_DEBUG, "frame {} raster {} us on {} threads", ++step, 812.5, 8);
+                return 1;
+            });
+            logger.stop();
+            if (logger.getDropped() > 0) std::cout << "  (logger dropped " << logger.getDropped() << " records)" << std::endl;
+        }
+        std::remove(logPath.c_str());
+
+        if (platformCases) platformCases(suite, outputPath);
+
+        std::ofstream out(outputPath);
+        if (!out.is_open()) {
+            std::cout << "Could not write " << outputPath << std::endl;
+            return 1;
+        }
+        out << suite.toJson();
+        std::cout << "Benchmark results written to " << outputPath << std::endl;
+        return 0;
+    }
+
+private:
+    static constexpr int kBatches = 7;
+
+    // Fixed rules handed to a TimeZoneTable
+    class RulesProvider : public TimeZoneProvider {
+    public:
+        explicit RulesProvider(const ZoneRules& rules) : rules(rules) {}
+        ZoneRules rulesForYear(int) override { return rules; }
+
+    private:
+        ZoneRules rules;
+    };
+
+    // US Eastern: second Sunday of March to the first Sunday of November, 02:00
+    static ZoneRules easternRules() {
+        ZoneRules rules = {};
+        rules.standardOffsetMinutes = -300;
+        rules.daylightOffsetMinutes = -240;
+        rules.daylightDate.wMonth = 3;
+        rules.daylightDate.wDay = 2;
+        rules.daylightDate.wHour = 2;
+        rules.standardDate.wMonth = 11;
+        rules.standardDate.wDay = 1;
+        rules.standardDate.wHour = 2;
+        return rules;
+    }
+
+    // The per-channel double blend interpolateColor used before 16.16 fixed point
+    static Color legacyInterpolateColor(Color start, Color end, double ratio) {
+        ratio = std::max(0.0, std::min(1.0, ratio));
+
+        int r = static_cast<int>(start.r * (1 - ratio) + end.r * ratio);
+        int g = static_cast<int>(start.g * (1 - ratio) + end.g * ratio);
+        int b = static_cast<int>(start.b * (1 - ratio) + end.b * ratio);
+
+        return Color(r, g, b);
+    }
+
+    // Responses as the APIs send them: compact, pretty-printed, polar and
+    // error answers, and geolocation results
+    static std::vector<std::string> recordedResponses() {
+        std::vector<std::string> corpus;
+        const char* const dates[] = {"2024-03-20", "2024-06-21", "2024-09-22", "2024-12-21"};
+        for (const char* date : dates) {
+            auto at = [&](const char* time) { return std::string("\"") + date + "T" + time + "+00:00\""; };
+            corpus.push_back("{\"results\":{\"sunrise\":" + at("09:25:09") + ",\"sunset\":" + at("23:31:15")
+                + ",\"solar_noon\":" + at("16:58:12") + ",\"day_length\":50766,\"civil_twilight_begin\":" + at("08:52:15")
+                + ",\"civil_twilight_end\":" + at("23:59:09") + ",\"nautical_twilight_begin\":" + at("08:11:27")
+                + ",\"nautical_twilight_end\":" + at("22:44:57") + ",\"astronomical_twilight_begin\":" + at("07:23:46")
+                + ",\"astronomical_twilight_end\":" + at("21:32:38") + "},\"status\":\"OK\",\"tzid\":\"UTC\"}");
+            corpus.push_back("{\n  \"results\": {\n    \"sunrise\": " + at("05:12:44") + ",\n    \"sunset\": " + at("16:02:10")
+                + ",\n    \"solar_noon\": " + at("10:37:27") + ",\n    \"day_length\": 38966,\n    \"civil_twilight_begin\": "
+                + at("04:40:31") + ",\n    \"civil_twilight_end\": " + at("16:34:23") + "\n  },\n  \"status\": \"OK\",\n  \"tzid\": \"UTC\"\n}\n");
+        }
+        corpus.push_back("{\"results\":{\"sunrise\":\"1970-01-01T00:00:01+00:00\",\"sunset\":\"1970-01-01T00:00:01+00:00\","
+                         "\"solar_noon\":\"2024-06-21T10:44:03+00:00\",\"day_length\":0,"
+                         "\"civil_twilight_begin\":\"1970-01-01T00:00:01+00:00\",\"civil_twilight_end\":\"1970-01-01T00:00:01+00:00\"},"
+                         "\"status\":\"OK\",\"tzid\":\"UTC\"}");
+        corpus.push_back("{\"results\":\"\",\"status\":\"INVALID_DATE\"}");
+        corpus.push_back("{\"status\":\"success\",\"country\":\"Norway\",\"regionName\":\"Troms og Finnmark\","
+                         "\"city\":\"Troms\\u00f8\",\"lat\":69.6489,\"lon\":18.9551}");
+        corpus.push_back("{\"status\":\"success\",\"country\":\"United States\",\"regionName\":\"New York\","
+                         "\"city\":\"New York\",\"lat\":40.7128,\"lon\":-74.006}");
+        corpus.push_back("{\"status\":\"fail\",\"message\":\"reserved range\",\"query\":\"127.0.0.1\"}");
+        return corpus;
+    }
+
+    // The geolocation fields as main.cpp reads them
+    static bool scanIpApi(std::string_view response, double& latitude, double& longitude) {
+        std::string_view status, lat, lon, city;
+        bool wellFormed = JsonScanner::scan(response, [&](const JsonScanner::Member& m) {
+            if (m.depth != 0) return;
+            if (m.key == "status") status = m.value;
+            else if (m.key == "lat" && m.type == JsonScanner::JSON_NUMBER) lat = m.value;
+            else if (m.key == "lon" && m.type == JsonScanner::JSON_NUMBER) lon = m.value;
+            else if (m.key == "city" && m.type == JsonScanner::JSON_STRING) city = m.value;
+        });
+        return wellFormed && status == "success" && JsonScanner::toDouble(lat, latitude)
+            && JsonScanner::toDouble(lon, longitude) && !JsonScanner::unescape(city).empty();
+    }
+
+    // The parsing the scanner replaced, kept for comparison: a find() per
+    // key, substr copies and stringstream/stod conversions. The time zone
+    // lookup it made per field is left out, which only flatters it.
+    static double legacyTimeFromJson(const std::string& json, const std::string& key) {
+        size_t keyPos = json.find(key);
+        if (keyPos == std::string::npos) return 0.0;
+        size_t startQuote = json.find("\"", keyPos + key.length());
+        if (startQuote == std::string::npos) return 0.0;
+        startQuote++;
+        size_t endQuote = json.find("\"", startQuote);
+        if (endQuote == std::string::npos) return 0.0;
+
+        std::string timeStr = json.substr(startQuote, endQuote - startQuote);
+        if (timeStr.length() < 19) return 0.0;
+        std::stringstream ss(timeStr.substr(11, 8));
+        int hours, minutes, seconds;
+        char colon1, colon2;
+        if (ss >> hours >> colon1 >> minutes >> colon2 >> seconds) return hours + (minutes / 60.0) + (seconds / 3600.0);
+        return 0.0;
+    }
+
+    static bool legacyParseSunriseSunset(const std::string& response, SolarTimes& solarTimes) {
+        if (response.find("\"status\":\"OK\"") == std::string::npos) return false;
+        solarTimes.sunrise_hour = legacyTimeFromJson(response, "\"sunrise\":");
+        solarTimes.sunset_hour = legacyTimeFromJson(response, "\"sunset\":");
+        solarTimes.solar_noon_hour = legacyTimeFromJson(response, "\"solar_noon\":");
+        solarTimes.civil_twilight_begin = legacyTimeFromJson(response, "\"civil_twilight_begin\":");
+        solarTimes.civil_twilight_end = legacyTimeFromJson(response, "\"civil_twilight_end\":");
+        return solarTimes.sunrise_hour > 0 && solarTimes.sunset_hour > 0;
+    }
+
+    static bool legacyParseIpApi(const std::string& response, double& latitude, double& longitude) {
+        if (response.find("\"status\":\"success\"") == std::string::npos) return false;
+        try {
+            size_t latPos = response.find("\"lat\":");
+            size_t lonPos = response.find("\"lon\":");
+            size_t cityPos = response.find("\"city\":\"");
+            if (latPos == std::string::npos || lonPos == std::string::npos || cityPos == std::string::npos) return false;
+            latitude = std::stod(response.substr(latPos + 6, response.find_first_of(",}", latPos + 6) - latPos - 6));
+            longitude = std::stod(response.substr(lonPos + 6, response.find_first_of(",}", lonPos + 6) - lonPos - 6));
+            return !response.substr(cityPos + 8, response.find('"', cityPos + 8) - cityPos - 8).empty();
+        } catch (...) {
+            return false;
+        }
+    }
+
+    // The old text cache writer, one [dayN] section per day of the window
+    static std::string legacySolarCacheText(const SolarCache& cache) {
+        std::stringstream text;
+        text << "# TimeWallpaper Solar Cache - Eight Day Data (Today + Next 7 Days)" << std::endl;
+        text << "last_updated=" << cache.last_updated << std::endl;
+        text << std::endl;
+        for (size_t i = 0; i < cache.days.size(); i++) {
+            const SolarTimes& dayData = cache.days[i];
+            text << "[day" << i << "]" << std::endl;
+            text << "date=" << dayData.fetch_date << std::endl;
+            text << "sunrise=" << std::fixed << std::setprecision(6) << dayData.sunrise_hour << std::endl;
+            text << "sunset=" << std::fixed << std::setprecision(6) << dayData.sunset_hour << std::endl;
+            text << "solar_noon=" << std::fixed << std::setprecision(6) << dayData.solar_noon_hour << std::endl;
+            text << "civil_twilight_begin=" << std::fixed << std::setprecision(6) << dayData.civil_twilight_begin << std::endl;
+            text << "civil_twilight_end=" << std::fixed << std::setprecision(6) << dayData.civil_twilight_end << std::endl;
+            text << "valid=" << (dayData.valid ? "true" : "false") << std::endl;
+            text << "source=" << dayData.source << std::endl;
+            text << std::endl;
+        }
+        return text.str();
+    }
+
+    // The old text cache parser, with its 8 fixed slots grown to as many
+    // sections as the text has, then placed by date as the one-time import
+    // does. It reads from memory
+    // rather than the file, which only flatters it.
+    static bool legacyParseSolarCacheText(const std::string& text, SolarCache& cache) {
+        std::istringstream cacheFile(text);
+        std::vector<SolarTimes> legacyDays;
+        std::string lastUpdated;
+
+        std::string line;
+        int currentDayIndex = -1;
+        while (std::getline(cacheFile, line)) {
+            if (line.empty() || line[0] == '#') continue;
+
+            if (line.substr(0, 4) == "[day" && line.back() == ']') {
+                std::string dayStr = line.substr(4, line.length() - 5);
+                currentDayIndex = std::stoi(dayStr);
+                if (currentDayIndex < 0 || currentDayIndex >= SolarCache::kMaxDays) currentDayIndex = -1;
+                else if (currentDayIndex >= static_cast<int>(legacyDays.size())) legacyDays.resize(currentDayIndex + 1);
+                continue;
+            }
+
+            size_t equalPos = line.find('=');
+            if (equalPos != std::string::npos) {
+                std::string key = line.substr(0, equalPos);
+                std::string value = line.substr(equalPos + 1);
+
+                if (key == "last_updated") {
+                    lastUpdated = value;
+                } else if (currentDayIndex >= 0) {
+                    SolarTimes& currentTimes = legacyDays[currentDayIndex];
+                    if (key == "date") currentTimes.fetch_date = value;
+                    else if (key == "sunrise") currentTimes.sunrise_hour = std::stod(value);
+                    else if (key == "sunset") currentTimes.sunset_hour = std::stod(value);
+                    else if (key == "solar_noon") currentTimes.solar_noon_hour = std::stod(value);
+                    else if (key == "civil_twilight_begin") currentTimes.civil_twilight_begin = std::stod(value);
+                    else if (key == "civil_twilight_end") currentTimes.civil_twilight_end = std::stod(value);
+                    else if (key == "valid") currentTimes.valid = (value == "true");
+                    else if (key == "source") currentTimes.source = value;
+                }
+            }
+        }
+
+        cache = SolarCache();
+        cache.last_updated = lastUpdated;
+        long long refreshedDay = 0;
+        SolarCache::parseDay(lastUpdated, refreshedDay);
+        for (SolarTimes& legacyDay : legacyDays) {
+            long long day;
+            if (!SolarCache::parseDay(legacyDay.fetch_date, day)) continue;
+            legacyDay.refreshed_day = refreshedDay;
+            cache.put(day, legacyDay);
+        }
+        return !cache.days.empty();
+    }
+
+    static constexpr int kBatchMilliseconds = 20;
+    static constexpr int kBurstRuns = 200;
+
+    std::vector<Result> results;
+    uint64_t sink = 0;
+};
+
+#endif // TIMEWALLPAPER_BENCH_H
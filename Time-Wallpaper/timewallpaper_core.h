@@ -0,0 +1,3354 @@
+// timewallpaper_core.h - the platform-independent part of TimeWallpaper:
+// solar ephemeris, time zone tables, color themes and schedules, the gradient
+// rasterizer and its work pool, the solar cache format, API response parsing
+// and the asynchronous logger. Nothing here includes Windows.h or SFML, so it
+// builds on any C++17 compiler; main.cpp adds the Win32 and SFML front end.
+#ifndef TIMEWALLPAPER_CORE_H
+#define TIMEWALLPAPER_CORE_H
+
+#include <iostream>
+#include <ctime>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <iomanip>
+#include <sstream>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <string_view>
+#include <charconv>
+#include <random>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <iterator>
+#include <limits>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TIMEWALLPAPER_X86 1
+#endif
+
+// Packed 8-bit RGBA; channel values passed in must already be 0-255
+struct Color {
+    uint8_t r, g, b, a;
+    constexpr Color(int red = 0, int green = 0, int blue = 0, int alpha = 255)
+        : r(static_cast<uint8_t>(red)), g(static_cast<uint8_t>(green)),
+          b(static_cast<uint8_t>(blue)), a(static_cast<uint8_t>(alpha)) {}
+
+    // Little-endian RGBA word, the same byte order as the frame buffer
+    constexpr uint32_t packed() const {
+        return uint32_t(r) | (uint32_t(g) << 8) | (uint32_t(b) << 16) | (uint32_t(a) << 24);
+    }
+
+    constexpr bool operator==(const Color& other) const { return packed() == other.packed(); }
+    constexpr bool operator!=(const Color& other) const { return !(*this == other); }
+};
+
+static_assert(sizeof(Color) == 4, "Color must stay one packed RGBA word");
+static_assert(Color(1, 2, 3).packed() == 0xFF030201u, "Color packs as RGBA bytes");
+
+struct SolarTimes {
+    double sunrise_hour;
+    double sunset_hour;
+    double solar_noon_hour;
+    double civil_twilight_begin;
+    double civil_twilight_end;
+    bool valid = false;
+    std::string fetch_date;
+    std::string source; // "api", "cache", or "fallback"
+    long long refreshed_day = 0; // day number (see daysFromCivil) it was fetched or computed on
+};
+
+// Offline solar ephemeris using the NOAA solar calculator equations
+// (after Meeus, "Astronomical Algorithms"). Results are UTC hours for the
+// given calendar date and are within about a minute of published tables
+// between +/-72 degrees latitude.
+class SolarCalculator {
+public:
+    struct Events {
+        double sunrise, sunset, solar_noon;
+        double civil_twilight_begin, civil_twilight_end;
+    };
+
+    static Events compute(int year, int month, int day, double latitude, double longitude) {
+        double jd0 = julianDay(year, month, day);
+
+        Events events;
+        events.solar_noon = solarNoonUTC(jd0, longitude);
+        events.sunrise = eventUTC(jd0, latitude, longitude, kSunriseZenith, -1.0, events.solar_noon);
+        events.sunset = eventUTC(jd0, latitude, longitude, kSunriseZenith, 1.0, events.solar_noon);
+        events.civil_twilight_begin = eventUTC(jd0, latitude, longitude, kCivilZenith, -1.0, events.solar_noon);
+        events.civil_twilight_end = eventUTC(jd0, latitude, longitude, kCivilZenith, 1.0, events.solar_noon);
+        return events;
+    }
+
+private:
+    static constexpr double kPi = 3.14159265358979323846;
+    static constexpr double kSunriseZenith = 90.833; // refraction + solar disc radius
+    static constexpr double kCivilZenith = 96.0;
+
+    static double toRad(double deg) { return deg * kPi / 180.0; }
+    static double toDeg(double rad) { return rad * 180.0 / kPi; }
+
+    // Julian day at 0h UTC
+    static double julianDay(int year, int month, int day) {
+        if (month <= 2) {
+            year -= 1;
+            month += 12;
+        }
+        int a = year / 100;
+        int b = 2 - a + a / 4;
+        return std::floor(365.25 * (year + 4716)) + std::floor(30.6001 * (month + 1)) + day + b - 1524.5;
+    }
+
+    struct SunPosition {
+        double declination;  // degrees
+        double equationOfTime; // minutes
+    };
+
+    static SunPosition sunPosition(double julianDayUTC) {
+        double t = (julianDayUTC - 2451545.0) / 36525.0;
+
+        double meanLongitude = std::fmod(280.46646 + t * (36000.76983 + t * 0.0003032), 360.0);
+        double meanAnomaly = 357.52911 + t * (35999.05029 - 0.0001537 * t);
+        double eccentricity = 0.016708634 - t * (0.000042037 + 0.0000001267 * t);
+
+        double m = toRad(meanAnomaly);
+        double center = std::sin(m) * (1.914602 - t * (0.004817 + 0.000014 * t))
+                      + std::sin(2 * m) * (0.019993 - 0.000101 * t)
+                      + std::sin(3 * m) * 0.000289;
+
+        double omega = toRad(125.04 - 1934.136 * t);
+        double apparentLongitude = meanLongitude + center - 0.00569 - 0.00478 * std::sin(omega);
+
+        double meanObliquity = 23.0 + (26.0 + (21.448 - t * (46.815 + t * (0.00059 - t * 0.001813))) / 60.0) / 60.0;
+        double obliquity = toRad(meanObliquity + 0.00256 * std::cos(omega));
+
+        SunPosition pos;
+        pos.declination = toDeg(std::asin(std::sin(obliquity) * std::sin(toRad(apparentLongitude))));
+
+        double y = std::tan(obliquity / 2.0);
+        y *= y;
+        double l0 = toRad(meanLongitude);
+        pos.equationOfTime = 4.0 * toDeg(y * std::sin(2 * l0)
+                                         - 2 * eccentricity * std::sin(m)
+                                         + 4 * eccentricity * y * std::sin(m) * std::cos(2 * l0)
+                                         - 0.5 * y * y * std::sin(4 * l0)
+                                         - 1.25 * eccentricity * eccentricity * std::sin(2 * m));
+        return pos;
+    }
+
+    static double solarNoonUTC(double jd0, double longitude) {
+        // Evaluate near noon, then refine once at the computed transit
+        double noon = 12.0 - longitude / 15.0;
+        for (int i = 0; i < 2; i++) {
+            SunPosition pos = sunPosition(jd0 + noon / 24.0);
+            noon = (720.0 - 4.0 * longitude - pos.equationOfTime) / 60.0;
+        }
+        return noon;
+    }
+
+    // direction -1 for morning events, +1 for evening events
+    static double eventUTC(double jd0, double latitude, double longitude, double zenith, double direction, double noonUTC) {
+        double hour = noonUTC;
+        for (int i = 0; i < 2; i++) {
+            SunPosition pos = sunPosition(jd0 + hour / 24.0);
+
+            double lat = toRad(latitude);
+            double dec = toRad(pos.declination);
+            double cosHourAngle = std::cos(toRad(zenith)) / (std::cos(lat) * std::cos(dec)) - std::tan(lat) * std::tan(dec);
+
+            // Polar day/night: the sun never crosses this zenith. If it never
+            // sets, cosHourAngle clamps to -1, the hour angle is 180 degrees
+            // and the event lands on solar midnight; if it never rises, the
+            // clamp to +1 puts the event on solar noon.
+            cosHourAngle = std::max(-1.0, std::min(1.0, cosHourAngle));
+            double hourAngle = toDeg(std::acos(cosHourAngle));
+
+            double transit = (720.0 - 4.0 * longitude - pos.equationOfTime) / 60.0;
+            hour = transit + direction * 4.0 * hourAngle / 60.0;
+        }
+        return hour;
+    }
+};
+
+// Outbound HTTP GET. Implementations are shared between threads and keep
+// connections alive between requests to the same host.
+class HttpClient {
+public:
+    struct Stats {
+        long requests = 0;
+        long connectionsOpened = 0;
+    };
+
+    virtual ~HttpClient() = default;
+    // Response body, or empty on any failure or non-200 status
+    virtual std::string get(const std::string& url, int timeoutMs) = 0;
+    virtual Stats getStats() const = 0;
+};
+
+// Splits http(s)://host[:port][/path?query]; port defaults to the scheme's
+inline bool splitHttpUrl(const std::string& url, bool& secure, std::string& host, unsigned short& port, std::string& path) {
+    size_t schemeEnd = url.find("://");
+    if (schemeEnd == std::string::npos) return false;
+    std::string scheme = url.substr(0, schemeEnd);
+    if (scheme == "https") secure = true;
+    else if (scheme == "http") secure = false;
+    else return false;
+
+    size_t hostStart = schemeEnd + 3;
+    size_t pathStart = url.find('/', hostStart);
+    std::string authority = url.substr(hostStart, pathStart == std::string::npos ? std::string::npos : pathStart - hostStart);
+    path = pathStart == std::string::npos ? "/" : url.substr(pathStart);
+
+    size_t colon = authority.find(':');
+    host = authority.substr(0, colon);
+    port = secure ? 443 : 80;
+    if (colon != std::string::npos) {
+        int parsed = std::atoi(authority.c_str() + colon + 1);
+        if (parsed <= 0 || parsed > 65535) return false;
+        port = static_cast<unsigned short>(parsed);
+    }
+    return !host.empty();
+}
+
+// Issues a batch of GET requests under one overall deadline, on at most
+// maxConcurrent worker threads that take URLs in order. Each request retries
+// once if budget remains, and no request starts after the deadline. Requests
+// still in flight at the deadline are reported as incomplete; their workers
+// finish against the shared batch state and are joined by the next
+// fetchAll() or by the destructor, so none outlives the fetcher.
+class ConcurrentFetcher {
+public:
+    typedef std::function<std::string(const std::string& url, int timeoutMs)> Transport;
+
+    struct Result {
+        std::string body;
+        bool completed = false;
+        int attempts = 0;
+        long latencyMs = 0;
+    };
+
+    static constexpr int kMaxAttempts = 2;
+    static constexpr int kDefaultConcurrency = 4;
+
+    explicit ConcurrentFetcher(int maxConcurrent = kDefaultConcurrency) : concurrency(std::max(1, maxConcurrent)) {}
+
+    ~ConcurrentFetcher() {
+        joinStragglers();
+    }
+
+    ConcurrentFetcher(const ConcurrentFetcher&) = delete;
+    ConcurrentFetcher& operator=(const ConcurrentFetcher&) = delete;
+
+    // Safe to call from several threads; each call runs its own workers
+    std::vector<Result> fetchAll(const std::vector<std::string>& urls, int deadlineMs, Transport transport) {
+        struct Batch {
+            std::mutex mutex;
+            std::condition_variable finished;
+            std::vector<std::string> urls;
+            std::vector<Result> results;
+            size_t next = 0;
+            size_t pending;
+        };
+
+        joinStragglers();
+
+        auto start = std::chrono::steady_clock::now();
+        auto deadline = start + std::chrono::milliseconds(deadlineMs);
+
+        auto batch = std::make_shared<Batch>();
+        batch->urls = urls;
+        batch->results.resize(urls.size());
+        batch->pending = urls.size();
+
+        std::vector<std::thread> workers;
+        const size_t workerCount = std::min(urls.size(), static_cast<size_t>(concurrency));
+        for (size_t w = 0; w < workerCount; w++) {
+            workers.emplace_back([batch, transport, start, deadline] {
+                for (;;) {
+                    size_t i;
+                    {
+                        std::lock_guard<std::mutex> lock(batch->mutex);
+                        if (batch->next == batch->urls.size()) return;
+                        i = batch->next++;
+                    }
+
+                    Result result;
+                    while (result.attempts < kMaxAttempts) {
+                        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+                        if (remaining.count() <= 0) break;
+
+                        result.attempts++;
+                        std::string body = transport(batch->urls[i], static_cast<int>(remaining.count()));
+                        if (!body.empty()) {
+                            result.body = std::move(body);
+                            result.completed = true;
+                            break;
+                        }
+                    }
+                    result.latencyMs = static_cast<long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::steady_clock::now() - start).count());
+
+                    std::lock_guard<std::mutex> lock(batch->mutex);
+                    batch->results[i] = std::move(result);
+                    batch->pending--;
+                    batch->finished.notify_all();
+                }
+            });
+        }
+
+        std::vector<Result> results;
+        {
+            std::unique_lock<std::mutex> lock(batch->mutex);
+            batch->finished.wait_until(lock, deadline, [&] { return batch->pending == 0; });
+            results = batch->results;
+        }
+
+        // Workers past the deadline only finish their current request
+        {
+            std::lock_guard<std::mutex> lock(stragglerMutex);
+            for (std::thread& worker : workers) stragglers.push_back(std::move(worker));
+        }
+
+        // Anything still pending is reported as timed out at the deadline
+        for (auto& result : results) {
+            if (!result.completed && result.attempts == 0 && result.latencyMs == 0) {
+                result.latencyMs = deadlineMs;
+            }
+        }
+        return results;
+    }
+
+private:
+    int concurrency;
+    std::mutex stragglerMutex;
+    std::vector<std::thread> stragglers;
+
+    void joinStragglers() {
+        std::vector<std::thread> finishing;
+        {
+            std::lock_guard<std::mutex> lock(stragglerMutex);
+            finishing.swap(stragglers);
+        }
+        for (std::thread& worker : finishing) worker.join();
+    }
+};
+
+// Days since 1970-01-01 for a proleptic Gregorian date (H. Hinnant's algorithm)
+inline long long daysFromCivil(int year, int month, int day) {
+    year -= month <= 2;
+    long long era = (year >= 0 ? year : year - 399) / 400;
+    unsigned yearOfEra = static_cast<unsigned>(year - era * 400);
+    unsigned dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + static_cast<long long>(dayOfEra) - 719468;
+}
+
+// Inverse of daysFromCivil
+inline void civilFromDays(long long days, int& year, int& month, int& day) {
+    days += 719468;
+    long long era = (days >= 0 ? days : days - 146096) / 146097;
+    unsigned dayOfEra = static_cast<unsigned>(days - era * 146097);
+    unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    unsigned monthIndex = (5 * dayOfYear + 2) / 153;
+    day = static_cast<int>(dayOfYear - (153 * monthIndex + 2) / 5 + 1);
+    month = static_cast<int>(monthIndex < 10 ? monthIndex + 3 : monthIndex - 9);
+    year = static_cast<int>(yearOfEra + era * 400 + (month <= 2 ? 1 : 0));
+}
+
+inline int yearFromDays(long long days) {
+    int year, month, day;
+    civilFromDays(days, year, month, day);
+    return year;
+}
+
+struct ZoneTransition {
+    long long utcSeconds;
+    int offsetMinutes; // local = UTC + offset from this instant on
+};
+
+// Transition date in the layout of a Windows SYSTEMTIME
+struct ZoneDate {
+    uint16_t wYear, wMonth, wDayOfWeek, wDay;
+    uint16_t wHour, wMinute, wSecond, wMilliseconds;
+};
+
+// Standard/daylight rules in the form Windows reports them: biases plus
+// transition dates, either absolute (wYear set) or recurring "Nth weekday
+// of month" (wDay = 1..5, 5 meaning last).
+struct ZoneRules {
+    int standardOffsetMinutes;
+    int daylightOffsetMinutes;
+    ZoneDate standardDate;
+    ZoneDate daylightDate;
+
+    // Offset changes during the year, sorted, the first at 1 Jan 00:00 UTC
+    std::vector<ZoneTransition> transitionsForYear(int year) const {
+        long long yearStart = daysFromCivil(year, 1, 1) * 86400;
+        if (standardDate.wMonth == 0 || daylightDate.wMonth == 0) {
+            return { { yearStart, standardOffsetMinutes } };
+        }
+
+        // Transition times are given in the local time in effect before the switch
+        long long daylightStart = localTransition(year, daylightDate) - standardOffsetMinutes * 60LL;
+        long long daylightEnd = localTransition(year, standardDate) - daylightOffsetMinutes * 60LL;
+
+        // Southern hemisphere zones start the year on daylight time
+        bool startsOnDaylight = daylightStart > daylightEnd;
+        std::vector<ZoneTransition> transitions = {
+            { yearStart, startsOnDaylight ? daylightOffsetMinutes : standardOffsetMinutes },
+            { daylightStart, daylightOffsetMinutes },
+            { daylightEnd, standardOffsetMinutes }
+        };
+        std::sort(transitions.begin(), transitions.end(),
+                  [](const ZoneTransition& a, const ZoneTransition& b) { return a.utcSeconds < b.utcSeconds; });
+        return transitions;
+    }
+
+private:
+    // Local wall-clock seconds since the epoch for a rule date in the given year
+    static long long localTransition(int year, const ZoneDate& date) {
+        int day = date.wDay;
+        if (date.wYear == 0) {
+            // Day of week of the 1st (1970-01-01 was a Thursday)
+            long long firstDays = daysFromCivil(year, date.wMonth, 1);
+            int firstWeekday = static_cast<int>(((firstDays % 7) + 11) % 7);
+            day = 1 + (date.wDayOfWeek - firstWeekday + 7) % 7 + (date.wDay - 1) * 7;
+
+            static const int kDaysInMonth[12] = {31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+            int monthLength = kDaysInMonth[date.wMonth - 1];
+            if (date.wMonth == 2 && !((year % 4 == 0 && year % 100 != 0) || year % 400 == 0)) monthLength = 28;
+            while (day > monthLength) day -= 7;
+        }
+        return daysFromCivil(year, date.wMonth, day) * 86400
+             + date.wHour * 3600LL + date.wMinute * 60LL + date.wSecond;
+    }
+};
+
+// Source of a zone's rules, abstracted so the conversion table can be fed
+// fixed rules instead of the system zone
+class TimeZoneProvider {
+public:
+    virtual ~TimeZoneProvider() {}
+    virtual ZoneRules rulesForYear(int year) = 0;
+};
+
+// A constant UTC offset with no daylight saving
+class FixedOffsetTimeZoneProvider : public TimeZoneProvider {
+public:
+    explicit FixedOffsetTimeZoneProvider(int utcOffsetMinutes) : offsetMinutes(utcOffsetMinutes) {}
+
+    ZoneRules rulesForYear(int) override {
+        ZoneRules rules = {};
+        rules.standardOffsetMinutes = offsetMinutes;
+        rules.daylightOffsetMinutes = offsetMinutes;
+        return rules;
+    }
+
+private:
+    int offsetMinutes;
+};
+
+// UTC to local conversion for arbitrary dates. Each year's transitions are
+// loaded from the provider once and cached; a conversion is then a short
+// search in that year's table.
+class TimeZoneTable {
+public:
+    explicit TimeZoneTable(std::unique_ptr<TimeZoneProvider> zoneProvider) : provider(std::move(zoneProvider)) {}
+
+    int offsetMinutesAt(long long utcSeconds) {
+        long long days = utcSeconds >= 0 ? utcSeconds / 86400 : (utcSeconds - 86399) / 86400;
+        const std::vector<ZoneTransition>& transitions = transitionsForYear(yearFromDays(days));
+
+        auto it = std::upper_bound(transitions.begin(), transitions.end(), utcSeconds,
+                                   [](long long t, const ZoneTransition& z) { return t < z.utcSeconds; });
+        return it == transitions.begin() ? transitions.front().offsetMinutes : (it - 1)->offsetMinutes;
+    }
+
+    // Local hour (0-24) of an event given as hours from 00:00 UTC on the given date
+    double utcToLocalHour(int year, int month, int day, double utcHour) {
+        long long utcSeconds = daysFromCivil(year, month, day) * 86400 + static_cast<long long>(std::floor(utcHour * 3600.0));
+        double localHour = utcHour + offsetMinutesAt(utcSeconds) / 60.0;
+        while (localHour < 0) localHour += 24.0;
+        while (localHour >= 24) localHour -= 24.0;
+        return localHour;
+    }
+
+    // Drop cached rules, e.g. after the system time zone changed
+    void clear() { years.clear(); }
+
+private:
+    std::unique_ptr<TimeZoneProvider> provider;
+    std::map<int, std::vector<ZoneTransition>> years;
+
+    const std::vector<ZoneTransition>& transitionsForYear(int year) {
+        auto it = years.find(year);
+        if (it == years.end()) {
+            it = years.emplace(year, provider->rulesForYear(year).transitionsForYear(year)).first;
+        }
+        return it->second;
+    }
+};
+
+// Rolling window of solar days indexed by day number: days[i] holds day
+// firstDay + i, and a slot with no fetch_date is missing. Refreshes shift
+// the window forward and only fill the slots that are missing or stale.
+struct SolarCache {
+    static constexpr int kMaxDays = 366;
+
+    long long firstDay = 0;
+    std::vector<SolarTimes> days;
+    std::string last_updated;
+
+    // Slot for a day inside the window, filled or not
+    SolarTimes* slot(long long day) {
+        if (day < firstDay || day >= firstDay + static_cast<long long>(days.size())) return nullptr;
+        return &days[static_cast<size_t>(day - firstDay)];
+    }
+
+    // Cached entry for a day, or nullptr if it is outside the window or missing
+    SolarTimes* find(long long day) {
+        SolarTimes* entry = slot(day);
+        return entry && !entry->fetch_date.empty() ? entry : nullptr;
+    }
+
+    // Stores an entry, growing the window to cover its day
+    void put(long long day, const SolarTimes& entry) {
+        if (days.empty()) {
+            firstDay = day;
+            days.resize(1);
+        } else if (day < firstDay) {
+            days.insert(days.begin(), static_cast<size_t>(firstDay - day), SolarTimes());
+            firstDay = day;
+        } else if (day >= firstDay + static_cast<long long>(days.size())) {
+            days.resize(static_cast<size_t>(day - firstDay + 1));
+        }
+        days[static_cast<size_t>(day - firstDay)] = entry;
+    }
+
+    // Moves the window to [newFirstDay, newFirstDay + length), keeping the entries still inside it
+    void shift(long long newFirstDay, int length) {
+        std::vector<SolarTimes> shifted(static_cast<size_t>(std::max(0, length)));
+        for (size_t i = 0; i < days.size(); i++) {
+            long long day = firstDay + static_cast<long long>(i);
+            if (!days[i].fetch_date.empty() && day >= newFirstDay && day < newFirstDay + length) {
+                shifted[static_cast<size_t>(day - newFirstDay)] = std::move(days[i]);
+            }
+        }
+        days.swap(shifted);
+        firstDay = newFirstDay;
+    }
+
+    // Marks every day missing, e.g. after the location changes
+    void invalidate() {
+        for (SolarTimes& day : days) day = SolarTimes();
+    }
+
+    static bool parseDay(const std::string& date, long long& day) {
+        int year, month, dayOfMonth;
+        if (sscanf(date.c_str(), "%d-%d-%d", &year, &month, &dayOfMonth) != 3
+            || month < 1 || month > 12 || dayOfMonth < 1 || dayOfMonth > 31) {
+            return false;
+        }
+        day = daysFromCivil(year, month, dayOfMonth);
+        return true;
+    }
+
+    static std::string formatDay(long long day) {
+        int year, month, dayOfMonth;
+        civilFromDays(day, year, month, dayOfMonth);
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d", year, month, dayOfMonth);
+        return buffer;
+    }
+};
+
+// Blend ratio in 16.16 fixed point; kFixedOne is 1.0
+typedef uint32_t Fixed16;
+constexpr Fixed16 kFixedOne = 1u << 16;
+
+// A NaN ratio (a zero-length keyframe segment gives 0/0) counts as 1.0, as
+// it did in the double blend's std::min/std::max clamp
+constexpr Fixed16 toFixed16(double ratio) {
+    return !(ratio < 1.0) ? kFixedOne : ratio <= 0.0 ? 0 : static_cast<Fixed16>(ratio * kFixedOne + 0.5);
+}
+
+// Integer blend, one multiply per channel. The blended value is never
+// negative, so the shift truncates the same way the old double blend did.
+// Branch-free, so loops over it vectorize.
+constexpr Color lerpColor(Color start, Color end, Fixed16 t) {
+    const int32_t w = static_cast<int32_t>(t);
+    return Color(((start.r << 16) + (end.r - start.r) * w) >> 16,
+                 ((start.g << 16) + (end.g - start.g) * w) >> 16,
+                 ((start.b << 16) + (end.b - start.b) * w) >> 16,
+                 ((start.a << 16) + (end.a - start.a) * w) >> 16);
+}
+
+constexpr Color interpolateColor(Color start, Color end, double ratio) {
+    return lerpColor(start, end, toFixed16(ratio));
+}
+
+static_assert(lerpColor(Color(0, 0, 0), Color(255, 255, 255), 0) == Color(0, 0, 0), "t = 0 gives start");
+static_assert(lerpColor(Color(0, 0, 0), Color(255, 255, 255), kFixedOne) == Color(255, 255, 255), "t = 1 gives end");
+static_assert(lerpColor(Color(10, 200, 0), Color(20, 100, 255), kFixedOne / 2) == Color(15, 150, 127), "midpoint truncates");
+static_assert(interpolateColor(Color(8, 8, 25), Color(10, 10, 25), 2.0) == Color(10, 10, 25), "ratio is clamped");
+static_assert(interpolateColor(Color(8, 8, 25), Color(10, 10, 25), std::numeric_limits<double>::quiet_NaN()) == Color(10, 10, 25),
+              "a NaN ratio gives end");
+
+inline std::string formatHour(double hour) {
+    int h = static_cast<int>(hour);
+    int m = static_cast<int>((hour - h) * 60);
+
+    std::string ampm = "AM";
+    if (h == 0) h = 12;
+    else if (h == 12) ampm = "PM";
+    else if (h > 12) { h -= 12; ampm = "PM"; }
+
+    std::stringstream ss;
+    ss << h << ":" << std::setfill('0') << std::setw(2) << m << " " << ampm;
+    return ss.str();
+}
+
+// Field helpers for the theme file and site CSVs: strips spaces and tabs
+// from both ends, and reads a whole field as a finite number
+inline std::string trim(const std::string& text) {
+    size_t first = text.find_first_not_of(" \t");
+    if (first == std::string::npos) return "";
+    return text.substr(first, text.find_last_not_of(" \t") - first + 1);
+}
+
+inline bool parseNumber(const std::string& text, double& value) {
+    if (text.empty()) return false;
+    char* end = nullptr;
+    value = strtod(text.c_str(), &end);
+    return end == text.c_str() + text.size() && std::isfinite(value);
+}
+
+struct DitherTable {
+    int cells[8][8];
+};
+
+// 8x8 Bayer matrix for ordered dithering: the bits of (x ^ y) and y
+// interleaved, most significant first
+constexpr DitherTable makeBayerMatrix() {
+    DitherTable table = {};
+    for (int y = 0; y < 8; y++) {
+        for (int x = 0; x < 8; x++) {
+            int value = 0;
+            for (int bit = 0; bit < 3; bit++) {
+                value |= (((x ^ y) >> bit) & 1) << (5 - 2 * bit);
+                value |= ((y >> bit) & 1) << (4 - 2 * bit);
+            }
+            table.cells[y][x] = value;
+        }
+    }
+    return table;
+}
+
+// Dither thresholds in 1/128 steps: Bayer value / 64 - 0.5, from -64 to 62
+constexpr DitherTable makeBayerThresholds(const DitherTable& matrix) {
+    DitherTable table = {};
+    for (int y = 0; y < 8; y++) {
+        for (int x = 0; x < 8; x++) {
+            table.cells[y][x] = 2 * matrix.cells[y][x] - 64;
+        }
+    }
+    return table;
+}
+
+constexpr bool isPermutationOf64(const DitherTable& table) {
+    bool seen[64] = {};
+    for (int y = 0; y < 8; y++) {
+        for (int x = 0; x < 8; x++) {
+            int value = table.cells[y][x];
+            if (value < 0 || value >= 64 || seen[value]) return false;
+            seen[value] = true;
+        }
+    }
+    return true;
+}
+
+static constexpr DitherTable kBayerMatrix = makeBayerMatrix();
+static constexpr DitherTable kBayerThresholds = makeBayerThresholds(kBayerMatrix);
+
+static_assert(isPermutationOf64(kBayerMatrix), "Bayer matrix holds each of 0-63 once");
+static_assert(kBayerMatrix.cells[0][1] == 32 && kBayerMatrix.cells[1][0] == 48
+              && kBayerMatrix.cells[3][4] == 62 && kBayerMatrix.cells[7][7] == 21,
+              "Bayer matrix matches the classic layout");
+static_assert(kBayerThresholds.cells[0][0] == -64 && kBayerThresholds.cells[3][4] == 60,
+              "thresholds are centred on zero");
+
+// Tileable threshold map for ordered dithering. A cell of rank k out of n
+// has threshold k / n - 0.5, stored as the integer 2k - n so that a dither
+// offset is threshold * difference / 4n. n is a power of two, so that
+// division is a shift.
+struct DitherPattern {
+    int width = 0, height = 0;
+    int divisorShift = 0; // log2(4n)
+    std::vector<int16_t> thresholds; // row-major, width * height
+
+    static const DitherPattern& bayer() {
+        static const DitherPattern pattern = makeBayer();
+        return pattern;
+    }
+
+    // Generated on first use, which takes a few tens of milliseconds
+    static const DitherPattern& blueNoise() {
+        static const DitherPattern pattern = makeBlueNoise(64);
+        return pattern;
+    }
+
+    static DitherPattern fromRanks(int width, int height, const std::vector<int>& ranks) {
+        DitherPattern pattern;
+        pattern.width = width;
+        pattern.height = height;
+        pattern.divisorShift = 2;
+        while ((1 << pattern.divisorShift) < 4 * width * height) pattern.divisorShift++;
+        for (int rank : ranks) pattern.thresholds.push_back(static_cast<int16_t>(2 * rank - width * height));
+        return pattern;
+    }
+
+private:
+    static DitherPattern makeBayer() {
+        DitherPattern pattern;
+        pattern.width = 8;
+        pattern.height = 8;
+        pattern.divisorShift = 8;
+        for (int y = 0; y < 8; y++) {
+            for (int x = 0; x < 8; x++) pattern.thresholds.push_back(static_cast<int16_t>(kBayerThresholds.cells[y][x]));
+        }
+        return pattern;
+    }
+
+    // Ulichney's void-and-cluster method on a torus, so the tile repeats
+    // without seams. Energy is a Gaussian-weighted count of set cells.
+    static DitherPattern makeBlueNoise(int size) {
+        const int cellCount = size * size;
+        const double sigma = 1.5;
+
+        std::vector<double> kernel(cellCount);
+        for (int dy = 0; dy < size; dy++) {
+            for (int dx = 0; dx < size; dx++) {
+                int wrapX = std::min(dx, size - dx), wrapY = std::min(dy, size - dy);
+                kernel[dy * size + dx] = std::exp(-(wrapX * wrapX + wrapY * wrapY) / (2 * sigma * sigma));
+            }
+        }
+
+        std::vector<uint8_t> set(cellCount, 0);
+        std::vector<double> energy(cellCount, 0.0);
+        auto toggle = [&](int cell, bool on) {
+            set[cell] = on ? 1 : 0;
+            double sign = on ? 1.0 : -1.0;
+            int cx = cell % size, cy = cell / size;
+            for (int y = 0; y < size; y++) {
+                const double* kernelRow = &kernel[((y - cy + size) % size) * size];
+                double* energyRow = &energy[y * size];
+                for (int x = 0; x < size; x++) {
+                    int dx = x - cx;
+                    energyRow[x] += sign * kernelRow[dx < 0 ? dx + size : dx];
+                }
+            }
+        };
+        // Tightest cluster: the set cell with the most energy. Largest void:
+        // the empty cell with the least.
+        auto tightestCluster = [&]() {
+            int best = -1;
+            for (int i = 0; i < cellCount; i++) {
+                if (set[i] && (best < 0 || energy[i] > energy[best])) best = i;
+            }
+            return best;
+        };
+        auto largestVoid = [&]() {
+            int best = -1;
+            for (int i = 0; i < cellCount; i++) {
+                if (!set[i] && (best < 0 || energy[i] < energy[best])) best = i;
+            }
+            return best;
+        };
+
+        // Seed a tenth of the cells at random (fixed seed, so every run gets
+        // the same tile), then move clusters into voids until that is a no-op
+        std::mt19937 random(1);
+        const int seedCount = cellCount / 10;
+        for (int placed = 0; placed < seedCount; ) {
+            int cell = static_cast<int>(random() % cellCount);
+            if (!set[cell]) {
+                toggle(cell, true);
+                placed++;
+            }
+        }
+        for (int i = 0; i < cellCount; i++) {
+            int cluster = tightestCluster();
+            toggle(cluster, false);
+            int emptiest = largestVoid();
+            toggle(emptiest, true);
+            if (emptiest == cluster) break;
+        }
+
+        std::vector<int> ranks(cellCount, 0);
+        const std::vector<uint8_t> seedSet = set;
+        const std::vector<double> seedEnergy = energy;
+
+        // Rank the seed cells by removing clusters, highest rank first
+        for (int rank = seedCount - 1; rank >= 0; rank--) {
+            int cluster = tightestCluster();
+            toggle(cluster, false);
+            ranks[cluster] = rank;
+        }
+
+        // Rank the rest by filling voids. The kernel sums to the same value
+        // at every cell, so the largest void among set cells is also the
+        // tightest cluster among empty ones and one rule covers both halves.
+        set = seedSet;
+        energy = seedEnergy;
+        for (int rank = seedCount; rank < cellCount; rank++) {
+            int emptiest = largestVoid();
+            toggle(emptiest, true);
+            ranks[emptiest] = rank;
+        }
+
+        return fromRanks(size, size, ranks);
+    }
+};
+
+// Largest dither tile the rasterizer holds
+static constexpr int kMaxDitherSize = 64;
+
+// Pattern kernels: one row's tile-wide pattern is the row's base color plus
+// each cell's offset, clamped to 0-255. Offsets are within +/-64, so 16-bit
+// adds cannot overflow and the saturating pack is the clamp. Byte counts
+// are multiples of 32.
+typedef void (*PatternFn)(uint8_t* pattern, const int16_t* offsets, const int base[4], int bytes);
+
+static void buildPatternScalar(uint8_t* pattern, const int16_t* offsets, const int base[4], int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        pattern[i] = static_cast<uint8_t>(std::max(0, std::min(255, base[i & 3] + offsets[i])));
+    }
+}
+
+#ifdef TIMEWALLPAPER_X86
+__attribute__((target("sse2")))
+static void buildPatternSSE2(uint8_t* pattern, const int16_t* offsets, const int base[4], int bytes) {
+    __m128i baseWords = _mm_setr_epi16(base[0], base[1], base[2], base[3], base[0], base[1], base[2], base[3]);
+    for (int i = 0; i < bytes; i += 16) {
+        __m128i lo = _mm_add_epi16(baseWords, _mm_loadu_si128(reinterpret_cast<const __m128i*>(offsets + i)));
+        __m128i hi = _mm_add_epi16(baseWords, _mm_loadu_si128(reinterpret_cast<const __m128i*>(offsets + i + 8)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pattern + i), _mm_packus_epi16(lo, hi));
+    }
+}
+#endif
+
+static PatternFn selectPatternBuilder() {
+#ifdef TIMEWALLPAPER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) return buildPatternSSE2;
+#endif
+    return buildPatternScalar;
+}
+
+// Row fill kernels: every gradient row is one dither-tile-wide RGBA pattern
+// repeated across the width, so the per-pixel work reduces to wide stores.
+// Pattern widths are multiples of 8 pixels.
+typedef void (*RowFillFn)(uint8_t* dst, const uint8_t* pattern, int patternWidth, int width);
+
+static void fillRowScalar(uint8_t* dst, const uint8_t* pattern, int patternWidth, int width) {
+    int x = 0;
+    for (; x + patternWidth <= width; x += patternWidth) {
+        std::memcpy(dst + x * 4, pattern, patternWidth * 4);
+    }
+    std::memcpy(dst + x * 4, pattern, (width - x) * 4);
+}
+
+#ifdef TIMEWALLPAPER_X86
+static void fillRowSSE2(uint8_t* dst, const uint8_t* pattern, int patternWidth, int width) {
+    int x = 0;
+    if (patternWidth == 8) {
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pattern));
+        __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pattern + 16));
+        for (; x + 8 <= width; x += 8) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4), lo);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4 + 16), hi);
+        }
+    } else {
+        for (; x + patternWidth <= width; x += patternWidth) {
+            for (int p = 0; p < patternWidth; p += 4) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + (x + p) * 4),
+                                 _mm_loadu_si128(reinterpret_cast<const __m128i*>(pattern + p * 4)));
+            }
+        }
+    }
+    std::memcpy(dst + x * 4, pattern, (width - x) * 4);
+}
+
+__attribute__((target("avx2")))
+static void fillRowAVX2(uint8_t* dst, const uint8_t* pattern, int patternWidth, int width) {
+    int x = 0;
+    if (patternWidth == 8) {
+        __m256i row = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pattern));
+        for (; x + 16 <= width; x += 16) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 4), row);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 4 + 32), row);
+        }
+        for (; x + 8 <= width; x += 8) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 4), row);
+        }
+    } else {
+        for (; x + patternWidth <= width; x += patternWidth) {
+            for (int p = 0; p < patternWidth; p += 8) {
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + (x + p) * 4),
+                                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pattern + p * 4)));
+            }
+        }
+    }
+    std::memcpy(dst + x * 4, pattern, (width - x) * 4);
+}
+#endif
+
+static RowFillFn selectRowFill() {
+#ifdef TIMEWALLPAPER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return fillRowAVX2;
+    if (__builtin_cpu_supports("sse2")) return fillRowSSE2;
+#endif
+    return fillRowScalar;
+}
+
+// Rasterizes the dithered vertical gradient into a tightly packed RGBA buffer.
+// The dither offset only depends on the tile cell and the frame's color
+// difference, so it is computed once per frame; each row then blends its
+// base color in fixed point and builds its tile-wide pattern with integer
+// adds and clamps.
+class GradientRasterizer {
+public:
+    GradientRasterizer(Color bottom, Color top, const DitherPattern& dither = DitherPattern::bayer())
+        : bottomColor(bottom), topColor(top), patternWidth(dither.width), patternHeight(dither.height) {
+        // Apply dithering: add threshold scaled by color difference
+        int diffR = abs(top.r - bottom.r);
+        int diffG = abs(top.g - bottom.g);
+        int diffB = abs(top.b - bottom.b);
+
+        // Half the color difference scaled by the threshold, truncated toward zero.
+        // Alpha gets no offset.
+        const int shift = dither.divisorShift;
+        for (int cell = 0; cell < patternWidth * patternHeight; cell++) {
+            int threshold = dither.thresholds[cell];
+            offsets[cell * 4 + 0] = divideTruncating(threshold * diffR, shift);
+            offsets[cell * 4 + 1] = divideTruncating(threshold * diffG, shift);
+            offsets[cell * 4 + 2] = divideTruncating(threshold * diffB, shift);
+            offsets[cell * 4 + 3] = 0;
+        }
+    }
+
+    int getPatternWidth() const { return patternWidth; }
+
+    void rasterizeRows(uint8_t* pixels, int width, int height, int rowBegin, int rowEnd) const {
+        static const RowFillFn fillRow = selectRowFill();
+        static const PatternFn buildPattern = selectPatternBuilder();
+
+        alignas(32) uint8_t pattern[kMaxDitherSize * 4];
+        const int patternBytes = patternWidth * 4;
+        for (int y = rowBegin; y < rowEnd; y++) {
+            // Interpolate base color at this row (row 0 is the bottom color)
+            Fixed16 ratio = static_cast<Fixed16>((static_cast<uint64_t>(y) * kFixedOne + height / 2) / height);
+            Color baseColor = lerpColor(bottomColor, topColor, ratio);
+            const int base[4] = { baseColor.r, baseColor.g, baseColor.b, 255 };
+
+            buildPattern(pattern, offsets + (y % patternHeight) * patternBytes, base, patternBytes);
+            fillRow(pixels + static_cast<size_t>(y) * width * 4, pattern, patternWidth, width);
+        }
+    }
+
+    void rasterize(uint8_t* pixels, int width, int height) const {
+        rasterizeRows(pixels, width, height, 0, height);
+    }
+
+private:
+    Color bottomColor;
+    Color topColor;
+    int patternWidth, patternHeight;
+    alignas(16) int16_t offsets[kMaxDitherSize * kMaxDitherSize * 4];
+
+    // value / 2^shift, rounded toward zero like integer division
+    static int16_t divideTruncating(int value, int shift) {
+        return static_cast<int16_t>((value < 0 ? value + (1 << shift) - 1 : value) >> shift);
+    }
+};
+
+// Small work-stealing pool used to split raster work into row bands.
+// Each thread owns a queue of task indices and pops from its front; when
+// it runs dry it steals from the back of the other queues. The calling
+// thread takes part in every job through the last queue.
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(int threadCount) {
+        int workerCount = std::max(0, threadCount - 1);
+        for (int i = 0; i <= workerCount; i++) {
+            queues.push_back(std::make_unique<TaskQueue>());
+        }
+        for (int i = 0; i < workerCount; i++) {
+            workers.emplace_back(&WorkStealingPool::workerLoop, this, static_cast<size_t>(i));
+        }
+    }
+
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            stopping = true;
+        }
+        wakeWorkers.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    int getThreadCount() const { return static_cast<int>(queues.size()); }
+
+    // Runs task(0..taskCount-1) across the pool and blocks until all are done
+    void run(size_t taskCount, const std::function<void(size_t)>& task) {
+        if (taskCount == 0) return;
+
+        {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            currentTask = &task;
+            remaining = taskCount;
+
+            // Hand each queue a contiguous slice so neighbouring bands stay on one core
+            size_t queueCount = queues.size();
+            for (size_t q = 0; q < queueCount; q++) {
+                std::lock_guard<std::mutex> queueLock(queues[q]->mutex);
+                for (size_t i = taskCount * q / queueCount; i < taskCount * (q + 1) / queueCount; i++) {
+                    queues[q]->tasks.push_back(i);
+                }
+            }
+            generation++;
+        }
+        wakeWorkers.notify_all();
+
+        drain(queues.size() - 1);
+
+        std::unique_lock<std::mutex> lock(stateMutex);
+        jobDone.wait(lock, [this] { return remaining == 0; });
+    }
+
+private:
+    struct TaskQueue {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+
+    std::vector<std::unique_ptr<TaskQueue>> queues;
+    std::vector<std::thread> workers;
+    std::mutex stateMutex;
+    std::condition_variable wakeWorkers;
+    std::condition_variable jobDone;
+    const std::function<void(size_t)>* currentTask = nullptr;
+    std::atomic<size_t> remaining{0};
+    unsigned long generation = 0;
+    bool stopping = false;
+
+    bool takeTask(size_t self, size_t& index) {
+        {
+            TaskQueue& own = *queues[self];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                index = own.tasks.front();
+                own.tasks.pop_front();
+                return true;
+            }
+        }
+
+        for (size_t offset = 1; offset < queues.size(); offset++) {
+            TaskQueue& victim = *queues[(self + offset) % queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                index = victim.tasks.back();
+                victim.tasks.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void drain(size_t self) {
+        size_t index;
+        while (takeTask(self, index)) {
+            (*currentTask)(index);
+            if (remaining.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(stateMutex);
+                jobDone.notify_all();
+            }
+        }
+    }
+
+    void workerLoop(size_t self) {
+        unsigned long seenGeneration = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(stateMutex);
+                wakeWorkers.wait(lock, [&] { return stopping || generation != seenGeneration; });
+                if (stopping) return;
+                seenGeneration = generation;
+            }
+            drain(self);
+        }
+    }
+};
+
+enum Period {
+    PERIOD_DEEP_NIGHT, PERIOD_PRE_DAWN, PERIOD_EARLY_DAWN, PERIOD_DAWN, PERIOD_SUNRISE,
+    PERIOD_EARLY_MORNING, PERIOD_MORNING, PERIOD_LATE_MORNING, PERIOD_NOON, PERIOD_EARLY_AFTERNOON,
+    PERIOD_LATE_AFTERNOON, PERIOD_PRE_SUNSET, PERIOD_SUNSET, PERIOD_POST_SUNSET, PERIOD_CIVIL_TWILIGHT,
+    PERIOD_EVENING, PERIOD_LATE_EVENING, PERIOD_NIGHT, PERIOD_COUNT
+};
+
+static const char* const kPeriodNames[PERIOD_COUNT] = {
+    "Deep Night", "Pre-Dawn", "Early Dawn", "Dawn", "Sunrise",
+    "Early Morning", "Morning", "Late Morning", "Noon", "Early Afternoon",
+    "Late Afternoon", "Pre-Sunset", "Sunset", "Post-Sunset", "Civil Twilight",
+    "Evening", "Late Evening", "Night"
+};
+
+// Index into a theme's interned period names. The built-in names are always
+// interned first, so their ids are the Period values.
+typedef uint8_t PeriodId;
+
+// Color stops placed relative to solar events. A theme file has one stop
+// per line, in the same key=value form as config.ini:
+//
+//   stop=<anchor>[+|-hours], R, G, B, <period name>[, not_before=<hour>]
+//
+// where anchor is midnight, sunrise, solar_noon, sunset,
+// civil_twilight_begin or civil_twilight_end. not_before keeps the stop from
+// landing earlier than a fixed hour on short days.
+class ColorTheme {
+public:
+    enum Anchor {
+        ANCHOR_MIDNIGHT, ANCHOR_SUNRISE, ANCHOR_SOLAR_NOON, ANCHOR_SUNSET,
+        ANCHOR_CIVIL_TWILIGHT_BEGIN, ANCHOR_CIVIL_TWILIGHT_END
+    };
+
+    struct Stop {
+        Anchor anchor;
+        double offsetHours;
+        double notBeforeHour; // negative when unset
+        Color color;
+        PeriodId period;
+    };
+
+    // Stops of the built-in theme, fixed at compile time
+    static constexpr Stop kBuiltInStops[] = {
+        // Night and early morning
+        { ANCHOR_MIDNIGHT, 0.0, -1.0, Color(8, 8, 25), PERIOD_DEEP_NIGHT },
+        { ANCHOR_SUNRISE, -3.0, 1.0, Color(10, 10, 25), PERIOD_PRE_DAWN },
+        { ANCHOR_SUNRISE, -1.5, 2.0, Color(15, 15, 45), PERIOD_EARLY_DAWN },
+        { ANCHOR_SUNRISE, -1.0, 3.0, Color(25, 15, 65), PERIOD_EARLY_DAWN },
+        { ANCHOR_SUNRISE, -0.5, 4.0, Color(50, 30, 65), PERIOD_DAWN },
+        { ANCHOR_SUNRISE, -0.25, 5.0, Color(120, 80, 110), PERIOD_DAWN },
+
+        // Sunrise and morning
+        { ANCHOR_SUNRISE, 0.0, 6.0, Color(160, 120, 130), PERIOD_SUNRISE },
+        { ANCHOR_SUNRISE, 0.25, 7.0, Color(190, 150, 140), PERIOD_SUNRISE },
+        { ANCHOR_SUNRISE, 0.5, 8.0, Color(210, 180, 160), PERIOD_EARLY_MORNING },
+        { ANCHOR_SUNRISE, 1.0, 9.0, Color(220, 200, 180), PERIOD_EARLY_MORNING },
+        { ANCHOR_SUNRISE, 2.0, 10.0, Color(230, 240, 220), PERIOD_MORNING },
+
+        // Day time
+        { ANCHOR_SOLAR_NOON, -1.5, 11.0, Color(210, 230, 200), PERIOD_LATE_MORNING },
+        { ANCHOR_SOLAR_NOON, -1.0, 11.5, Color(190, 220, 190), PERIOD_LATE_MORNING },
+        { ANCHOR_SOLAR_NOON, 0.0, 12.0, Color(170, 210, 230), PERIOD_NOON },
+        { ANCHOR_SOLAR_NOON, 1.0, 13.0, Color(170, 210, 230), PERIOD_EARLY_AFTERNOON },
+        { ANCHOR_SOLAR_NOON, 1.5, 14.0, Color(170, 210, 230), PERIOD_EARLY_AFTERNOON },
+
+        // Afternoon to sunset
+        { ANCHOR_SUNSET, -2.0, -1.0, Color(170, 210, 230), PERIOD_LATE_AFTERNOON },
+        { ANCHOR_SUNSET, -1.5, -1.0, Color(170, 210, 230), PERIOD_LATE_AFTERNOON },
+        { ANCHOR_SUNSET, -1.0, -1.0, Color(175, 200, 225), PERIOD_PRE_SUNSET },
+        { ANCHOR_SUNSET, -0.5, -1.0, Color(180, 195, 220), PERIOD_PRE_SUNSET },
+        { ANCHOR_SUNSET, 0.0, -1.0, Color(230, 140, 70), PERIOD_SUNSET },
+
+        // Post-sunset to evening
+        { ANCHOR_SUNSET, 0.1, -1.0, Color(210, 120, 70), PERIOD_SUNSET },
+        { ANCHOR_SUNSET, 0.2, -1.0, Color(170, 100, 75), PERIOD_POST_SUNSET },
+        { ANCHOR_SUNSET, 0.3, -1.0, Color(140, 90, 80), PERIOD_POST_SUNSET },
+        { ANCHOR_SUNSET, 0.4, -1.0, Color(110, 80, 85), PERIOD_CIVIL_TWILIGHT },
+        { ANCHOR_SUNSET, 0.5, -1.0, Color(95, 75, 95), PERIOD_CIVIL_TWILIGHT },
+        { ANCHOR_SUNSET, 0.6, -1.0, Color(80, 65, 85), PERIOD_CIVIL_TWILIGHT },
+
+        // Evening progression
+        { ANCHOR_SUNSET, 0.7, -1.0, Color(65, 60, 75), PERIOD_EVENING },
+        { ANCHOR_SUNSET, 0.95, -1.0, Color(65, 55, 70), PERIOD_EVENING },
+        { ANCHOR_SUNSET, 1.2, -1.0, Color(60, 50, 70), PERIOD_EVENING },
+        { ANCHOR_SUNSET, 1.45, -1.0, Color(50, 45, 65), PERIOD_EVENING },
+        { ANCHOR_SUNSET, 1.7, -1.0, Color(45, 40, 65), PERIOD_EVENING },
+        { ANCHOR_SUNSET, 1.95, -1.0, Color(40, 35, 60), PERIOD_EVENING },
+        { ANCHOR_SUNSET, 2.2, -1.0, Color(35, 30, 55), PERIOD_EVENING },
+        { ANCHOR_SUNSET, 2.45, -1.0, Color(32, 28, 52), PERIOD_LATE_EVENING },
+        { ANCHOR_SUNSET, 2.95, -1.0, Color(32, 22, 48), PERIOD_LATE_EVENING },
+        { ANCHOR_SUNSET, 3.45, -1.0, Color(22, 17, 42), PERIOD_LATE_EVENING },
+        { ANCHOR_SUNSET, 3.95, -1.0, Color(15, 12, 35), PERIOD_NIGHT },
+        { ANCHOR_MIDNIGHT, 23.99, -1.0, Color(8, 8, 20), PERIOD_NIGHT }
+    };
+
+    ColorTheme() {
+        for (const char* name : kPeriodNames) periodNames.push_back(name);
+    }
+
+    // The original hard-coded schedule
+    static std::shared_ptr<const ColorTheme> builtIn() {
+        static const std::shared_ptr<const ColorTheme> theme = std::make_shared<const ColorTheme>(makeBuiltIn());
+        return theme;
+    }
+
+    static bool load(const std::string& path, ColorTheme& theme, std::string& error) {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            error = "cannot open " + path;
+            return false;
+        }
+        return theme.parse(file, error);
+    }
+
+    bool parse(std::istream& in, std::string& error) {
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(in, line)) {
+            lineNumber++;
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty() || line[0] == '#') continue;
+
+            size_t equalPos = line.find('=');
+            std::string key = trim(line.substr(0, equalPos));
+            if (equalPos == std::string::npos || key != "stop") {
+                error = "line " + std::to_string(lineNumber) + ": expected stop=...";
+                return false;
+            }
+            if (!parseStop(line.substr(equalPos + 1), error)) {
+                error = "line " + std::to_string(lineNumber) + ": " + error;
+                return false;
+            }
+        }
+
+        if (stops.size() < 2) {
+            error = "a theme needs at least two stops";
+            return false;
+        }
+        return true;
+    }
+
+    void addStop(Anchor anchor, double offsetHours, double notBeforeHour, Color color, PeriodId period) {
+        stops.push_back({ anchor, offsetHours, notBeforeHour, color, period });
+    }
+
+    // Id for a period name, adding it if new; false once all ids are used
+    bool internPeriod(const std::string& name, PeriodId& id) {
+        for (size_t i = 0; i < periodNames.size(); i++) {
+            if (periodNames[i] == name) {
+                id = static_cast<PeriodId>(i);
+                return true;
+            }
+        }
+        if (periodNames.size() > 255) return false;
+        periodNames.push_back(name);
+        id = static_cast<PeriodId>(periodNames.size() - 1);
+        return true;
+    }
+
+    const char* periodName(PeriodId id) const {
+        return id < periodNames.size() ? periodNames[id].c_str() : "Unknown";
+    }
+
+    size_t getPeriodCount() const { return periodNames.size(); }
+    const std::vector<Stop>& getStops() const { return stops; }
+
+    static double anchorHour(Anchor anchor, const SolarTimes& solarTimes) {
+        switch (anchor) {
+            case ANCHOR_SUNRISE: return solarTimes.sunrise_hour;
+            case ANCHOR_SOLAR_NOON: return solarTimes.solar_noon_hour;
+            case ANCHOR_SUNSET: return solarTimes.sunset_hour;
+            case ANCHOR_CIVIL_TWILIGHT_BEGIN: return solarTimes.civil_twilight_begin;
+            case ANCHOR_CIVIL_TWILIGHT_END: return solarTimes.civil_twilight_end;
+            default: return 0.0;
+        }
+    }
+
+private:
+    std::vector<Stop> stops;
+    std::vector<std::string> periodNames;
+
+    bool parseStop(const std::string& spec, std::string& error) {
+        std::vector<std::string> fields;
+        std::stringstream ss(spec);
+        std::string field;
+        while (std::getline(ss, field, ',')) fields.push_back(trim(field));
+        if (fields.size() != 5 && fields.size() != 6) {
+            error = "expected anchor, R, G, B, period[, not_before=hour]";
+            return false;
+        }
+
+        // Anchor name with an optional signed offset
+        static const char* const anchorNames[] = {
+            "midnight", "sunrise", "solar_noon", "sunset", "civil_twilight_begin", "civil_twilight_end"
+        };
+        const std::string& position = fields[0];
+        size_t signPos = position.find_first_of("+-");
+        std::string anchorName = trim(position.substr(0, signPos));
+        double offset = 0.0;
+        if (signPos != std::string::npos && !parseNumber(trim(position.substr(signPos)), offset)) {
+            error = "bad offset in '" + position + "'";
+            return false;
+        }
+        int anchor = -1;
+        for (int i = 0; i < 6; i++) {
+            if (anchorName == anchorNames[i]) anchor = i;
+        }
+        if (anchor < 0) {
+            error = "unknown anchor '" + anchorName + "'";
+            return false;
+        }
+
+        int rgb[3];
+        for (int c = 0; c < 3; c++) {
+            double component;
+            if (!parseNumber(fields[1 + c], component) || component < 0 || component > 255
+                || component != std::floor(component)) {
+                error = "color components must be whole numbers from 0 to 255";
+                return false;
+            }
+            rgb[c] = static_cast<int>(component);
+        }
+
+        PeriodId period;
+        if (fields[4].empty() || !internPeriod(fields[4], period)) {
+            error = fields[4].empty() ? "missing period name" : "too many period names";
+            return false;
+        }
+
+        double notBefore = -1.0;
+        if (fields.size() == 6) {
+            const std::string prefix = "not_before=";
+            if (fields[5].compare(0, prefix.size(), prefix) != 0
+                || !parseNumber(trim(fields[5].substr(prefix.size())), notBefore)) {
+                error = "expected not_before=<hour>";
+                return false;
+            }
+        }
+
+        addStop(static_cast<Anchor>(anchor), offset, notBefore, Color(rgb[0], rgb[1], rgb[2]), period);
+        return true;
+    }
+
+    static ColorTheme makeBuiltIn() {
+        ColorTheme theme;
+        theme.stops.assign(std::begin(kBuiltInStops), std::end(kBuiltInStops));
+        return theme;
+    }
+};
+
+// Stops sharing an anchor must be listed in time order
+constexpr bool builtInStopsOrdered() {
+    const size_t count = sizeof(ColorTheme::kBuiltInStops) / sizeof(ColorTheme::kBuiltInStops[0]);
+    for (size_t i = 1; i < count; i++) {
+        const ColorTheme::Stop& previous = ColorTheme::kBuiltInStops[i - 1];
+        const ColorTheme::Stop& stop = ColorTheme::kBuiltInStops[i];
+        if (stop.anchor == previous.anchor && stop.offsetHours <= previous.offsetHours) return false;
+    }
+    return true;
+}
+
+static_assert(sizeof(ColorTheme::kBuiltInStops) / sizeof(ColorTheme::kBuiltInStops[0]) == 39,
+              "built-in theme has 39 stops");
+static_assert(ColorTheme::kBuiltInStops[0].color == Color(8, 8, 25)
+              && ColorTheme::kBuiltInStops[20].color == Color(230, 140, 70)
+              && ColorTheme::kBuiltInStops[38].color == Color(8, 8, 20),
+              "built-in theme keeps its midnight, sunset and night colors");
+static_assert(builtInStopsOrdered(), "built-in stops are in time order");
+
+// Color schedule for one day, compiled from a theme and that day's solar
+// times. Keyframes are kept as parallel sorted arrays and sampled into a
+// quarter-second lookup table, so per-frame lookups are a single index and
+// never allocate.
+class ColorSchedule {
+public:
+    static constexpr int kSamplesPerSecond = 4;
+    static constexpr int kSamplesPerDay = 24 * 3600 * kSamplesPerSecond;
+
+    ColorSchedule() : theme(ColorTheme::builtIn()) {}
+
+    // Takes effect on the next build()
+    void setTheme(std::shared_ptr<const ColorTheme> newTheme) {
+        theme = std::move(newTheme);
+        lut.clear();
+    }
+
+    const ColorTheme& getTheme() const { return *theme; }
+    const char* periodName(PeriodId id) const { return theme->periodName(id); }
+
+    bool isBuiltFor(const SolarTimes& solarTimes) const {
+        return !lut.empty()
+            && builtSunrise == solarTimes.sunrise_hour
+            && builtSunset == solarTimes.sunset_hour
+            && builtSolarNoon == solarTimes.solar_noon_hour
+            && builtTwilightBegin == solarTimes.civil_twilight_begin
+            && builtTwilightEnd == solarTimes.civil_twilight_end;
+    }
+
+    void build(const SolarTimes& solarTimes) {
+        builtSunrise = solarTimes.sunrise_hour;
+        builtSunset = solarTimes.sunset_hour;
+        builtSolarNoon = solarTimes.solar_noon_hour;
+        builtTwilightBegin = solarTimes.civil_twilight_begin;
+        builtTwilightEnd = solarTimes.civil_twilight_end;
+
+        buildKeyframes(solarTimes);
+
+        lut.resize(kSamplesPerDay);
+        sweep(kSamplesPerSecond, lut.size(), lut.data());
+    }
+
+    struct Sample {
+        uint8_t r, g, b, period;
+    };
+
+    // Samples 0..count-1 at samplesPerSecond from midnight, in one pass that
+    // walks the keyframes forward. Gives exactly what evaluate() would.
+    void sweep(int samplesPerSecond, size_t count, Sample* out) const {
+        size_t segment = 0;
+        size_t last = keyHours.size() - 1;
+        for (size_t i = 0; i < count; i++) {
+            // Same hour arithmetic as the tm-based callers, so whole seconds match exactly
+            int second = static_cast<int>(i / samplesPerSecond);
+            double hour = (second / 3600) + (((second / 60) % 60) / 60.0) + ((second % 60) / 3600.0);
+            int fraction = static_cast<int>(i % samplesPerSecond);
+            if (fraction) hour += fraction / (3600.0 * samplesPerSecond);
+
+            while (segment < last && hour > keyHours[segment + 1]) segment++;
+
+            PeriodId period;
+            Color color;
+            if (segment < last && hour >= keyHours[segment]) {
+                period = keyPeriods[segment];
+                color = interpolateColor(keyColors[segment], keyColors[segment + 1],
+                                         (hour - keyHours[segment]) / (keyHours[segment + 1] - keyHours[segment]));
+            } else {
+                color = evaluate(hour, period); // wrap-around across midnight
+            }
+            out[i] = { static_cast<uint8_t>(color.r), static_cast<uint8_t>(color.g),
+                       static_cast<uint8_t>(color.b), period };
+        }
+    }
+
+    Color colorAtSecond(int secondOfDay, PeriodId* outPeriod = nullptr) const {
+        secondOfDay %= 24 * 3600;
+        if (secondOfDay < 0) secondOfDay += 24 * 3600;
+        return sample(secondOfDay * kSamplesPerSecond, outPeriod);
+    }
+
+    Color colorAtHour(double hour, PeriodId* outPeriod = nullptr) const {
+        long long index = std::llround(hour * 3600.0 * kSamplesPerSecond) % kSamplesPerDay;
+        if (index < 0) index += kSamplesPerDay;
+        return sample(static_cast<int>(index), outPeriod);
+    }
+
+    // Batch form of colorAtSecond for a span of times
+    void colorsAtSeconds(const int* seconds, size_t count, Color* outColors, PeriodId* outPeriods = nullptr) const {
+        for (size_t i = 0; i < count; i++) {
+            outColors[i] = colorAtSecond(seconds[i], outPeriods ? outPeriods + i : nullptr);
+        }
+    }
+
+    // Direct keyframe interpolation, used to fill the lookup table
+    Color evaluate(double hour, PeriodId& outPeriod) const {
+        // Normalize hour to 0-24 range
+        while (hour < 0) hour += 24.0;
+        while (hour >= 24) hour -= 24.0;
+
+        // The first keyframe pair that brackets the hour
+        size_t last = keyHours.size() - 1;
+        size_t segment = std::lower_bound(keyHours.begin() + 1, keyHours.end(), hour) - (keyHours.begin() + 1);
+        if (segment < last && hour >= keyHours[segment]) {
+            double progress = (hour - keyHours[segment]) / (keyHours[segment + 1] - keyHours[segment]);
+            outPeriod = keyPeriods[segment];
+            return interpolateColor(keyColors[segment], keyColors[segment + 1], progress);
+        }
+
+        // Handle wrap-around (from last point to first point)
+        double lastHour = keyHours.back();
+        double firstHour = keyHours.front() + 24;
+        if (hour < keyHours.front()) hour += 24.0; // themes without a stop at midnight
+
+        double progress = (hour - lastHour) / (firstHour - lastHour);
+        outPeriod = keyPeriods.back();
+        return interpolateColor(keyColors.back(), keyColors.front(), progress);
+    }
+
+    // First keyframe after the hour, wrapping to tomorrow's first
+    void nextKeyframe(double hour, double& outHour, Color& outColor, PeriodId& outPeriod) const {
+        size_t index = std::upper_bound(keyHours.begin(), keyHours.end(), hour) - keyHours.begin();
+        if (index == keyHours.size()) index = 0;
+        outHour = keyHours[index];
+        outColor = keyColors[index];
+        outPeriod = keyPeriods[index];
+    }
+
+    // Keyframes for the day, sorted by hour. build() samples these into the
+    // table; exporters sweep them directly without building one.
+    void buildKeyframes(const SolarTimes& solarTimes) {
+        struct Keyframe {
+            double hour;
+            Color color;
+            PeriodId period;
+        };
+
+        const std::vector<ColorTheme::Stop>& stops = theme->getStops();
+        std::vector<Keyframe> points;
+        points.reserve(stops.size());
+        for (const ColorTheme::Stop& stop : stops) {
+            double hour = ColorTheme::anchorHour(stop.anchor, solarTimes) + stop.offsetHours;
+            if (stop.notBeforeHour >= 0) hour = std::max(stop.notBeforeHour, hour);
+
+            // Fix times outside 0-24 range
+            while (hour < 0) hour += 24.0;
+            while (hour >= 24) hour -= 24.0;
+            points.push_back({ hour, stop.color, stop.period });
+        }
+
+        // Sort points by time
+        std::sort(points.begin(), points.end(),
+                  [](const Keyframe& a, const Keyframe& b) {
+                      return a.hour < b.hour;
+                  });
+
+        keyHours.resize(points.size());
+        keyColors.resize(points.size());
+        keyPeriods.resize(points.size());
+        for (size_t i = 0; i < points.size(); i++) {
+            keyHours[i] = points[i].hour;
+            keyColors[i] = points[i].color;
+            keyPeriods[i] = points[i].period;
+        }
+    }
+
+private:
+    std::shared_ptr<const ColorTheme> theme;
+
+    // Keyframes as parallel arrays sorted by hour
+    std::vector<double> keyHours;
+    std::vector<Color> keyColors;
+    std::vector<PeriodId> keyPeriods;
+
+    std::vector<Sample> lut;
+    double builtSunrise = 0.0;
+    double builtSunset = 0.0;
+    double builtSolarNoon = 0.0;
+    double builtTwilightBegin = 0.0;
+    double builtTwilightEnd = 0.0;
+
+    Color sample(int index, PeriodId* outPeriod) const {
+        const Sample& s = lut[index];
+        if (outPeriod) *outPeriod = s.period;
+        return Color(s.r, s.g, s.b);
+    }
+};
+
+// Source of wall-clock time. The main loop and scheduler read time through
+// this so they can be driven by a simulated clock.
+class TimeSource {
+public:
+    typedef std::chrono::system_clock::time_point TimePoint;
+
+    virtual ~TimeSource() {}
+    virtual TimePoint now() const = 0;
+
+    // Real time to wait until the given instant of this clock
+    virtual std::chrono::nanoseconds realDelayUntil(TimePoint deadline) const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now());
+    }
+};
+
+class SystemTimeSource : public TimeSource {
+public:
+    TimePoint now() const override { return std::chrono::system_clock::now(); }
+};
+
+// Simulated wall clock for --time-warp and --replay. With a positive factor
+// it runs that many times faster than real time from its start instant; with
+// factor 0 it only moves through advanceTo(), so the loop steps from one
+// deadline to the next without sleeping. Readable from any thread.
+class SimulatedTimeSource : public TimeSource {
+public:
+    SimulatedTimeSource(TimePoint simulatedStart, double warpFactor)
+        : start(simulatedStart), factor(warpFactor), realStart(std::chrono::steady_clock::now()) {}
+
+    TimePoint now() const override {
+        if (isStepped()) return start + std::chrono::duration_cast<TimePoint::duration>(std::chrono::nanoseconds(stepped.load()));
+        return start + std::chrono::duration_cast<TimePoint::duration>((std::chrono::steady_clock::now() - realStart) * factor);
+    }
+
+    std::chrono::nanoseconds realDelayUntil(TimePoint deadline) const override {
+        if (isStepped()) return std::chrono::nanoseconds(0);
+        return std::chrono::duration_cast<std::chrono::nanoseconds>((deadline - now()) / factor);
+    }
+
+    bool isStepped() const { return factor <= 0.0; }
+    double getFactor() const { return factor; }
+    TimePoint getStart() const { return start; }
+
+    // Moves a stepped clock forward; never backward
+    void advanceTo(TimePoint target) {
+        int64_t offset = std::chrono::duration_cast<std::chrono::nanoseconds>(target - start).count();
+        if (offset > stepped.load()) stepped.store(offset);
+    }
+
+    // Local time as YYYY-MM-DD, YYYY-MM-DDTHH:MM or YYYY-MM-DDTHH:MM:SS
+    // (a space may replace the T); DST is resolved by the C runtime, as
+    // this only reads command-line arguments
+    static bool parseLocal(const std::string& text, TimePoint& result) {
+        tm local = {};
+        int year, month, day, hour = 0, minute = 0, second = 0;
+        char separator = 'T';
+        int fields = sscanf(text.c_str(), "%d-%d-%d%c%d:%d:%d", &year, &month, &day, &separator, &hour, &minute, &second);
+        if (fields != 3 && fields < 6) return false;
+        if ((separator != 'T' && separator != ' ') || month < 1 || month > 12 || day < 1 || day > 31
+            || hour < 0 || hour > 23 || minute < 0 || minute > 59 || second < 0 || second > 59) {
+            return false;
+        }
+
+        local.tm_year = year - 1900;
+        local.tm_mon = month - 1;
+        local.tm_mday = day;
+        local.tm_hour = hour;
+        local.tm_min = minute;
+        local.tm_sec = second;
+        local.tm_isdst = -1;
+        time_t seconds = mktime(&local);
+        if (seconds == static_cast<time_t>(-1)) return false;
+        result = std::chrono::system_clock::from_time_t(seconds);
+        return true;
+    }
+
+private:
+    TimePoint start;
+    double factor;
+    std::chrono::steady_clock::time_point realStart;
+    std::atomic<int64_t> stepped{0}; // nanoseconds past start, stepped mode only
+};
+
+// Works out the next instant at which anything the loop produces can change:
+// the rendered gradient, the 15-second status line, the 30-minute accent
+// color or the date. The loop sleeps until then instead of polling. Local
+// time comes from the zone table, so the deadlines follow the table's
+// rules rather than the C runtime's; the table must belong to this thread.
+class UpdateScheduler {
+public:
+    typedef TimeSource::TimePoint TimePoint;
+
+    static constexpr int kStatusIntervalSeconds = 15;
+    static constexpr int kAccentIntervalSeconds = 1800;
+
+    UpdateScheduler(const TimeSource& timeSource, TimeZoneTable& timeZone) : clock(timeSource), zone(timeZone) {}
+
+    TimePoint nextDeadline(const ColorSchedule& schedule, TimePoint lastStatusUpdate, TimePoint lastAccentUpdate) const {
+        TimePoint now = clock.now();
+
+        TimePoint deadline = std::min(lastStatusUpdate + std::chrono::seconds(kStatusIntervalSeconds),
+                                      lastAccentUpdate + std::chrono::seconds(kAccentIntervalSeconds));
+        deadline = std::min(deadline, nextGradientChange(schedule, now));
+        deadline = std::min(deadline, nextMidnight(now));
+        return deadline;
+    }
+
+    // First whole second after now whose (current, +1 hour) color pair differs
+    // from the one on screen; bounded by midnight, which is a deadline anyway
+    TimePoint nextGradientChange(const ColorSchedule& schedule, TimePoint now) const {
+        long long nowSeconds = toSeconds(now);
+        long long local = nowSeconds + zone.offsetMinutesAt(nowSeconds) * 60LL;
+        int second = static_cast<int>(local - floorDays(local) * 86400);
+
+        Color bottom = schedule.colorAtSecond(second);
+        Color top = schedule.colorAtSecond(second + 3600);
+
+        int ahead = 1;
+        for (; second + ahead < 24 * 3600; ahead++) {
+            if (schedule.colorAtSecond(second + ahead) != bottom
+                || schedule.colorAtSecond(second + ahead + 3600) != top) {
+                break;
+            }
+        }
+        return fromSeconds(nowSeconds + ahead);
+    }
+
+    // The instant the local date next changes. When the clocks move at
+    // midnight, that is when the new date first shows: the end of a skipped
+    // hour, or the second pass through a repeated one.
+    TimePoint nextMidnight(TimePoint now) const {
+        long long nowSeconds = toSeconds(now);
+        int offset = zone.offsetMinutesAt(nowSeconds);
+        long long localMidnight = (floorDays(nowSeconds + offset * 60LL) + 1) * 86400;
+
+        long long midnight = localMidnight - offset * 60LL;
+        int offsetThen = zone.offsetMinutesAt(midnight);
+        if (offsetThen != offset) {
+            long long shifted = localMidnight - offsetThen * 60LL;
+            if (zone.offsetMinutesAt(shifted) == offsetThen) midnight = shifted;
+        }
+        return fromSeconds(midnight);
+    }
+
+private:
+    const TimeSource& clock;
+    TimeZoneTable& zone;
+
+    static long long floorDays(long long seconds) {
+        return seconds >= 0 ? seconds / 86400 : (seconds - 86399) / 86400;
+    }
+
+    static long long toSeconds(TimePoint time) {
+        return std::chrono::floor<std::chrono::seconds>(time.time_since_epoch()).count();
+    }
+
+    static TimePoint fromSeconds(long long seconds) {
+        return TimePoint(std::chrono::duration_cast<TimePoint::duration>(std::chrono::seconds(seconds)));
+    }
+};
+
+// Local solar times for a date from the offline ephemeris
+inline void computeLocalSolarTimes(int year, int month, int day, double latitude, double longitude,
+                                   TimeZoneTable& zone, SolarTimes& solarTimes) {
+    SolarCalculator::Events events = SolarCalculator::compute(year, month, day, latitude, longitude);
+    solarTimes.sunrise_hour = zone.utcToLocalHour(year, month, day, events.sunrise);
+    solarTimes.sunset_hour = zone.utcToLocalHour(year, month, day, events.sunset);
+    solarTimes.solar_noon_hour = zone.utcToLocalHour(year, month, day, events.solar_noon);
+    solarTimes.civil_twilight_begin = zone.utcToLocalHour(year, month, day, events.civil_twilight_begin);
+    solarTimes.civil_twilight_end = zone.utcToLocalHour(year, month, day, events.civil_twilight_end);
+}
+
+// Writes per-second colors for a run of consecutive days. Solar times are
+// computed up front on the calling thread; days are then swept in parallel
+// on the pool and written a block at a time. A path ending in .csv gets
+// "Date,Time,R,G,B,Period" rows; anything else gets the columnar binary
+// layout: Header, then r[], g[], b[] and period[] columns, each
+// dayCount * samplesPerDay bytes in time order, then the theme's period
+// names (uint32 count, then NUL-terminated strings indexed by period id).
+class ColorExporter {
+public:
+#pragma pack(push, 1)
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t firstDateKey; // YYYYMMDD
+        uint32_t dayCount;
+        uint32_t samplesPerDay;
+    };
+#pragma pack(pop)
+
+    static constexpr uint32_t kMagic = 0x58435754; // "TWCX"
+    static constexpr uint32_t kVersion = 2;
+    static constexpr int kSamplesPerDay = 24 * 3600;
+    static constexpr int kDaysPerBlock = 32;
+
+    static bool exportDays(long long firstDay, int dayCount, double latitude, double longitude,
+                           const std::shared_ptr<const ColorTheme>& theme, TimeZoneTable& zone,
+                           WorkStealingPool& pool, const std::string& path) {
+        if (dayCount <= 0) return false;
+        bool csv = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+
+        std::vector<SolarTimes> solarTimes(dayCount);
+        std::vector<std::string> dates(dayCount);
+        for (int i = 0; i < dayCount; i++) {
+            int year, month, day;
+            civilFromDays(firstDay + i, year, month, day);
+            computeLocalSolarTimes(year, month, day, latitude, longitude, zone, solarTimes[i]);
+
+            char date[16];
+            snprintf(date, sizeof(date), "%04d-%02d-%02d", year, month, day);
+            dates[i] = date;
+        }
+
+        std::ofstream out(path, std::ios::binary);
+        if (!out.is_open()) return false;
+
+        size_t totalSamples = static_cast<size_t>(dayCount) * kSamplesPerDay;
+        if (csv) {
+            out << "Date,Time,R,G,B,Period\n";
+        } else {
+            int year, month, day;
+            civilFromDays(firstDay, year, month, day);
+            Header header = { kMagic, kVersion, static_cast<uint32_t>(year * 10000 + month * 100 + day),
+                              static_cast<uint32_t>(dayCount), static_cast<uint32_t>(kSamplesPerDay) };
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        }
+
+        std::vector<std::string> text(csv ? kDaysPerBlock : 0);
+        std::vector<uint8_t> columns(csv ? 0 : static_cast<size_t>(4) * kDaysPerBlock * kSamplesPerDay);
+
+        for (int blockStart = 0; blockStart < dayCount; blockStart += kDaysPerBlock) {
+            int blockDays = std::min(kDaysPerBlock, dayCount - blockStart);
+            size_t blockSamples = static_cast<size_t>(blockDays) * kSamplesPerDay;
+
+            pool.run(blockDays, [&](size_t task) {
+                int dayIndex = blockStart + static_cast<int>(task);
+                ColorSchedule schedule;
+                schedule.setTheme(theme);
+                schedule.buildKeyframes(solarTimes[dayIndex]);
+                std::vector<ColorSchedule::Sample> samples(kSamplesPerDay);
+                schedule.sweep(1, samples.size(), samples.data());
+
+                if (csv) {
+                    formatDay(dates[dayIndex], samples, *theme, text[task]);
+                } else {
+                    size_t offset = task * kSamplesPerDay;
+                    for (int i = 0; i < kSamplesPerDay; i++) {
+                        columns[offset + i] = samples[i].r;
+                        columns[blockSamples + offset + i] = samples[i].g;
+                        columns[2 * blockSamples + offset + i] = samples[i].b;
+                        columns[3 * blockSamples + offset + i] = samples[i].period;
+                    }
+                }
+            });
+
+            if (csv) {
+                for (int i = 0; i < blockDays; i++) out.write(text[i].data(), text[i].size());
+            } else {
+                // Each block fills its slice of all four columns
+                for (int column = 0; column < 4; column++) {
+                    size_t position = sizeof(Header) + column * totalSamples + static_cast<size_t>(blockStart) * kSamplesPerDay;
+                    out.seekp(static_cast<std::streamoff>(position));
+                    out.write(reinterpret_cast<const char*>(columns.data() + column * blockSamples), blockSamples);
+                }
+            }
+        }
+
+        if (!csv) {
+            out.seekp(0, std::ios::end);
+            uint32_t nameCount = static_cast<uint32_t>(theme->getPeriodCount());
+            out.write(reinterpret_cast<const char*>(&nameCount), sizeof(nameCount));
+            for (uint32_t id = 0; id < nameCount; id++) {
+                const char* name = theme->periodName(static_cast<PeriodId>(id));
+                out.write(name, strlen(name) + 1);
+            }
+        }
+
+        out.close();
+        return !out.fail();
+    }
+
+private:
+    static char* appendNumber(char* p, int value) {
+        if (value >= 100) *p++ = static_cast<char>('0' + value / 100);
+        if (value >= 10) *p++ = static_cast<char>('0' + (value / 10) % 10);
+        *p++ = static_cast<char>('0' + value % 10);
+        return p;
+    }
+
+    static char* appendTwoDigits(char* p, int value) {
+        *p++ = static_cast<char>('0' + value / 10);
+        *p++ = static_cast<char>('0' + value % 10);
+        return p;
+    }
+
+    static void formatDay(const std::string& date, const std::vector<ColorSchedule::Sample>& samples,
+                          const ColorTheme& theme, std::string& text) {
+        text.clear();
+        text.reserve(samples.size() * 48);
+
+        char line[96];
+        for (int second = 0; second < static_cast<int>(samples.size()); second++) {
+            const ColorSchedule::Sample& sample = samples[second];
+            char* p = line;
+            memcpy(p, date.data(), date.size());
+            p += date.size();
+            *p++ = ',';
+            p = appendTwoDigits(p, second / 3600);
+            *p++ = ':';
+            p = appendTwoDigits(p, (second / 60) % 60);
+            *p++ = ':';
+            p = appendTwoDigits(p, second % 60);
+            *p++ = ',';
+            p = appendNumber(p, sample.r);
+            *p++ = ',';
+            p = appendNumber(p, sample.g);
+            *p++ = ',';
+            p = appendNumber(p, sample.b);
+            *p++ = ',';
+            text.append(line, p - line);
+            text += theme.periodName(sample.period); // theme names can be any length
+            text += '\n';
+        }
+    }
+};
+
+// Current and one-hour-ahead colors for many sites at one instant, for
+// driving a fleet of displays from one process. Each site's zone is a fixed
+// UTC offset ("UTC", "UTC+05:30", "-8") or a named zone, which brings that
+// zone's daylight rules. Named zones come from the caller's provider
+// factory (Windows time zone key names in the app); without one, only
+// fixed offsets are accepted.
+// Sites are evaluated in blocks across the pool; every block keeps its own
+// zone tables and schedule, so workers share nothing but the theme.
+//
+// Input is CSV rows of "site_id,latitude,longitude,zone", with an optional
+// header row; ids cannot contain commas. A path ending in .csv gets CSV
+// output; anything else gets the binary layout: Header, then one Record
+// per site, then the site ids as NUL-terminated strings in the same order,
+// then the theme's period names as in ColorExporter.
+class SiteBatch {
+public:
+    struct Site {
+        std::string id;
+        double latitude = 0.0;
+        double longitude = 0.0;
+        std::string zone;
+        bool fixedOffset = false;
+        int offsetMinutes = 0;
+    };
+
+    struct Result {
+        SolarTimes solarTimes;
+        int localSecond = 0;  // seconds since local midnight at the site
+        Color current, next;  // now and one hour ahead: the bottom and top of the site's gradient
+        PeriodId currentPeriod = 0, nextPeriod = 0;
+    };
+
+#pragma pack(push, 1)
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        int64_t utcSeconds;
+        uint32_t siteCount;
+        uint32_t recordSize;
+    };
+
+    struct Record {
+        float sunriseHour, sunsetHour, solarNoonHour; // local hours
+        int32_t localSecond;
+        uint32_t currentColor, nextColor;             // Color::packed()
+        uint8_t currentPeriod, nextPeriod;
+        uint16_t reserved;
+    };
+#pragma pack(pop)
+
+    static constexpr uint32_t kMagic = 0x42535754; // "TWSB"
+    static constexpr uint32_t kVersion = 1;
+    static constexpr size_t kSitesPerBlock = 256;
+
+    // Provider for a named zone, or null when the name is unknown
+    typedef std::function<std::unique_ptr<TimeZoneProvider>(const std::string& zoneName)> ZoneProviderFactory;
+
+    // Rows that cannot be used are reported in warnings and skipped
+    static bool readSites(const std::string& path, std::vector<Site>& sites,
+                          std::vector<std::string>& warnings, std::string& error,
+                          const ZoneProviderFactory& namedZones = nullptr) {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            error = "cannot open " + path;
+            return false;
+        }
+
+        std::map<std::string, bool> knownZones;
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(file, line)) {
+            lineNumber++;
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (trim(line).empty() || line[0] == '#') continue;
+
+            std::vector<std::string> fields;
+            std::stringstream ss(line);
+            std::string field;
+            while (std::getline(ss, field, ',')) fields.push_back(trim(field));
+
+            Site site;
+            std::string problem;
+            if (fields.size() != 4) {
+                problem = "expected site_id,latitude,longitude,zone";
+            } else if (!parseNumber(fields[1], site.latitude) || !parseNumber(fields[2], site.longitude)) {
+                if (sites.empty() && warnings.empty()) continue; // header row
+                problem = "bad coordinates";
+            } else if (site.latitude < -90 || site.latitude > 90 || site.longitude < -180 || site.longitude > 180) {
+                problem = "coordinates out of range";
+            } else if (fields[0].empty()) {
+                problem = "missing site id";
+            } else {
+                site.id = fields[0];
+                site.zone = fields[3];
+                if (parseUtcOffset(site.zone, site.offsetMinutes)) {
+                    site.fixedOffset = true;
+                } else {
+                    auto known = knownZones.find(site.zone);
+                    if (known == knownZones.end()) {
+                        known = knownZones.emplace(site.zone, namedZones && namedZones(site.zone) != nullptr).first;
+                    }
+                    if (!known->second) problem = "unknown zone '" + site.zone + "'";
+                }
+            }
+
+            if (!problem.empty()) {
+                warnings.push_back("line " + std::to_string(lineNumber) + ": " + problem);
+                continue;
+            }
+            sites.push_back(site);
+        }
+        return true;
+    }
+
+    static void evaluate(const std::vector<Site>& sites, long long utcSeconds,
+                         const std::shared_ptr<const ColorTheme>& theme, WorkStealingPool& pool,
+                         std::vector<Result>& results, const ZoneProviderFactory& namedZones = nullptr) {
+        results.assign(sites.size(), Result());
+        size_t blockCount = (sites.size() + kSitesPerBlock - 1) / kSitesPerBlock;
+
+        pool.run(blockCount, [&](size_t block) {
+            std::map<std::string, TimeZoneTable> zones;
+            ColorSchedule schedule;
+            schedule.setTheme(theme);
+
+            size_t end = std::min(sites.size(), (block + 1) * kSitesPerBlock);
+            for (size_t i = block * kSitesPerBlock; i < end; i++) {
+                const Site& site = sites[i];
+                auto zone = zones.find(site.zone);
+                if (zone == zones.end()) {
+                    std::unique_ptr<TimeZoneProvider> provider;
+                    if (!site.fixedOffset && namedZones) provider = namedZones(site.zone);
+                    // readSites only passes names the factory knows; anything else is UTC
+                    if (!provider) provider = std::make_unique<FixedOffsetTimeZoneProvider>(site.offsetMinutes);
+                    zone = zones.emplace(site.zone, TimeZoneTable(std::move(provider))).first;
+                }
+                evaluateSite(site, utcSeconds, zone->second, schedule, results[i]);
+            }
+        });
+    }
+
+    static bool write(const std::string& path, long long utcSeconds, const std::vector<Site>& sites,
+                      const std::vector<Result>& results, const ColorTheme& theme) {
+        std::ofstream out(path, std::ios::binary);
+        if (!out.is_open()) return false;
+
+        bool csv = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+        if (csv) {
+            std::string text = "SiteId,LocalTime,Sunrise,Sunset,SolarNoon,R,G,B,Period,NextR,NextG,NextB,NextPeriod\n";
+            char line[160];
+            for (size_t i = 0; i < sites.size(); i++) {
+                const Result& r = results[i];
+                int second = r.localSecond;
+                snprintf(line, sizeof(line), ",%02d:%02d:%02d,%.4f,%.4f,%.4f,%d,%d,%d,",
+                         second / 3600, (second / 60) % 60, second % 60,
+                         r.solarTimes.sunrise_hour, r.solarTimes.sunset_hour, r.solarTimes.solar_noon_hour,
+                         r.current.r, r.current.g, r.current.b);
+                text += sites[i].id;
+                text += line;
+                text += theme.periodName(r.currentPeriod);
+                snprintf(line, sizeof(line), ",%d,%d,%d,", r.next.r, r.next.g, r.next.b);
+                text += line;
+                text += theme.periodName(r.nextPeriod);
+                text += '\n';
+            }
+            out.write(text.data(), text.size());
+        } else {
+            Header header = { kMagic, kVersion, static_cast<int64_t>(utcSeconds),
+                              static_cast<uint32_t>(sites.size()), static_cast<uint32_t>(sizeof(Record)) };
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+            std::vector<Record> records(sites.size());
+            for (size_t i = 0; i < sites.size(); i++) {
+                const Result& r = results[i];
+                records[i] = { static_cast<float>(r.solarTimes.sunrise_hour), static_cast<float>(r.solarTimes.sunset_hour),
+                               static_cast<float>(r.solarTimes.solar_noon_hour), r.localSecond,
+                               r.current.packed(), r.next.packed(), r.currentPeriod, r.nextPeriod, 0 };
+            }
+            out.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(Record));
+
+            for (const Site& site : sites) out.write(site.id.c_str(), site.id.size() + 1);
+
+            uint32_t nameCount = static_cast<uint32_t>(theme.getPeriodCount());
+            out.write(reinterpret_cast<const char*>(&nameCount), sizeof(nameCount));
+            for (uint32_t id = 0; id < nameCount; id++) {
+                const char* name = theme.periodName(static_cast<PeriodId>(id));
+                out.write(name, strlen(name) + 1);
+            }
+        }
+
+        out.close();
+        return !out.fail();
+    }
+
+    // "UTC", "GMT", "Z", or an optional UTC/GMT prefix then +/-H, HH, H:MM, HH:MM or HHMM
+    static bool parseUtcOffset(const std::string& text, int& offsetMinutes) {
+        if (text.empty()) return false;
+        std::string rest = text;
+        if (rest.compare(0, 3, "UTC") == 0 || rest.compare(0, 3, "GMT") == 0) rest = rest.substr(3);
+        if (rest.empty() || text == "Z") {
+            offsetMinutes = 0;
+            return true;
+        }
+        if (rest[0] != '+' && rest[0] != '-') return false;
+
+        int sign = rest[0] == '-' ? -1 : 1;
+        std::string digits = rest.substr(1);
+        size_t colon = digits.find(':');
+        std::string hourText = colon == std::string::npos ? digits : digits.substr(0, colon);
+        std::string minuteText = colon == std::string::npos ? "" : digits.substr(colon + 1);
+        if (colon == std::string::npos && digits.size() == 4) {
+            hourText = digits.substr(0, 2);
+            minuteText = digits.substr(2);
+        }
+        if (hourText.empty() || hourText.size() > 2 || (colon != std::string::npos && minuteText.size() != 2)) return false;
+        for (char c : hourText + minuteText) {
+            if (c < '0' || c > '9') return false;
+        }
+
+        int hours = std::stoi(hourText);
+        int minutes = minuteText.empty() ? 0 : std::stoi(minuteText);
+        if (hours > 14 || minutes > 59) return false;
+        offsetMinutes = sign * (hours * 60 + minutes);
+        return true;
+    }
+
+private:
+    static void evaluateSite(const Site& site, long long utcSeconds, TimeZoneTable& zone,
+                             ColorSchedule& schedule, Result& result) {
+        long long localSeconds = utcSeconds + zone.offsetMinutesAt(utcSeconds) * 60LL;
+        long long localDays = localSeconds >= 0 ? localSeconds / 86400 : (localSeconds - 86399) / 86400;
+        int second = static_cast<int>(localSeconds - localDays * 86400);
+
+        int year, month, day;
+        civilFromDays(localDays, year, month, day);
+        computeLocalSolarTimes(year, month, day, site.latitude, site.longitude, zone, result.solarTimes);
+        schedule.buildKeyframes(result.solarTimes);
+
+        // The same day's schedule for both, as the display wraps it past midnight
+        result.localSecond = second;
+        result.current = schedule.evaluate(second / 3600.0, result.currentPeriod);
+        result.next = schedule.evaluate(((second + 3600) % 86400) / 3600.0, result.nextPeriod);
+    }
+};
+
+// Versioned binary solar cache layout: a fixed header followed by
+// fixed-size records sorted by date, so decoding copies records out with
+// no text parsing
+class SolarCacheCodec {
+public:
+    static constexpr uint32_t kMagic = 0x43535754; // "TWSC"
+    static constexpr uint32_t kVersion = 2;        // 2 appends refreshedKey to each record
+
+#pragma pack(push, 1)
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t recordSize;
+        uint32_t recordCount;
+        char lastUpdated[16];
+    };
+
+    struct Record {
+        int32_t dateKey; // YYYYMMDD
+        uint8_t valid;
+        char source[27];
+        double sunrise;
+        double sunset;
+        double solarNoon;
+        double civilTwilightBegin;
+        double civilTwilightEnd;
+        int32_t refreshedKey; // YYYYMMDD the entry was fetched or computed on
+    };
+#pragma pack(pop)
+
+    static constexpr uint32_t kVersion1RecordSize = sizeof(Record) - sizeof(int32_t);
+
+    static int dateKey(const std::string& date) {
+        int year, month, day;
+        if (sscanf(date.c_str(), "%d-%d-%d", &year, &month, &day) != 3) return 0;
+        return year * 10000 + month * 100 + day;
+    }
+
+    static bool dayFromKey(int key, long long& day) {
+        int month = (key / 100) % 100, dayOfMonth = key % 100;
+        if (key <= 0 || month < 1 || month > 12 || dayOfMonth < 1 || dayOfMonth > 31) return false;
+        day = daysFromCivil(key / 10000, month, dayOfMonth);
+        return true;
+    }
+
+    static std::string dateFromKey(int key) {
+        char buffer[16];
+        snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d", key / 10000, (key / 100) % 100, key % 100);
+        return buffer;
+    }
+
+    static bool decode(const void* data, size_t size, SolarCache& cache) {
+        if (size < sizeof(Header)) return false;
+
+        // Version 1 records are the same minus refreshedKey; they count as refreshed on last_updated
+        Header header;
+        std::memcpy(&header, data, sizeof(header));
+        if (header.magic != kMagic) return false;
+        if (!(header.version == kVersion && header.recordSize == sizeof(Record))
+            && !(header.version == 1 && header.recordSize == kVersion1RecordSize)) {
+            return false;
+        }
+        if (size < sizeof(Header) + static_cast<size_t>(header.recordCount) * header.recordSize) return false;
+
+        cache.last_updated.assign(header.lastUpdated, strnlen(header.lastUpdated, sizeof(header.lastUpdated)));
+        cache.firstDay = 0;
+        cache.days.clear();
+        long long lastUpdatedDay = 0;
+        SolarCache::parseDay(cache.last_updated, lastUpdatedDay);
+
+        const unsigned char* bytes = static_cast<const unsigned char*>(data) + sizeof(Header);
+        for (uint32_t i = 0; i < header.recordCount; i++) {
+            Record record = {};
+            std::memcpy(&record, bytes + static_cast<size_t>(i) * header.recordSize, header.recordSize);
+
+            // Records are sorted, so the window only grows forward; bound it against corrupt dates
+            long long dayNumber;
+            if (!dayFromKey(record.dateKey, dayNumber)) continue;
+            if (!cache.days.empty() && dayNumber - cache.firstDay >= SolarCache::kMaxDays) break;
+
+            SolarTimes day;
+            day.fetch_date = dateFromKey(record.dateKey);
+            day.valid = record.valid != 0;
+            day.source.assign(record.source, strnlen(record.source, sizeof(record.source)));
+            day.sunrise_hour = record.sunrise;
+            day.sunset_hour = record.sunset;
+            day.solar_noon_hour = record.solarNoon;
+            day.civil_twilight_begin = record.civilTwilightBegin;
+            day.civil_twilight_end = record.civilTwilightEnd;
+            if (!dayFromKey(record.refreshedKey, day.refreshed_day)) day.refreshed_day = lastUpdatedDay;
+            cache.put(dayNumber, day);
+        }
+        return true;
+    }
+
+    static std::string encode(const SolarCache& cache) {
+        std::vector<Record> records;
+        for (const SolarTimes& day : cache.days) {
+            int key = dateKey(day.fetch_date);
+            if (key == 0) continue; // empty slot
+
+            Record record = {};
+            record.dateKey = key;
+            record.valid = day.valid ? 1 : 0;
+            strncpy(record.source, day.source.c_str(), sizeof(record.source) - 1);
+            record.sunrise = day.sunrise_hour;
+            record.sunset = day.sunset_hour;
+            record.solarNoon = day.solar_noon_hour;
+            record.civilTwilightBegin = day.civil_twilight_begin;
+            record.civilTwilightEnd = day.civil_twilight_end;
+            int year, month, dayOfMonth;
+            civilFromDays(day.refreshed_day, year, month, dayOfMonth);
+            record.refreshedKey = year * 10000 + month * 100 + dayOfMonth;
+            records.push_back(record);
+        }
+        std::sort(records.begin(), records.end(),
+                  [](const Record& a, const Record& b) { return a.dateKey < b.dateKey; });
+
+        Header header = {};
+        header.magic = kMagic;
+        header.version = kVersion;
+        header.recordSize = sizeof(Record);
+        header.recordCount = static_cast<uint32_t>(records.size());
+        strncpy(header.lastUpdated, cache.last_updated.c_str(), sizeof(header.lastUpdated) - 1);
+
+        std::string bytes(reinterpret_cast<const char*>(&header), sizeof(header));
+        bytes.append(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(Record));
+        return bytes;
+    }
+};
+
+// Single-pass JSON scanner over a string_view. It validates the whole
+// document and hands every scalar object member to a visitor as views into
+// the input, so extracting fields never copies or allocates.
+class JsonScanner {
+public:
+    enum ValueType { JSON_STRING, JSON_NUMBER, JSON_LITERAL };
+
+    struct Member {
+        std::string_view key;
+        std::string_view value; // raw: string contents without quotes, escapes untouched
+        ValueType type;
+        int depth;              // 0 for members of the top-level object
+    };
+
+    template <typename Visitor>
+    static bool scan(std::string_view json, Visitor&& visit) {
+        JsonScanner scanner(json);
+        scanner.skipWhitespace();
+        if (!scanner.parseValue(std::string_view(), -1, visit)) return false;
+        scanner.skipWhitespace();
+        return scanner.pos == json.size();
+    }
+
+    static bool toDouble(std::string_view number, double& out) {
+        const char* end = number.data() + number.size();
+        auto result = std::from_chars(number.data(), end, out);
+        return result.ec == std::errc() && result.ptr == end;
+    }
+
+    // Decodes escapes in a raw string value; only used for values that are kept
+    static std::string unescape(std::string_view raw) {
+        std::string out;
+        out.reserve(raw.size());
+        for (size_t i = 0; i < raw.size(); i++) {
+            char c = raw[i];
+            if (c != '\\' || i + 1 >= raw.size()) {
+                out += c;
+                continue;
+            }
+            char e = raw[++i];
+            switch (e) {
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    unsigned code = hex4(raw, i + 1);
+                    i += 4;
+                    if (code >= 0xD800 && code < 0xDC00 && i + 6 < raw.size() && raw[i + 1] == '\\' && raw[i + 2] == 'u') {
+                        unsigned low = hex4(raw, i + 3);
+                        if (low >= 0xDC00 && low < 0xE000) {
+                            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                            i += 6;
+                        }
+                    }
+                    appendUtf8(out, code);
+                    break;
+                }
+                default: out += e; break; // \" \\ \/
+            }
+        }
+        return out;
+    }
+
+private:
+    static constexpr int kMaxDepth = 32;
+
+    std::string_view text;
+    size_t pos = 0;
+
+    explicit JsonScanner(std::string_view json) : text(json) {}
+
+    static unsigned hex4(std::string_view s, size_t at) {
+        unsigned value = 0;
+        for (size_t i = at; i < at + 4 && i < s.size(); i++) {
+            char c = s[i];
+            value <<= 4;
+            if (c >= '0' && c <= '9') value |= c - '0';
+            else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+        }
+        return value;
+    }
+
+    static void appendUtf8(std::string& out, unsigned code) {
+        if (code < 0x80) {
+            out += static_cast<char>(code);
+        } else if (code < 0x800) {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (code >> 18));
+            out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    static bool isHex(char c) {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+    }
+
+    void skipWhitespace() {
+        while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r')) pos++;
+    }
+
+    bool consume(char c) {
+        skipWhitespace();
+        if (pos < text.size() && text[pos] == c) {
+            pos++;
+            return true;
+        }
+        return false;
+    }
+
+    bool parseString(std::string_view& out) {
+        if (pos >= text.size() || text[pos] != '"') return false;
+        size_t start = ++pos;
+        while (pos < text.size()) {
+            char c = text[pos];
+            if (c == '"') {
+                out = text.substr(start, pos - start);
+                pos++;
+                return true;
+            }
+            if (static_cast<unsigned char>(c) < 0x20) return false;
+            if (c == '\\') {
+                if (++pos >= text.size()) return false;
+                char e = text[pos];
+                if (e == 'u') {
+                    if (pos + 4 >= text.size()) return false;
+                    for (int i = 1; i <= 4; i++) {
+                        if (!isHex(text[pos + i])) return false;
+                    }
+                    pos += 4;
+                } else if (e != '"' && e != '\\' && e != '/' && e != 'b' && e != 'f' && e != 'n' && e != 'r' && e != 't') {
+                    return false;
+                }
+            }
+            pos++;
+        }
+        return false;
+    }
+
+    bool parseNumber(std::string_view& out) {
+        size_t start = pos;
+        if (pos < text.size() && text[pos] == '-') pos++;
+        if (pos >= text.size()) return false;
+        if (text[pos] == '0') {
+            pos++;
+        } else if (text[pos] >= '1' && text[pos] <= '9') {
+            while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') pos++;
+        } else {
+            return false;
+        }
+        if (pos < text.size() && text[pos] == '.') {
+            pos++;
+            size_t digits = pos;
+            while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') pos++;
+            if (pos == digits) return false;
+        }
+        if (pos < text.size() && (text[pos] == 'e' || text[pos] == 'E')) {
+            pos++;
+            if (pos < text.size() && (text[pos] == '+' || text[pos] == '-')) pos++;
+            size_t digits = pos;
+            while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') pos++;
+            if (pos == digits) return false;
+        }
+        out = text.substr(start, pos - start);
+        return true;
+    }
+
+    bool parseLiteral(std::string_view& out) {
+        static const std::string_view literals[] = {"true", "false", "null"};
+        for (std::string_view literal : literals) {
+            if (text.substr(pos, literal.size()) == literal) {
+                out = text.substr(pos, literal.size());
+                pos += literal.size();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template <typename Visitor>
+    bool parseValue(std::string_view key, int depth, Visitor& visit) {
+        skipWhitespace();
+        if (pos >= text.size()) return false;
+
+        char c = text[pos];
+        if (c == '{' || c == '[') {
+            if (depth + 1 >= kMaxDepth) return false;
+            return c == '{' ? parseObject(depth + 1, visit) : parseArray(depth + 1, visit);
+        }
+
+        Member member;
+        member.key = key;
+        member.depth = depth;
+        bool ok;
+        if (c == '"') {
+            member.type = JSON_STRING;
+            ok = parseString(member.value);
+        } else if (c == '-' || (c >= '0' && c <= '9')) {
+            member.type = JSON_NUMBER;
+            ok = parseNumber(member.value);
+        } else {
+            member.type = JSON_LITERAL;
+            ok = parseLiteral(member.value);
+        }
+
+        // Scalars are only reported as object members
+        if (ok && depth >= 0 && !key.empty()) visit(member);
+        return ok;
+    }
+
+    template <typename Visitor>
+    bool parseObject(int depth, Visitor& visit) {
+        pos++; // '{'
+        if (consume('}')) return true;
+        do {
+            skipWhitespace();
+            std::string_view key;
+            if (!parseString(key) || !consume(':')) return false;
+            if (!parseValue(key, depth, visit)) return false;
+        } while (consume(','));
+        return consume('}');
+    }
+
+    template <typename Visitor>
+    bool parseArray(int depth, Visitor& visit) {
+        pos++; // '['
+        if (consume(']')) return true;
+        do {
+            if (!parseValue(std::string_view(), depth, visit)) return false;
+        } while (consume(','));
+        return consume(']');
+    }
+};
+
+// Parses an ISO 8601 timestamp of the form YYYY-MM-DDTHH:MM:SS(+HH:MM|Z)
+// into its UTC date and hour of that day
+inline bool parseIsoUtcTime(std::string_view s, int& year, int& month, int& day, double& utcHour) {
+    auto digits = [&](size_t at, size_t count, int& out) {
+        out = 0;
+        for (size_t i = at; i < at + count; i++) {
+            if (i >= s.size() || s[i] < '0' || s[i] > '9') return false;
+            out = out * 10 + (s[i] - '0');
+        }
+        return true;
+    };
+
+    int hours, minutes, seconds;
+    if (s.size() < 20 || s[4] != '-' || s[7] != '-' || s[10] != 'T' || s[13] != ':' || s[16] != ':') return false;
+    if (!digits(0, 4, year) || !digits(5, 2, month) || !digits(8, 2, day)
+        || !digits(11, 2, hours) || !digits(14, 2, minutes) || !digits(17, 2, seconds)) return false;
+    if (month < 1 || month > 12 || day < 1 || day > 31 || hours > 23 || minutes > 59 || seconds > 60) return false;
+
+    int offsetMinutes = 0;
+    if (s.size() == 20 && s[19] == 'Z') {
+        offsetMinutes = 0;
+    } else if (s.size() == 25 && (s[19] == '+' || s[19] == '-') && s[22] == ':') {
+        int offsetHours, offsetMins;
+        if (!digits(20, 2, offsetHours) || !digits(23, 2, offsetMins)) return false;
+        offsetMinutes = (offsetHours * 60 + offsetMins) * (s[19] == '-' ? -1 : 1);
+    } else {
+        return false;
+    }
+
+    // Leave the hour relative to the stated date; callers convert with that date
+    utcHour = hours + (minutes / 60.0) + (seconds / 3600.0) - offsetMinutes / 60.0;
+    return true;
+}
+
+// Reads the five event times from an api.sunrise-sunset.org response
+// (formatted=0) as local hours, using the offset in effect on each date
+inline bool parseSunriseSunsetJson(std::string_view response, TimeZoneTable& zone, SolarTimes& solarTimes) {
+    // One scan picks up the status and the five timestamps under "results"
+    std::string_view status, sunrise, sunset, solarNoon, twilightBegin, twilightEnd;
+    bool wellFormed = JsonScanner::scan(response, [&](const JsonScanner::Member& m) {
+        if (m.depth == 0) {
+            if (m.key == "status") status = m.value;
+        } else if (m.depth == 1 && m.type == JsonScanner::JSON_STRING) {
+            if (m.key == "sunrise") sunrise = m.value;
+            else if (m.key == "sunset") sunset = m.value;
+            else if (m.key == "solar_noon") solarNoon = m.value;
+            else if (m.key == "civil_twilight_begin") twilightBegin = m.value;
+            else if (m.key == "civil_twilight_end") twilightEnd = m.value;
+        }
+    });
+    if (!wellFormed || status != "OK") return false;
+
+    auto localHour = [&](std::string_view timeStr, double& hour) {
+        int year, month, day;
+        double utcHour;
+        if (!parseIsoUtcTime(timeStr, year, month, day, utcHour)) return false;
+        hour = zone.utcToLocalHour(year, month, day, utcHour);
+        return true;
+    };
+    return localHour(sunrise, solarTimes.sunrise_hour) && localHour(sunset, solarTimes.sunset_hour)
+        && localHour(solarNoon, solarTimes.solar_noon_hour)
+        && localHour(twilightBegin, solarTimes.civil_twilight_begin)
+        && localHour(twilightEnd, solarTimes.civil_twilight_end);
+}
+
+// The rolling solar cache window: which days a refresh needs, the API
+// requests for them, and filling the window from an API batch with the
+// ephemeris as the fallback. Touches the cache and zone table it is given,
+// so refresh() belongs on the thread that owns them; fetch() only does
+// network work and can run anywhere.
+class SolarWindow {
+public:
+    // API answers for days, in the same order
+    struct ApiBatch {
+        std::vector<long long> days;
+        std::vector<ConcurrentFetcher::Result> results;
+    };
+
+    struct Refresh {
+        std::vector<long long> wanted;  // missing or stale when the refresh started
+        std::vector<long long> fromApi; // stored from the batch
+        std::vector<bool> apiOk;        // per batch day: answered and parsed
+        int computed = 0;
+        int kept = 0;                   // stale API days the API did not refresh
+    };
+
+    double latitude = 0.0;
+    double longitude = 0.0;
+    int windowDays = 30;
+    int maxAgeDays = 30;  // 0 keeps days until they leave the window
+    bool apiMode = false; // solar_source=api
+
+    int length() const {
+        return std::min(std::max(windowDays, 1), SolarCache::kMaxDays);
+    }
+
+    // A cached day is fetched again when it is missing or invalid, older than
+    // maxAgeDays, or was computed in place of an API day that failed
+    bool needsRefresh(const SolarTimes* entry, long long today) const {
+        if (!entry || !entry->valid) return true;
+        if (apiMode && entry->source != "api") return true;
+        return maxAgeDays > 0 && today - entry->refreshed_day >= maxAgeDays;
+    }
+
+    // Days of the window starting today that a refresh has to fetch
+    std::vector<long long> daysToRefresh(SolarCache& cache, long long today) const {
+        std::vector<long long> wanted;
+        for (int offset = 0; offset < length(); offset++) {
+            if (needsRefresh(cache.find(today + offset), today)) wanted.push_back(today + offset);
+        }
+        return wanted;
+    }
+
+    static std::string apiUrl(double latitude, double longitude, long long day) {
+        std::stringstream urlBuilder;
+        urlBuilder << "https://api.sunrise-sunset.org/json?lat=" << latitude
+                   << "&lng=" << longitude << "&date=" << SolarCache::formatDay(day) << "&formatted=0";
+        return urlBuilder.str();
+    }
+
+    // Fetches days concurrently under deadlineMs; urlFor defaults to apiUrl
+    ApiBatch fetch(ConcurrentFetcher& fetcher, const std::vector<long long>& days, int deadlineMs,
+                   const ConcurrentFetcher::Transport& transport,
+                   const std::function<std::string(long long day)>& urlFor = nullptr) const {
+        ApiBatch batch;
+        batch.days = days;
+        std::vector<std::string> urls;
+        for (long long day : days) urls.push_back(urlFor ? urlFor(day) : apiUrl(latitude, longitude, day));
+        batch.results = fetcher.fetchAll(urls, deadlineMs, transport);
+        return batch;
+    }
+
+    static bool computeDay(long long day, double latitude, double longitude, long long today,
+                           TimeZoneTable& zone, SolarTimes& solarTimes) {
+        int year, month, dayOfMonth;
+        civilFromDays(day, year, month, dayOfMonth);
+        computeLocalSolarTimes(year, month, dayOfMonth, latitude, longitude, zone, solarTimes);
+        solarTimes.valid = true;
+        solarTimes.fetch_date = SolarCache::formatDay(day);
+        solarTimes.source = "computed";
+        solarTimes.refreshed_day = today;
+        return true;
+    }
+
+    static bool parseDay(const std::string& response, long long day, long long today, TimeZoneTable& zone, SolarTimes& solarTimes) {
+        SolarTimes parsed;
+        if (!parseSunriseSunsetJson(response, zone, parsed)) return false;
+        parsed.valid = true;
+        parsed.fetch_date = SolarCache::formatDay(day);
+        parsed.source = "api";
+        parsed.refreshed_day = today;
+        solarTimes = parsed;
+        return true;
+    }
+
+    // Shifts the window to start today and fills only the days that are
+    // missing or stale: from the batch where it answered (its days may
+    // predate the shift; those outside the window are dropped), computing
+    // the rest. A stale API day the API failed to refresh keeps its old
+    // times in api mode.
+    Refresh refresh(SolarCache& cache, long long today, const ApiBatch* batch, TimeZoneTable& zone) const {
+        Refresh result;
+        cache.shift(today, length());
+        result.wanted = daysToRefresh(cache, today);
+
+        if (batch) {
+            for (size_t i = 0; i < batch->results.size(); i++) {
+                const ConcurrentFetcher::Result& fetched = batch->results[i];
+                SolarTimes* entry = cache.slot(batch->days[i]);
+                SolarTimes parsed;
+                bool ok = fetched.completed && entry && parseDay(fetched.body, batch->days[i], today, zone, parsed);
+                if (ok) {
+                    *entry = parsed;
+                    result.fromApi.push_back(batch->days[i]);
+                }
+                result.apiOk.push_back(ok);
+            }
+        }
+
+        for (long long day : result.wanted) {
+            if (std::find(result.fromApi.begin(), result.fromApi.end(), day) != result.fromApi.end()) continue;
+
+            SolarTimes* entry = cache.slot(day);
+            if (apiMode && entry->valid && entry->source == "api") {
+                result.kept++;
+            } else if (computeDay(day, latitude, longitude, today, zone, *entry)) {
+                result.computed++;
+            }
+        }
+
+        SolarTimes* todays = cache.find(today);
+        if (todays && todays->valid) cache.last_updated = SolarCache::formatDay(today);
+        return result;
+    }
+};
+
+// Accent color derived from the background: 15% black over light colors,
+// 15% white over dark ones
+inline Color accentColorFor(const Color& bgColor) {
+    // Determine brightness to decide whether to blend with black or white
+    int brightness = (bgColor.r + bgColor.g + bgColor.b) / 3;
+
+    Color accentColor;
+    float blendAmount = 0.15f; // 15% opacity overlay
+
+    if (brightness > 128) {
+        // Light background - overlay black at 15% opacity
+        accentColor.r = (unsigned char)(bgColor.r * (1.0f - blendAmount));
+        accentColor.g = (unsigned char)(bgColor.g * (1.0f - blendAmount));
+        accentColor.b = (unsigned char)(bgColor.b * (1.0f - blendAmount));
+    } else {
+        // Dark background - overlay white at 15% opacity
+        accentColor.r = (unsigned char)(bgColor.r * (1.0f - blendAmount) + 255 * blendAmount);
+        accentColor.g = (unsigned char)(bgColor.g * (1.0f - blendAmount) + 255 * blendAmount);
+        accentColor.b = (unsigned char)(bgColor.b * (1.0f - blendAmount) + 255 * blendAmount);
+    }
+    return accentColor;
+}
+
+// Destination for accent color changes. Implementations may block.
+class AccentSink {
+public:
+    virtual ~AccentSink() {}
+    virtual void apply(const Color& accentColor) = 0;
+};
+
+// Drops every color; simulated runs use it so they never touch the
+// system accent
+class NullAccentSink : public AccentSink {
+public:
+    void apply(const Color&) override {}
+};
+
+// Applies accent colors on a background thread. submit() only swaps the
+// pending color under a lock, so callers never wait on the sink. Updates
+// that arrive while one is being applied coalesce (the latest wins), and a
+// color equal to the last one applied is skipped.
+class AccentWorker {
+public:
+    struct Stats {
+        unsigned long submitted = 0;
+        unsigned long applied = 0;
+        unsigned long unchanged = 0; // skipped, same as the last applied color
+    };
+
+    explicit AccentWorker(std::unique_ptr<AccentSink> accentSink) : sink(std::move(accentSink)) {
+        worker = std::thread(&AccentWorker::workerLoop, this);
+    }
+
+    ~AccentWorker() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        worker.join();
+    }
+
+    AccentWorker(const AccentWorker&) = delete;
+    AccentWorker& operator=(const AccentWorker&) = delete;
+
+    void submit(const Color& accentColor) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending = accentColor;
+            hasPending = true;
+            stats.submitted++;
+        }
+        wake.notify_one();
+    }
+
+    // Blocks until everything submitted so far has been applied or skipped
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [this] { return !hasPending && !busy; });
+    }
+
+    Stats getStats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stats;
+    }
+
+private:
+    std::unique_ptr<AccentSink> sink;
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    Color pending;
+    bool hasPending = false;
+    bool busy = false;
+    bool stopping = false;
+    bool hasApplied = false;
+    Color lastApplied;
+    Stats stats;
+    std::thread worker;
+
+    void workerLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            wake.wait(lock, [this] { return hasPending || stopping; });
+            if (stopping) break;
+
+            Color accentColor = pending;
+            hasPending = false;
+            if (hasApplied && accentColor == lastApplied) {
+                stats.unchanged++;
+                idle.notify_all();
+                continue;
+            }
+
+            busy = true;
+            lock.unlock();
+            sink->apply(accentColor);
+            lock.lock();
+            busy = false;
+
+            lastApplied = accentColor;
+            hasApplied = true;
+            stats.applied++;
+            idle.notify_all();
+        }
+    }
+};
+
+// Minimal gzip writer: one fixed-Huffman deflate block fed by a hash-chain
+// LZ77 matcher. Log text compresses to a fifth of its size or less, and any
+// gzip tool can read the output without a compression library here.
+class GzipEncoder {
+public:
+    static std::string compress(const char* data, size_t size) {
+        std::string out;
+        out.reserve(size / 3 + 64);
+        static const unsigned char header[10] = { 0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 0x0b }; // deflate, NTFS
+        out.append(reinterpret_cast<const char*>(header), sizeof(header));
+
+        BitWriter bits(out);
+        bits.put(1, 1); // final block
+        bits.put(1, 2); // fixed Huffman codes
+
+        const uint8_t* input = reinterpret_cast<const uint8_t*>(data);
+        std::vector<int32_t> head(kHashSize, -1);
+        std::vector<int32_t> previous(kWindowSize, -1);
+        size_t position = 0;
+        while (position < size) {
+            int bestLength = 0, bestDistance = 0;
+            if (position + kMinMatch <= size) {
+                uint32_t hash = hashAt(input + position);
+                int chain = kMaxChain;
+                for (int32_t candidate = head[hash]; candidate >= 0 && chain-- > 0;
+                     candidate = previous[candidate & (kWindowSize - 1)]) {
+                    size_t distance = position - static_cast<size_t>(candidate);
+                    if (distance > kWindowSize - 1) break;
+                    int limit = static_cast<int>(std::min<size_t>(kMaxMatch, size - position));
+                    int length = 0;
+                    while (length < limit && input[candidate + length] == input[position + length]) length++;
+                    if (length > bestLength) {
+                        bestLength = length;
+                        bestDistance = static_cast<int>(distance);
+                        if (length == limit) break;
+                    }
+                }
+            }
+
+            size_t advance = 1;
+            if (bestLength >= kMinMatch) {
+                putLength(bits, bestLength);
+                putDistance(bits, bestDistance);
+                advance = static_cast<size_t>(bestLength);
+            } else {
+                putLiteral(bits, input[position]);
+            }
+
+            // Index every position the step covers so later matches can find them
+            for (size_t end = position + advance; position < end; position++) {
+                if (position + kMinMatch <= size) {
+                    uint32_t hash = hashAt(input + position);
+                    previous[position & (kWindowSize - 1)] = head[hash];
+                    head[hash] = static_cast<int32_t>(position);
+                }
+            }
+        }
+        putLiteral(bits, 256); // end of block
+        bits.finish();
+
+        uint32_t crc = crc32(input, size);
+        uint32_t length = static_cast<uint32_t>(size);
+        for (int i = 0; i < 4; i++) out += static_cast<char>((crc >> (8 * i)) & 0xff);
+        for (int i = 0; i < 4; i++) out += static_cast<char>((length >> (8 * i)) & 0xff);
+        return out;
+    }
+
+    static uint32_t crc32(const uint8_t* data, size_t size) {
+        static const std::vector<uint32_t> table = [] {
+            std::vector<uint32_t> entries(256);
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t value = i;
+                for (int bit = 0; bit < 8; bit++) value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+                entries[i] = value;
+            }
+            return entries;
+        }();
+
+        uint32_t crc = 0xFFFFFFFFu;
+        for (size_t i = 0; i < size; i++) crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+        return crc ^ 0xFFFFFFFFu;
+    }
+
+private:
+    static constexpr int kWindowSize = 32768;
+    static constexpr int kHashSize = 1 << 15;
+    static constexpr int kMinMatch = 3;
+    static constexpr int kMaxMatch = 258;
+    static constexpr int kMaxChain = 32;
+
+    // Deflate packs fields LSB first but Huffman codes MSB first
+    class BitWriter {
+    public:
+        explicit BitWriter(std::string& target) : out(target) {}
+
+        void put(uint32_t value, int count) {
+            buffer |= static_cast<uint64_t>(value) << used;
+            used += count;
+            while (used >= 8) {
+                out += static_cast<char>(buffer & 0xff);
+                buffer >>= 8;
+                used -= 8;
+            }
+        }
+
+        void putCode(uint32_t code, int count) {
+            uint32_t reversed = 0;
+            for (int i = 0; i < count; i++) reversed |= ((code >> i) & 1) << (count - 1 - i);
+            put(reversed, count);
+        }
+
+        void finish() {
+            if (used > 0) out += static_cast<char>(buffer & 0xff);
+            buffer = 0;
+            used = 0;
+        }
+
+    private:
+        std::string& out;
+        uint64_t buffer = 0;
+        int used = 0;
+    };
+
+    static uint32_t hashAt(const uint8_t* p) {
+        return ((static_cast<uint32_t>(p[0]) << 16 | static_cast<uint32_t>(p[1]) << 8 | p[2]) * 2654435761u) >> 17;
+    }
+
+    // Fixed literal/length code for symbols 0-287 (RFC 1951 3.2.6)
+    static void putLiteral(BitWriter& bits, int symbol) {
+        if (symbol < 144) bits.putCode(0x30 + symbol, 8);
+        else if (symbol < 256) bits.putCode(0x190 + symbol - 144, 9);
+        else if (symbol < 280) bits.putCode(symbol - 256, 7);
+        else bits.putCode(0xC0 + symbol - 280, 8);
+    }
+
+    static void putLength(BitWriter& bits, int length) {
+        static const int base[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                      35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+        static const int extra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                       3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+        int code = 28;
+        while (base[code] > length) code--;
+        putLiteral(bits, 257 + code);
+        if (extra[code]) bits.put(length - base[code], extra[code]);
+    }
+
+    static void putDistance(BitWriter& bits, int distance) {
+        static const int base[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385,
+                                      513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+        static const int extra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7,
+                                       8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+        int code = 29;
+        while (base[code] > distance) code--;
+        bits.putCode(code, 5);
+        if (extra[code]) bits.put(distance - base[code], extra[code]);
+    }
+};
+
+// Asynchronous logger. A call only filters on level and copies a fixed-size
+// binary record (timestamp, level, format string, up to six arguments) into
+// a lock-free multi-producer ring; formatting, file writes, size rotation and
+// gzip compression of rotated files all happen on the writer thread. A full
+// ring drops the record and counts it rather than blocking the caller.
+//
+// Formats must be string literals: the pointer is the record's format id and
+// is dereferenced later on the writer thread. "{}" marks each argument.
+class AsyncLogger {
+public:
+    enum Level { LOG_DEBUG, LOG_INFO, LOG_WARN, LOG_ERROR, LOG_OFF };
+
+    static constexpr int kMaxArgs = 6;
+    static constexpr size_t kCapacity = 4096; // records; a power of two
+
+    AsyncLogger() : slots(new Slot[kCapacity]), steadyBase(steadyNanoseconds()),
+                    systemBase(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::system_clock::now().time_since_epoch()).count()) {
+        for (size_t i = 0; i < kCapacity; i++) slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    ~AsyncLogger() {
+        stop();
+    }
+
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    // Opens the log and starts the writer; records logged before this are kept
+    // and written first. maxBytes of 0 disables rotation.
+    void start(const std::string& logPath, Level level, size_t maxBytes, int keepFiles) {
+        if (writer.joinable()) return;
+        path = logPath;
+        rotateBytes = maxBytes;
+        keep = std::max(0, keepFiles);
+        setLevel(level);
+        openLog();
+        writer = std::thread(&AsyncLogger::writerLoop, this);
+    }
+
+    // Drains what is queued, then stops the writer
+    void stop() {
+        if (!writer.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        writer.join();
+        file.close();
+    }
+
+    void setLevel(Level level) { minLevel.store(level, std::memory_order_relaxed); }
+    bool enabled(Level level) const { return level >= minLevel.load(std::memory_order_relaxed); }
+
+    template <typename... Args>
+    void log(Level level, const char* format, const Args&... args) {
+        static_assert(sizeof...(Args) <= kMaxArgs, "too many log arguments");
+        if (!enabled(level)) return;
+
+        size_t position;
+        Slot* slot = claim(position);
+        if (!slot) return;
+
+        Record& record = slot->record;
+        record.timestamp = steadyNanoseconds();
+        record.format = format;
+        record.level = static_cast<uint8_t>(level);
+        record.argCount = 0;
+        record.textUsed = 0;
+        int expand[] = { 0, (encode(record, args), 0)... };
+        (void)expand;
+
+        slot->sequence.store(position + 1, std::memory_order_release);
+        if (!writerAwake.exchange(true, std::memory_order_acq_rel)) {
+            // First record since the writer went idle; the only path that takes a lock
+            { std::lock_guard<std::mutex> lock(wakeMutex); }
+            wake.notify_one();
+        }
+    }
+
+    // Blocks until every record logged so far has been written
+    void flush() {
+        size_t target = tail.load(std::memory_order_acquire);
+        while (written.load(std::memory_order_acquire) < target && writer.joinable()) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+
+    uint64_t getDropped() const { return dropped.load(std::memory_order_relaxed); }
+
+    static bool parseLevel(const std::string& name, Level& level) {
+        static const char* const names[] = { "debug", "info", "warn", "error", "off" };
+        for (int i = 0; i <= LOG_OFF; i++) {
+            if (name == names[i]) {
+                level = static_cast<Level>(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static const char* levelName(Level level) {
+        static const char* const names[] = { "debug", "info", "warn", "error", "off" };
+        return names[level];
+    }
+
+private:
+    enum ArgType : uint8_t { ARG_INT, ARG_UINT, ARG_DOUBLE, ARG_TEXT };
+    static constexpr size_t kTextBytes = 176;
+
+    // One cache-friendly 256-byte record; strings are copied into text
+    struct Record {
+        int64_t timestamp;
+        const char* format;
+        uint8_t level;
+        uint8_t argCount;
+        uint8_t textUsed;
+        ArgType types[kMaxArgs];
+        union Arg {
+            int64_t i;
+            uint64_t u;
+            double d;
+            struct { uint8_t offset, length; } text;
+        } args[kMaxArgs];
+        char text[kTextBytes];
+    };
+    static_assert(sizeof(Record) == 256, "AsyncLogger::Record should stay 256 bytes; resize kTextBytes");
+
+    struct alignas(64) Slot {
+        std::atomic<size_t> sequence;
+        Record record;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    alignas(64) std::atomic<size_t> tail{0};
+    alignas(64) std::atomic<size_t> written{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<int> minLevel{LOG_INFO};
+    std::atomic<bool> writerAwake{false};
+    size_t head = 0; // writer thread only
+
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::thread writer;
+
+    int64_t steadyBase, systemBase;
+    std::string path;
+    std::ofstream file;
+    size_t fileBytes = 0;
+    size_t rotateBytes = 0;
+    int keep = 0;
+    uint64_t reportedDrops = 0;
+
+    static int64_t steadyNanoseconds() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Bounded MPMC sequence protocol (Vyukov); only this side has several threads
+    Slot* claim(size_t& position) {
+        position = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots[position & (kCapacity - 1)];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (difference == 0) {
+                if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) return &slot;
+            } else if (difference < 0) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            } else {
+                position = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    template <typename T>
+    static typename std::enable_if<std::is_integral<T>::value>::type encode(Record& record, T value) {
+        Record::Arg& arg = record.args[record.argCount];
+        if (std::is_signed<T>::value) {
+            arg.i = static_cast<int64_t>(value);
+            record.types[record.argCount++] = ARG_INT;
+        } else {
+            arg.u = static_cast<uint64_t>(value);
+            record.types[record.argCount++] = ARG_UINT;
+        }
+    }
+
+    static void encode(Record& record, double value) {
+        record.args[record.argCount].d = value;
+        record.types[record.argCount++] = ARG_DOUBLE;
+    }
+
+    static void encode(Record& record, std::string_view value) {
+        size_t length = std::min(value.size(), kTextBytes - record.textUsed);
+        memcpy(record.text + record.textUsed, value.data(), length);
+        record.args[record.argCount].text = { record.textUsed, static_cast<uint8_t>(length) };
+        record.types[record.argCount++] = ARG_TEXT;
+        record.textUsed = static_cast<uint8_t>(record.textUsed + length);
+    }
+
+    static void encode(Record& record, const char* value) { encode(record, std::string_view(value ? value : "")); }
+    static void encode(Record& record, const std::string& value) { encode(record, std::string_view(value)); }
+    static void encode(Record& record, float value) { encode(record, static_cast<double>(value)); }
+
+    void writerLoop() {
+        for (;;) {
+            if (drain() > 0) continue;
+
+            // Going idle: producers that see the flag clear will wake us
+            writerAwake.store(false, std::memory_order_seq_cst);
+            if (hasRecord()) {
+                writerAwake.store(true, std::memory_order_relaxed);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wake.wait(lock, [this] { return stopping || writerAwake.load(std::memory_order_acquire); });
+            if (stopping) {
+                lock.unlock();
+                drain();
+                return;
+            }
+        }
+    }
+
+    bool hasRecord() const {
+        return slots[head & (kCapacity - 1)].sequence.load(std::memory_order_acquire) == head + 1;
+    }
+
+    // Formats and writes everything queued; returns the record count
+    size_t drain() {
+        size_t count = 0;
+        std::string lines;
+        while (hasRecord()) {
+            Slot& slot = slots[head & (kCapacity - 1)];
+            formatRecord(slot.record, lines);
+            slot.sequence.store(head + kCapacity, std::memory_order_release);
+            head++;
+            count++;
+
+            if (lines.size() >= 64 * 1024) write(lines);
+        }
+
+        uint64_t drops = dropped.load(std::memory_order_relaxed);
+        if (drops != reportedDrops) {
+            Record notice = {};
+            notice.timestamp = steadyNanoseconds();
+            notice.format = "{} log record(s) dropped, ring full";
+            notice.level = LOG_WARN;
+            encode(notice, drops - reportedDrops);
+            formatRecord(notice, lines);
+            reportedDrops = drops;
+        }
+        write(lines);
+        written.store(head, std::memory_order_release);
+        return count;
+    }
+
+    void formatRecord(const Record& record, std::string& out) const {
+        time_t seconds = static_cast<time_t>((record.timestamp - steadyBase + systemBase) / 1000000000);
+        int milliseconds = static_cast<int>(((record.timestamp - steadyBase + systemBase) / 1000000) % 1000);
+        // Reentrant conversion into a local tm; localtime()'s shared buffer
+        // would race with main-thread callers
+        tm local = {};
+#ifdef _WIN32
+        localtime_s(&local, &seconds);
+#else
+        localtime_r(&seconds, &local);
+#endif
+        char stamp[48];
+        size_t length = strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &local);
+        length += snprintf(stamp + length, sizeof(stamp) - length, ".%03d [%s] ", milliseconds,
+                           levelName(static_cast<Level>(record.level)));
+        out.append(stamp, length);
+
+        int next = 0;
+        for (const char* p = record.format; *p; p++) {
+            if (p[0] == '{' && p[1] == '}' && next < record.argCount) {
+                appendArg(record, next++, out);
+                p++;
+            } else {
+                out += *p;
+            }
+        }
+        out += '\n';
+    }
+
+    static void appendArg(const Record& record, int index, std::string& out) {
+        const Record::Arg& arg = record.args[index];
+        char number[32];
+        switch (record.types[index]) {
+            case ARG_INT: out.append(number, snprintf(number, sizeof(number), "%lld", static_cast<long long>(arg.i))); break;
+            case ARG_UINT: out.append(number, snprintf(number, sizeof(number), "%llu", static_cast<unsigned long long>(arg.u))); break;
+            case ARG_DOUBLE: out.append(number, snprintf(number, sizeof(number), "%g", arg.d)); break;
+            case ARG_TEXT: out.append(record.text + arg.text.offset, arg.text.length); break;
+        }
+    }
+
+    void write(std::string& lines) {
+        if (lines.empty()) return;
+        if (file.is_open()) {
+            file.write(lines.data(), lines.size());
+            file.flush();
+            fileBytes += lines.size();
+        }
+        lines.clear();
+        if (rotateBytes > 0 && fileBytes >= rotateBytes) rotate();
+    }
+
+    std::string rotatedPath(int index) const {
+        std::string base = path.size() > 4 && path.compare(path.size() - 4, 4, ".txt") == 0
+            ? path.substr(0, path.size() - 4) : path;
+        return base + "." + std::to_string(index) + ".gz";
+    }
+
+    void openLog() {
+        file.open(path, std::ios::binary | std::ios::app);
+        file.seekp(0, std::ios::end);
+        fileBytes = file.is_open() ? static_cast<size_t>(file.tellp()) : 0;
+    }
+
+    // std::rename will not overwrite an existing file on Windows
+    static void replaceFile(const std::string& from, const std::string& to) {
+        std::remove(to.c_str());
+        std::rename(from.c_str(), to.c_str());
+    }
+
+    // Compresses the full log into <name>.1.gz, shifting older archives up
+    // and deleting any beyond keep, then starts an empty log
+    void rotate() {
+        file.close();
+
+        if (keep > 0) {
+            std::string contents;
+            {
+                std::ifstream in(path, std::ios::binary);
+                contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+            }
+            std::remove(rotatedPath(keep).c_str());
+            for (int index = keep - 1; index >= 1; index--) {
+                replaceFile(rotatedPath(index), rotatedPath(index + 1));
+            }
+
+            std::string tempPath = rotatedPath(1) + ".tmp";
+            std::string compressed = GzipEncoder::compress(contents.data(), contents.size());
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            out.write(compressed.data(), compressed.size());
+            out.close();
+            if (out) replaceFile(tempPath, rotatedPath(1));
+        }
+
+        file.open(path, std::ios::binary | std::ios::trunc);
+        fileBytes = 0;
+    }
+};
+
+#endif // TIMEWALLPAPER_CORE_H
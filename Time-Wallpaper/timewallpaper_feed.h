@@ -0,0 +1,161 @@
+/*
+ * timewallpaper_feed.h - read TimeWallpaper's live color from shared memory.
+ *
+ * While running, TimeWallpaper publishes the current color and period, the
+ * next keyframe and today's solar times into a named file mapping. Updates
+ * use a sequence lock: the writer makes the sequence odd, writes, then makes
+ * it even again, and a reader retries whenever the sequence was odd or
+ * changed while it copied. Reads take no locks and make no system calls.
+ *
+ *     const twf_feed* feed = twf_open();   // once; NULL if not running
+ *     twf_snapshot now;
+ *     if (feed && twf_read(feed, &now, 100)) {
+ *         unsigned r = now.color & 0xFF, g = (now.color >> 8) & 0xFF, b = (now.color >> 16) & 0xFF;
+ *         ...
+ *     }
+ *
+ * Plain C99; builds with GCC, Clang and MSVC. twf_open/twf_close are
+ * Windows-only, the rest is portable.
+ */
+#ifndef TIMEWALLPAPER_FEED_H
+#define TIMEWALLPAPER_FEED_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TWF_MAPPING_NAME "Local\\TimeWallpaperColorFeed"
+#define TWF_MAGIC 0x46435754u /* "TWCF" */
+#define TWF_VERSION 1u
+#define TWF_NAME_SIZE 32
+
+/* Colors are RGBA bytes packed little-endian: red in the low byte. */
+typedef struct twf_snapshot {
+    int64_t updated_unix;          /* UTC seconds when this was published */
+    uint32_t color;                /* current color */
+    uint32_t next_color;           /* color at the next keyframe */
+    double local_hour;             /* local time of day of the current color, 0-24 */
+    double next_keyframe_hour;     /* local hour of the next keyframe, 0-24 */
+    double sunrise_hour;           /* today's solar times, local hours */
+    double sunset_hour;
+    double solar_noon_hour;
+    double civil_twilight_begin;
+    double civil_twilight_end;
+    char period[TWF_NAME_SIZE];      /* NUL-terminated */
+    char next_period[TWF_NAME_SIZE]; /* period starting at the next keyframe */
+} twf_snapshot;
+
+typedef struct twf_feed {
+    uint32_t magic;    /* TWF_MAGIC once the writer has initialized the feed */
+    uint32_t version;  /* TWF_VERSION */
+    uint32_t size;     /* sizeof(twf_feed) */
+    uint32_t sequence; /* odd while an update is in progress */
+    twf_snapshot data;
+} twf_feed;
+
+/* Payload is copied as 32-bit words */
+typedef char twf_snapshot_size_check[(sizeof(twf_snapshot) % 4 == 0) ? 1 : -1];
+
+#if defined(__GNUC__) || defined(__clang__)
+#define TWF_LOAD_ACQUIRE(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define TWF_LOAD_RELAXED(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define TWF_STORE_RELEASE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define TWF_STORE_RELAXED(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#define TWF_FENCE_ACQUIRE() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define TWF_FENCE_RELEASE() __atomic_thread_fence(__ATOMIC_RELEASE)
+#define TWF_PAUSE() ((void)0)
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+/* x86 keeps loads and stores in order; only the compiler must be held back */
+#include <intrin.h>
+#define TWF_LOAD_ACQUIRE(p) (_ReadWriteBarrier(), *(volatile const uint32_t*)(p))
+#define TWF_LOAD_RELAXED(p) (*(volatile const uint32_t*)(p))
+#define TWF_STORE_RELEASE(p, v) (_ReadWriteBarrier(), *(volatile uint32_t*)(p) = (v))
+#define TWF_STORE_RELAXED(p, v) (*(volatile uint32_t*)(p) = (v))
+#define TWF_FENCE_ACQUIRE() _ReadWriteBarrier()
+#define TWF_FENCE_RELEASE() _ReadWriteBarrier()
+#define TWF_PAUSE() _mm_pause()
+#else
+#error "timewallpaper_feed.h needs GCC/Clang atomics or MSVC on x86"
+#endif
+
+/*
+ * Copies a consistent snapshot into *out. Returns 1 on success, or 0 if the
+ * feed is not initialized or was mid-update on every one of max_attempts
+ * tries (updates take well under a microsecond).
+ */
+static inline int twf_read(const twf_feed* feed, twf_snapshot* out, int max_attempts)
+{
+    int attempt;
+    if (TWF_LOAD_ACQUIRE(&feed->magic) != TWF_MAGIC || feed->version != TWF_VERSION) return 0;
+
+    for (attempt = 0; attempt < max_attempts; attempt++) {
+        const uint32_t* src = (const uint32_t*)&feed->data;
+        uint32_t words[sizeof(twf_snapshot) / 4];
+        size_t i;
+        uint32_t begin = TWF_LOAD_ACQUIRE(&feed->sequence);
+        if (begin & 1u) {
+            TWF_PAUSE();
+            continue;
+        }
+        for (i = 0; i < sizeof(words) / 4; i++) words[i] = TWF_LOAD_RELAXED(&src[i]);
+        TWF_FENCE_ACQUIRE();
+        if (TWF_LOAD_RELAXED(&feed->sequence) == begin) {
+            memcpy(out, words, sizeof(words));
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Writer side, used by TimeWallpaper. There must be a single writer. */
+static inline void twf_init(twf_feed* feed)
+{
+    memset(feed, 0, sizeof(*feed));
+    feed->version = TWF_VERSION;
+    feed->size = (uint32_t)sizeof(twf_feed);
+    TWF_STORE_RELEASE(&feed->magic, TWF_MAGIC);
+}
+
+static inline void twf_publish(twf_feed* feed, const twf_snapshot* in)
+{
+    uint32_t* dst = (uint32_t*)&feed->data;
+    uint32_t words[sizeof(twf_snapshot) / 4];
+    size_t i;
+    uint32_t sequence = TWF_LOAD_RELAXED(&feed->sequence);
+
+    memcpy(words, in, sizeof(words));
+    TWF_STORE_RELAXED(&feed->sequence, sequence + 1u);
+    TWF_FENCE_RELEASE();
+    for (i = 0; i < sizeof(words) / 4; i++) TWF_STORE_RELAXED(&dst[i], words[i]);
+    TWF_STORE_RELEASE(&feed->sequence, sequence + 2u);
+}
+
+#ifdef _WIN32
+#include <windows.h>
+
+/* Maps the running instance's feed read-only; NULL if it is not running */
+static inline const twf_feed* twf_open(void)
+{
+    const twf_feed* feed;
+    HANDLE mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, TWF_MAPPING_NAME);
+    if (!mapping) return NULL;
+    feed = (const twf_feed*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, sizeof(twf_feed));
+    CloseHandle(mapping); /* the view keeps the section alive */
+    return feed;
+}
+
+static inline void twf_close(const twf_feed* feed)
+{
+    if (feed) UnmapViewOfFile((LPCVOID)feed);
+}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIMEWALLPAPER_FEED_H */
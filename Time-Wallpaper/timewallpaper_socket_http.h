@@ -0,0 +1,226 @@
+// timewallpaper_socket_http.h - HttpClient over POSIX sockets for the
+// portable build: plain http:// only, HTTP/1.1 keep-alive with a pool of
+// idle connections per host. main.cpp uses WinInetHttpClient instead.
+#ifndef TIMEWALLPAPER_SOCKET_HTTP_H
+#define TIMEWALLPAPER_SOCKET_HTTP_H
+
+#include "timewallpaper_core.h"
+
+#include <cctype>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Connections are checked out for one request at a time, so concurrent
+// requests to one host open as many connections as there are requests in
+// flight, and later requests reuse them. A pooled connection the server has
+// since closed is replaced once, transparently.
+class SocketHttpClient : public HttpClient {
+public:
+    explicit SocketHttpClient(int defaultTimeoutMs = 5000) : defaultTimeout(defaultTimeoutMs) {}
+
+    ~SocketHttpClient() override {
+        for (auto& entry : idle) {
+            for (int fd : entry.second) close(fd);
+        }
+    }
+
+    SocketHttpClient(const SocketHttpClient&) = delete;
+    SocketHttpClient& operator=(const SocketHttpClient&) = delete;
+
+    std::string get(const std::string& url, int timeoutMs) override {
+        std::string host, path;
+        unsigned short port;
+        bool secure;
+        if (!splitHttpUrl(url, secure, host, port, path) || secure) return "";
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs > 0 ? timeoutMs : defaultTimeout);
+        std::string key = host + ":" + std::to_string(port);
+        requestCount++;
+
+        for (int attempt = 0; attempt < 2; attempt++) {
+            bool reused = false;
+            int fd = checkout(key, host, port, deadline, reused);
+            if (fd < 0) return "";
+
+            Response response;
+            Outcome outcome = exchange(fd, host, path, deadline, response);
+            if (outcome == Outcome::Complete) {
+                if (response.keepAlive) checkin(key, fd);
+                else close(fd);
+                return response.status == 200 ? response.body : "";
+            }
+            close(fd);
+            // Only a reused connection that closed before answering is retried
+            if (!reused || outcome != Outcome::ClosedEarly) return "";
+        }
+        return "";
+    }
+
+    Stats getStats() const override {
+        Stats stats;
+        stats.requests = requestCount.load();
+        stats.connectionsOpened = connectionCount.load();
+        return stats;
+    }
+
+private:
+    enum class Outcome { Complete, ClosedEarly, Failed };
+
+    struct Response {
+        int status = 0;
+        bool keepAlive = false;
+        std::string body;
+    };
+
+    typedef std::chrono::steady_clock::time_point TimePoint;
+
+    int defaultTimeout;
+    std::mutex mutex;
+    std::map<std::string, std::vector<int>> idle; // "host:port"
+    std::atomic<long> requestCount{0};
+    std::atomic<long> connectionCount{0};
+
+    static int remainingMs(TimePoint deadline) {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        return static_cast<int>(std::max<long long>(0, remaining.count()));
+    }
+
+    static bool waitFor(int fd, short events, TimePoint deadline) {
+        pollfd waiting{ fd, events, 0 };
+        return poll(&waiting, 1, remainingMs(deadline)) > 0;
+    }
+
+    int checkout(const std::string& key, const std::string& host, unsigned short port, TimePoint deadline, bool& reused) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::vector<int>& pooled = idle[key];
+            if (!pooled.empty()) {
+                int fd = pooled.back();
+                pooled.pop_back();
+                reused = true;
+                return fd;
+            }
+        }
+        reused = false;
+        int fd = connectTo(host, port, deadline);
+        if (fd >= 0) connectionCount++;
+        return fd;
+    }
+
+    void checkin(const std::string& key, int fd) {
+        std::lock_guard<std::mutex> lock(mutex);
+        idle[key].push_back(fd);
+    }
+
+    // Non-blocking connect so the deadline also bounds the handshake
+    static int connectTo(const std::string& host, unsigned short port, TimePoint deadline) {
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* addresses = nullptr;
+        if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0) return -1;
+
+        int connected = -1;
+        for (addrinfo* address = addresses; address && connected < 0; address = address->ai_next) {
+            int fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+            if (fd < 0) continue;
+            int flags = fcntl(fd, F_GETFL, 0);
+            fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+
+            int error = 0;
+            socklen_t errorSize = sizeof(error);
+            if (connect(fd, address->ai_addr, address->ai_addrlen) == 0
+                || (errno == EINPROGRESS && waitFor(fd, POLLOUT, deadline)
+                    && getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &errorSize) == 0 && error == 0)) {
+                fcntl(fd, F_SETFL, flags);
+                connected = fd;
+            } else {
+                close(fd);
+            }
+        }
+        freeaddrinfo(addresses);
+        return connected;
+    }
+
+    // Reads at least one more byte into buffer; false on timeout, or on EOF
+    // or a reset with closed set
+    static bool readMore(int fd, std::string& buffer, TimePoint deadline, bool& closed) {
+        char chunk[4096];
+        if (!waitFor(fd, POLLIN, deadline)) return false;
+        ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+        if (received <= 0) {
+            closed = true;
+            return false;
+        }
+        buffer.append(chunk, static_cast<size_t>(received));
+        return true;
+    }
+
+    static std::string headerValue(const std::string& head, const char* name) {
+        std::string lower = head;
+        std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        size_t at = lower.find(std::string("\r\n") + name + ":");
+        if (at == std::string::npos) return "";
+        size_t start = lower.find_first_not_of(' ', at + 3 + std::strlen(name));
+        if (start == std::string::npos) return "";
+        size_t end = lower.find("\r\n", start);
+        return lower.substr(start, end - start);
+    }
+
+    static Outcome exchange(int fd, const std::string& host, const std::string& path, TimePoint deadline, Response& response) {
+        std::string request = "GET " + path + " HTTP/1.1\r\nHost: " + host + "\r\nUser-Agent: TimeWallpaper/2.0\r\n\r\n";
+        if (send(fd, request.data(), request.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(request.size())) return Outcome::ClosedEarly;
+
+        std::string buffer;
+        bool closed = false;
+        size_t headerEnd;
+        while ((headerEnd = buffer.find("\r\n\r\n")) == std::string::npos) {
+            if (!readMore(fd, buffer, deadline, closed)) return closed && buffer.empty() ? Outcome::ClosedEarly : Outcome::Failed;
+        }
+        std::string head = buffer.substr(0, headerEnd);
+        buffer.erase(0, headerEnd + 4);
+
+        if (head.compare(0, 5, "HTTP/") != 0 || head.size() < 12) return Outcome::Failed;
+        response.status = std::atoi(head.c_str() + 9);
+        bool http11 = head.compare(0, 8, "HTTP/1.1") == 0;
+        std::string connection = headerValue(head, "connection");
+        std::string length = headerValue(head, "content-length");
+        bool chunked = headerValue(head, "transfer-encoding").find("chunked") != std::string::npos;
+        response.keepAlive = http11 && connection != "close" && (chunked || !length.empty());
+
+        if (chunked) {
+            for (;;) {
+                size_t lineEnd;
+                while ((lineEnd = buffer.find("\r\n")) == std::string::npos) {
+                    if (!readMore(fd, buffer, deadline, closed)) return Outcome::Failed;
+                }
+                size_t size = std::strtoul(buffer.c_str(), nullptr, 16);
+                while (buffer.size() < lineEnd + 2 + size + 2) {
+                    if (!readMore(fd, buffer, deadline, closed)) return Outcome::Failed;
+                }
+                response.body.append(buffer, lineEnd + 2, size);
+                buffer.erase(0, lineEnd + 2 + size + 2);
+                if (size == 0) break; // no trailers expected
+            }
+        } else if (!length.empty()) {
+            size_t size = std::strtoul(length.c_str(), nullptr, 10);
+            while (buffer.size() < size) {
+                if (!readMore(fd, buffer, deadline, closed)) return Outcome::Failed;
+            }
+            response.body = buffer.substr(0, size);
+        } else {
+            // Body runs to the end of the connection
+            while (readMore(fd, buffer, deadline, closed)) {}
+            if (!closed) return Outcome::Failed;
+            response.body = buffer;
+        }
+        return Outcome::Complete;
+    }
+};
+
+#endif // TIMEWALLPAPER_SOCKET_HTTP_H